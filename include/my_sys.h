@@ -768,6 +768,13 @@ extern int init_io_cache_ex(IO_CACHE *info,File file,size_t cachesize,
        enum cache_type type,my_off_t seek_offset,
        pbool use_async_io, myf cache_myflags, my_bool compressed);
 extern int end_io_cache_compressor(IO_CACHE *info);
+extern long io_cache_compression_level;
+extern uint io_cache_compression_workers;
+extern int64 io_cache_compression_bytes_in;
+extern int64 io_cache_compression_bytes_out;
+extern int64 io_cache_compression_usecs;
+extern int io_cache_compression_load_dictionary(const char *path);
+extern void io_cache_compression_free_dictionary(void);
 extern my_bool reinit_io_cache(IO_CACHE *info,enum cache_type type,
 			       my_off_t seek_offset,pbool use_async_io,
 			       pbool clear_cache);
@@ -898,6 +905,9 @@ extern int unpackfrm(uchar **, size_t *, const uchar *);
 
 extern ha_checksum my_checksum(ha_checksum crc, const uchar *mem,
                                size_t count);
+extern ha_checksum my_checksum_combine_op(size_t length);
+extern ha_checksum my_checksum_combine(ha_checksum crc1, ha_checksum crc2,
+                                       ha_checksum op);
 extern void my_sleep(ulong m_seconds);
 extern ulong crc32(ulong crc, const uchar *buf, uint len);
 extern uint my_set_max_open_files(uint files);
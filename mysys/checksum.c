@@ -33,3 +33,76 @@ ha_checksum my_checksum(ha_checksum crc, const uchar *pos, size_t length)
   return (ha_checksum)crc32((uint)crc, pos, (uint)length);
 }
 
+
+
+/*
+  CRC-32 polynomial arithmetic used to combine checksums, as in zlib's
+  crc32_combine_gen()/crc32_combine_op(). Polynomials are bit-reflected,
+  x^0 is the top bit.
+*/
+#define CRC32_POLY 0xedb88320
+
+/* Multiply a by b modulo the CRC-32 polynomial, a must not be 0 */
+static ha_checksum crc32_multmodp(ha_checksum a, ha_checksum b)
+{
+  ha_checksum m= (ha_checksum) 1 << 31;
+  ha_checksum p= 0;
+  for (;;)
+  {
+    if (a & m)
+    {
+      p^= b;
+      if ((a & (m - 1)) == 0)
+        break;
+    }
+    m>>= 1;
+    b= b & 1 ? (b >> 1) ^ CRC32_POLY : b >> 1;
+  }
+  return p;
+}
+
+/*
+  Get the operator that appends length bytes to a checksum.
+
+  SYNOPSIS
+    my_checksum_combine_op()
+      length    length of the second block
+
+  DESCRIPTION
+    The operator is x^(8 * length) modulo the CRC-32 polynomial. It
+    only depends on the length, so it can be computed ahead of
+    my_checksum_combine() and reused for blocks of the same length.
+*/
+
+ha_checksum my_checksum_combine_op(size_t length)
+{
+  ha_checksum p= (ha_checksum) 1 << 31;    /* x^0 */
+  ha_checksum x2n= (ha_checksum) 1 << 23;  /* x^8, a byte */
+  while (length)
+  {
+    if (length & 1)
+      p= crc32_multmodp(x2n, p);
+    length>>= 1;
+    x2n= crc32_multmodp(x2n, x2n);
+  }
+  return p;
+}
+
+/*
+  Combine the checksums of two consecutive memory blocks.
+
+  SYNOPSIS
+    my_checksum_combine()
+      crc1      my_checksum() of the first block
+      crc2      my_checksum(0, ...) of the second block
+      op        my_checksum_combine_op() of the second block's length
+
+  RETURN
+    The checksum of both blocks, as if computed by one my_checksum() call.
+*/
+
+ha_checksum my_checksum_combine(ha_checksum crc1, ha_checksum crc2,
+                                ha_checksum op)
+{
+  return crc32_multmodp(op, crc1) ^ crc2;
+}
@@ -16,9 +16,24 @@
 */
 
 #include <mysys_priv.h>
+#include <my_atomic.h>
 #include <zstd.h>
 
-static const int compression_level = 3; // ZSTD_CLEVEL_DEFAULT;
+/* Settings read when a compressed IO_CACHE is opened */
+long io_cache_compression_level = ZSTD_CLEVEL_DEFAULT;
+uint io_cache_compression_workers = 0;
+
+/* Throughput counters of all compressed IO_CACHEs */
+int64 io_cache_compression_bytes_in = 0;
+int64 io_cache_compression_bytes_out = 0;
+int64 io_cache_compression_usecs = 0;
+
+/*
+  Optional zstd dictionary, loaded once at startup and used by both
+  compressors and decompressors.
+*/
+static uchar *compression_dict = NULL;
+static size_t compression_dict_size = 0;
 
 typedef struct compressor {
   uchar *zstd_in_buf;
@@ -72,6 +87,40 @@ static int destroy_decompressor_and_set_error(IO_CACHE *c, decompressor *d) {
   return 1;
 }
 
+int io_cache_compression_load_dictionary(const char *path) {
+  File file;
+  MY_STAT stat_info;
+  uchar *dict;
+
+  if ((file = my_open(path, O_RDONLY | O_SHARE, MYF(MY_WME))) < 0)
+    return 1;
+  if (!my_fstat(file, &stat_info, MYF(MY_WME)) && stat_info.st_size > 0 &&
+      (dict = (uchar *)my_malloc(stat_info.st_size, MYF(MY_WME)))) {
+    if (my_read(file, dict, stat_info.st_size, MYF(MY_NABP | MY_WME))) {
+      my_free(dict);
+    } else {
+      io_cache_compression_free_dictionary();
+      compression_dict = dict;
+      compression_dict_size = stat_info.st_size;
+    }
+  }
+  my_close(file, MYF(0));
+  return compression_dict == NULL;
+}
+
+void io_cache_compression_free_dictionary(void) {
+  my_free(compression_dict);
+  compression_dict = NULL;
+  compression_dict_size = 0;
+}
+
+static void update_compression_stats(size_t bytes_in, size_t bytes_out,
+                                     ulonglong usecs) {
+  my_atomic_add64(&io_cache_compression_bytes_in, (int64)bytes_in);
+  my_atomic_add64(&io_cache_compression_bytes_out, (int64)bytes_out);
+  my_atomic_add64(&io_cache_compression_usecs, (int64)usecs);
+}
+
 static int init_io_cache_compressor(IO_CACHE *info) {
   compressor *c =
       (compressor *)my_malloc(sizeof(compressor), MYF(MY_WME | MY_ZEROFILL));
@@ -90,10 +139,25 @@ static int init_io_cache_compressor(IO_CACHE *info) {
   if (!c->cstream)
     return destroy_compressor_and_set_error(info, c);
 
-  size_t zrc = ZSTD_initCStream(c->cstream, compression_level);
+  size_t zrc = ZSTD_CCtx_setParameter(c->cstream, ZSTD_c_compressionLevel,
+                                      (int)io_cache_compression_level);
   if (ZSTD_isError(zrc))
     return destroy_compressor_and_set_error(info, c);
 
+  // With workers, input is cut into jobs compressed in parallel and written
+  // in order as one frame. This fails when zstd was built without
+  // multithreading support; the stream is then compressed inline.
+  if (io_cache_compression_workers)
+    ZSTD_CCtx_setParameter(c->cstream, ZSTD_c_nbWorkers,
+                           (int)io_cache_compression_workers);
+
+  if (compression_dict) {
+    zrc = ZSTD_CCtx_loadDictionary(c->cstream, compression_dict,
+                                   compression_dict_size);
+    if (ZSTD_isError(zrc))
+      return destroy_compressor_and_set_error(info, c);
+  }
+
   info->compressor = c;
   return 0;
 }
@@ -112,14 +176,25 @@ static int flush_compressor(IO_CACHE *info) {
   compressor *c = info->compressor;
   uchar *zstd_out_buf = c->zstd_out_buf;
   size_t zstd_out_buf_size = c->zstd_out_buf_size;
-  ZSTD_outBuffer output = {zstd_out_buf, zstd_out_buf_size, 0};
-  size_t zrc = ZSTD_endStream(c->cstream, &output);
-  if (zrc) {
-    info->error = -1;
-    return 1;
-  }
-  if (write_compressed_data(info, zstd_out_buf, output.pos))
-    return 1;
+  ZSTD_inBuffer input = {NULL, 0, 0};
+  ulonglong start = my_micro_time();
+  size_t bytes_out = 0;
+  size_t remaining;
+
+  // ZSTD_e_end waits for the workers and returns how much is left to flush
+  do {
+    ZSTD_outBuffer output = {zstd_out_buf, zstd_out_buf_size, 0};
+    remaining = ZSTD_compressStream2(c->cstream, &output, &input, ZSTD_e_end);
+    if (ZSTD_isError(remaining)) {
+      info->error = -1;
+      return 1;
+    }
+    if (write_compressed_data(info, zstd_out_buf, output.pos))
+      return 1;
+    bytes_out += output.pos;
+  } while (remaining);
+
+  update_compression_stats(0, bytes_out, my_micro_time() - start);
   return 0;
 }
 
@@ -130,17 +205,24 @@ static int compress_write_buffer(IO_CACHE *info,
   uchar *zstd_out_buf = c->zstd_out_buf;
   size_t zstd_out_buf_size = c->zstd_out_buf_size;
 
+  ulonglong start = my_micro_time();
+  size_t bytes_out = 0;
+
   ZSTD_inBuffer input = {buf, buflen, 0};
   while (input.pos < input.size) {
     ZSTD_outBuffer output = {zstd_out_buf, zstd_out_buf_size, 0};
-    size_t zrc = ZSTD_compressStream(cstream, &output, &input);
+    size_t zrc = ZSTD_compressStream2(cstream, &output, &input,
+                                      ZSTD_e_continue);
     if (ZSTD_isError(zrc)) {
       info->error = -1;
       return 1;
     }
     if (write_compressed_data(info, zstd_out_buf, output.pos))
       return 1;
+    bytes_out += output.pos;
   }
+
+  update_compression_stats(buflen, bytes_out, my_micro_time() - start);
   return 0;
 }
 
@@ -256,6 +338,14 @@ static int init_io_cache_decompressor(IO_CACHE *info) {
     destroy_decompressor_and_set_error(info, d);
     return 1;
   }
+  if (compression_dict) {
+    zrc = ZSTD_DCtx_loadDictionary(d->dstream, compression_dict,
+                                   compression_dict_size);
+    if (ZSTD_isError(zrc)) {
+      destroy_decompressor_and_set_error(info, d);
+      return 1;
+    }
+  }
   d->zstd_out_buf_size = ZSTD_DStreamOutSize();
   d->zstd_out_buf = (uchar *)my_malloc(d->zstd_out_buf_size, MYF(MY_WME));
   if (!d->zstd_out_buf) {
@@ -91,6 +91,7 @@ static int limit_unsafe_warning_count= 0;
 static handlerton *binlog_hton;
 bool opt_binlog_order_commits= true;
 bool opt_gtid_precommit= false;
+bool opt_binlog_pipelined_flush= false;
 
 const char *log_bin_index= 0;
 const char *log_bin_basename= 0;
@@ -102,6 +103,8 @@ latency_histogram histogram_raft_trx_wait;
 counter_histogram histogram_binlog_group_commit;
 latency_histogram histogram_binlog_group_commit_trx;
 latency_histogram histogram_binlog_engine_commit_trx;
+latency_histogram histogram_binlog_flush_stage;
+latency_histogram histogram_binlog_sync_stage;
 char* opt_histogram_binlog_commit_time_step_size = NULL;
 
 extern my_bool opt_core_file;
@@ -373,6 +376,7 @@ public:
   }
 
   int finalize(THD *thd, Log_event *end_event);
+  void prepare_for_flush();
   int flush(THD *thd, my_off_t *bytes, bool *wrote_xid, bool async);
   int write_event(THD *thd, Log_event *event,
                   bool write_meta_data_event= false);
@@ -560,6 +564,28 @@ public:
   */
   Group_cache group_cache;
 
+  /**
+    Checksum of an event in the cache, excluding its common header.
+  */
+  struct Prepared_event
+  {
+    ha_checksum body_crc;
+    /* my_checksum_combine_op() of the length of the checksummed part */
+    ha_checksum combine_op;
+  };
+
+  /**
+    Events of the cache checksummed by prepare_for_flush(). Empty when
+    the flush stage leader has to checksum the cache itself.
+  */
+  std::vector<Prepared_event> prepared_events;
+
+  /**
+    Size of the head of the cache rewritten with the GTID and HLC of the
+    transaction in the flush stage, after prepare_for_flush().
+  */
+  my_off_t rewritten_head;
+
 protected:
   /*
     It truncates the cache to a certain position. This includes deleting the
@@ -569,6 +595,8 @@ protected:
   {
     DBUG_PRINT("info", ("truncating to position %lu", (ulong) pos));
     remove_pending_event();
+    prepared_events.clear();
+    rewritten_head= 0;
     /*
       Whenever there is an error while flushing cache to file,
       the local cache will not be in a normal state and the same
@@ -858,6 +886,15 @@ public:
   }
 #endif
 
+  /**
+    Convenience method to prepare both caches for the flush stage.
+  */
+  void prepare_for_flush()
+  {
+    stmt_cache.prepare_for_flush();
+    trx_cache.prepare_for_flush();
+  }
+
   /*
     Convenience method to flush both caches to the binary log.
 
@@ -1030,6 +1067,10 @@ static int binlog_init(void *p)
                          opt_histogram_binlog_commit_time_step_size);
   latency_histogram_init(&histogram_binlog_engine_commit_trx,
                          opt_histogram_binlog_commit_time_step_size);
+  latency_histogram_init(&histogram_binlog_flush_stage,
+                         opt_histogram_binlog_commit_time_step_size);
+  latency_histogram_init(&histogram_binlog_sync_stage,
+                         opt_histogram_binlog_commit_time_step_size);
 
   counter_histogram_init(&histogram_binlog_group_commit,
                          opt_histogram_step_size_binlog_group_commit);
@@ -1398,6 +1439,7 @@ gtid_before_write_cache(THD* thd, binlog_cache_data* cache_data)
       /* Update commit time HLC timestamp for this trx */
       hlc_before_write_cache(thd, cache_data);
 
+      cache_data->rewritten_head= cache_data->get_byte_position();
       cache_data->reset_write_pos(saved_position, using_file);
     }
 
@@ -1497,6 +1539,62 @@ binlog_cache_data::finalize(THD *thd, Log_event *end_event)
   DBUG_RETURN(0);
 }
 
+/**
+  Checksum the events of a finalized cache before entering the flush
+  stage.
+
+  The checksum of an event covers its end_log_pos, which is only known
+  when the flush stage leader appends the cache to the binary log. The
+  session checksums each event without its common header instead, and
+  the leader combines that with the checksum of the fixed header, see
+  MYSQL_BIN_LOG::do_write_prepared_cache().
+
+  Only caches held in memory are prepared, the leader reads the ones
+  swapped to a file.
+
+  @see binlog_cache_data::finalize
+ */
+void
+binlog_cache_data::prepare_for_flush()
+{
+  DBUG_ENTER("binlog_cache_data::prepare_for_flush");
+  prepared_events.clear();
+  rewritten_head= 0;
+
+  if (!flags.finalized || cache_log.type != WRITE_CACHE ||
+      cache_log.pos_in_file > 0 ||
+      binlog_checksum_options != BINLOG_CHECKSUM_ALG_CRC32 ||
+      DBUG_EVALUATE_IF("fault_injection_crc_value", 1, 0))
+    DBUG_VOID_RETURN;
+
+  const uchar *buf= cache_log.write_buffer;
+  my_off_t length= get_byte_position();
+  my_off_t pos= 0;
+  while (pos < length)
+  {
+    if (pos + LOG_EVENT_HEADER_LEN > length)
+      break;
+    uint32 event_len= uint4korr(buf + pos + EVENT_LEN_OFFSET);
+    if (event_len < LOG_EVENT_HEADER_LEN || pos + event_len > length)
+      break;
+
+    size_t body_len= event_len - LOG_EVENT_HEADER_LEN;
+    Prepared_event ev= {
+      my_checksum(0L, buf + pos + LOG_EVENT_HEADER_LEN, body_len),
+      my_checksum_combine_op(body_len)
+    };
+    prepared_events.push_back(ev);
+    pos+= event_len;
+  }
+
+  /* Let the leader handle a cache it would not parse the same way */
+  if (pos != length)
+    prepared_events.clear();
+  DBUG_PRINT("debug", ("prepared events: %lu",
+                       (ulong) prepared_events.size()));
+  DBUG_VOID_RETURN;
+}
+
 /**
   Flush caches to the binary log.
 
@@ -1982,42 +2080,68 @@ uint64_t HybridLogicalClock::update(uint64_t minimum_hlc)
   return new_min_hlc;
 }
 
-void HybridLogicalClock::update_database_hlc(
-    const std::unordered_set<std::string> &databases, uint64_t applied_hlc) {
-  std::vector<std::shared_ptr<DatabaseEntry>> entries;
+std::shared_ptr<HybridLogicalClock::DatabaseEntry>
+HybridLogicalClock::getEntry(const std::string& database) {
+  auto& shard = getShard(database);
   {
-    std::unique_lock<std::mutex> lock(database_map_lock_);
-    for (const auto &database : databases) {
-      auto entry = getEntry(database);
-      DBUG_ASSERT(entry);
-      entries.push_back(std::move(entry));
+    std::shared_lock<std::shared_mutex> lock(shard.lock);
+    const auto it = shard.map.find(database);
+    if (it != shard.map.end()) {
+      return it->second;
     }
   }
 
-  for (const auto &entry : entries) {
-    entry->update_hlc(applied_hlc);
+  std::unique_lock<std::shared_mutex> lock(shard.lock);
+  auto& entry = shard.map[database];
+  if (!entry) {
+    entry = std::make_shared<DatabaseEntry>();
+  }
+  return entry;
+}
+
+void HybridLogicalClock::update_database_hlc(
+    const std::unordered_set<std::string> &databases, uint64_t applied_hlc) {
+  for (const auto &database : databases) {
+    auto& shard = getShard(database);
+    {
+      // Common case, the database is known. Update it under the shared lock
+      // which also keeps the entry alive, without copying the shared_ptr
+      std::shared_lock<std::shared_mutex> lock(shard.lock);
+      const auto it = shard.map.find(database);
+      if (it != shard.map.end()) {
+        it->second->update_hlc(applied_hlc);
+        continue;
+      }
+    }
+
+    getEntry(database)->update_hlc(applied_hlc);
   }
 }
 
 void HybridLogicalClock::get_database_hlc(
     std::unordered_map<std::string, uint64_t> &applied_hlc) {
-  std::unique_lock<std::mutex> lock(database_map_lock_);
-  for (const auto& record : database_map_) {
-    applied_hlc.emplace(record.first, record.second->max_applied_hlc());
+  for (const auto& shard : database_map_) {
+    std::shared_lock<std::shared_mutex> lock(shard.lock);
+    for (const auto& record : shard.map) {
+      applied_hlc.emplace(record.first, record.second->max_applied_hlc());
+    }
   }
 }
 
 uint64_t
 HybridLogicalClock::get_selected_database_hlc(const std::string& database) {
-  std::unique_lock<std::mutex> lock(database_map_lock_);
+  auto& shard = getShard(database);
+  std::shared_lock<std::shared_mutex> lock(shard.lock);
 
-  const auto it = database_map_.find(database);
-  return it != database_map_.end() ? it->second->max_applied_hlc() : 0;
+  const auto it = shard.map.find(database);
+  return it != shard.map.end() ? it->second->max_applied_hlc() : 0;
 }
 
 void HybridLogicalClock::clear_database_hlc() {
-  std::unique_lock<std::mutex> lock(database_map_lock_);
-  database_map_.clear();
+  for (auto& shard : database_map_) {
+    std::unique_lock<std::shared_mutex> lock(shard.lock);
+    shard.map.clear();
+  }
 }
 
 bool HybridLogicalClock::wait_for_hlc_applied(THD *thd,
@@ -2095,19 +2219,7 @@ bool HybridLogicalClock::wait_for_hlc_applied(THD *thd,
   // Return early if the waiting feature isn't enabled
   if (!wait_for_hlc_timeout_ms) return false;
 
-  std::shared_ptr<DatabaseEntry> entry = nullptr;
-  {
-    std::unique_lock<std::mutex> lock(database_map_lock_);
-    auto entryIt = database_map_.find(db);
-    if (entryIt == database_map_.end()) {
-      entry = std::make_shared<DatabaseEntry>();
-      database_map_.emplace(db, entry);
-    } else {
-      entry = entryIt->second;
-    }
-  }
-
-  return entry->wait_for_hlc(thd, requested_hlc, timeout_ms);
+  return getEntry(db)->wait_for_hlc(thd, requested_hlc, timeout_ms);
 }
 
 bool HybridLogicalClock::capture_hlc_bound(THD *thd) {
@@ -2212,13 +2324,32 @@ void HybridLogicalClock::DatabaseEntry::update_hlc(uint64_t applied_hlc) {
          !max_applied_hlc_.compare_exchange_strong(original, applied_hlc)) {
   }
 
-  // Signal the list of waiters with requested HLCs close to the current applied
-  // value
-  if (wait_for_hlc_timeout_ms) {
+  // Signal the list of waiters once the applied HLC reaches the smallest
+  // requested HLC. All the waiters satisfied by this trx or by the ones
+  // applied since the last signal wake up together. The mutex orders this
+  // with a waiter checking max_applied_hlc_ before blocking on cond_
+  if (applied_hlc >= min_waiting_hlc_) {
+    mysql_mutex_lock(&mutex_);
     mysql_cond_broadcast(&cond_);
+    mysql_mutex_unlock(&mutex_);
   }
 }
 
+void HybridLogicalClock::DatabaseEntry::add_waiter(uint64_t requested_hlc) {
+  mysql_mutex_assert_owner(&mutex_);
+  waiting_hlcs_.insert(requested_hlc);
+  min_waiting_hlc_ = *waiting_hlcs_.begin();
+}
+
+void HybridLogicalClock::DatabaseEntry::remove_waiter(uint64_t requested_hlc) {
+  mysql_mutex_assert_owner(&mutex_);
+  const auto it = waiting_hlcs_.find(requested_hlc);
+  DBUG_ASSERT(it != waiting_hlcs_.end());
+  waiting_hlcs_.erase(it);
+  min_waiting_hlc_ =
+      waiting_hlcs_.empty() ? ULLONG_MAX : *waiting_hlcs_.begin();
+}
+
 bool HybridLogicalClock::DatabaseEntry::wait_for_hlc(THD *thd,
                                                     uint64_t requested_hlc,
                                                     uint64_t timeout_ms) {
@@ -2273,11 +2404,18 @@ bool HybridLogicalClock::DatabaseEntry::wait_for_hlc(THD *thd,
       set_timespec_nsec(timeout, remaining_timeout_ms * 1000000ULL);
       PSI_stage_info old_stage;
       mysql_mutex_lock(&mutex_);
+      add_waiter(requested_hlc);
       thd->ENTER_COND(&cond_, &mutex_, &stage_waiting_for_hlc, &old_stage);
       thd_wait_begin(thd, THD_WAIT_FOR_HLC);
 
-      int error = mysql_cond_timedwait(&cond_, &mutex_, &timeout);
+      // Check again now that commits see this waiter, the HLC may have been
+      // applied in between without a signal
+      int error = 0;
+      if (max_applied_hlc_ < requested_hlc) {
+        error = mysql_cond_timedwait(&cond_, &mutex_, &timeout);
+      }
 
+      remove_waiter(requested_hlc);
       thd->EXIT_COND(&old_stage);
       thd_wait_end(thd);
 
@@ -8710,6 +8848,84 @@ int MYSQL_BIN_LOG::do_write_cache(IO_CACHE *cache)
   DBUG_RETURN(0); // All OK
 }
 
+/*
+  Write the contents of a prepared cache to the binary log.
+
+  SYNOPSIS
+    do_write_prepared_cache()
+    cache_data    Cache prepared by binlog_cache_data::prepare_for_flush()
+
+  DESCRIPTION
+    Same as do_write_cache() for a cache held in memory whose events were
+    checksummed by the session before it entered the flush stage. The
+    length and end_log_pos of each event header are fixed in a copy, and
+    the checksum of the header is combined with the one of the rest of
+    the event. Events rewritten or added in the flush stage, such as the
+    GTID and the HLC metadata of the transaction, are checksummed in full.
+*/
+
+int MYSQL_BIN_LOG::do_write_prepared_cache(binlog_cache_data *cache_data)
+{
+  DBUG_ENTER("MYSQL_BIN_LOG::do_write_prepared_cache");
+
+  DBUG_EXECUTE_IF("simulate_do_write_cache_failure",
+                  {
+                    DBUG_SET("-d,simulate_do_write_cache_failure");
+                    DBUG_RETURN(ER_ERROR_ON_WRITE);
+                  });
+
+  IO_CACHE *cache= &cache_data->cache_log;
+  const uchar *buf= cache->write_buffer;
+  my_off_t length= my_b_tell(cache);
+  my_off_t group= my_b_tell(&log_file);
+  my_off_t pos= 0;
+  ulong end_log_pos_inc= 0;
+  uchar header[LOG_EVENT_HEADER_LEN];
+  uchar crc_buf[BINLOG_CHECKSUM_LEN];
+
+  DBUG_ASSERT(cache->type == WRITE_CACHE && cache->pos_in_file == 0);
+  DBUG_ASSERT(binlog_checksum_options == BINLOG_CHECKSUM_ALG_CRC32);
+
+  for (size_t i= 0; pos < length; i++)
+  {
+    const uchar *ev= buf + pos;
+    uint32 event_len= uint4korr(ev + EVENT_LEN_OFFSET); // netto len
+    size_t body_len= event_len - LOG_EVENT_HEADER_LEN;
+    ha_checksum crc;
+
+    DBUG_ASSERT(event_len >= LOG_EVENT_HEADER_LEN &&
+                pos + event_len <= length);
+
+    /* fix end_log_pos and length */
+    memcpy(header, ev, LOG_EVENT_HEADER_LEN);
+    end_log_pos_inc+= BINLOG_CHECKSUM_LEN;
+    int4store(header + LOG_POS_OFFSET,
+              uint4korr(ev + LOG_POS_OFFSET) + group + end_log_pos_inc);
+    int4store(header + EVENT_LEN_OFFSET, event_len + BINLOG_CHECKSUM_LEN);
+
+    crc= my_checksum(0L, header, LOG_EVENT_HEADER_LEN);
+    if (pos >= cache_data->rewritten_head &&
+        i < cache_data->prepared_events.size())
+    {
+      const binlog_cache_data::Prepared_event &prepared=
+        cache_data->prepared_events[i];
+      crc= my_checksum_combine(crc, prepared.body_crc, prepared.combine_op);
+    }
+    else
+      crc= my_checksum(crc, ev + LOG_EVENT_HEADER_LEN, body_len);
+    int4store(crc_buf, crc);
+
+    if (my_b_write(&log_file, header, LOG_EVENT_HEADER_LEN) ||
+        my_b_write(&log_file, ev + LOG_EVENT_HEADER_LEN, body_len) ||
+        my_b_write(&log_file, crc_buf, BINLOG_CHECKSUM_LEN))
+      DBUG_RETURN(ER_ERROR_ON_WRITE);
+
+    pos+= event_len;
+  }
+
+  DBUG_RETURN(0); // All OK
+}
+
 /**
   Writes an incident event to the binary log.
 
@@ -8978,7 +9194,18 @@ bool MYSQL_BIN_LOG::write_cache(THD *thd, binlog_cache_data *cache_data,
             goto err;
           });
 
-      if ((write_error= do_write_cache(cache)))
+      /*
+        A cache checksummed by its session is written without reading
+        it back, unless it was swapped to a file or binlog_checksum
+        changed since then.
+      */
+      if (!cache_data->prepared_events.empty() &&
+          cache->type == WRITE_CACHE && cache->pos_in_file == 0 &&
+          binlog_checksum_options == BINLOG_CHECKSUM_ALG_CRC32)
+        write_error= do_write_prepared_cache(cache_data);
+      else
+        write_error= do_write_cache(cache);
+      if (write_error)
         goto err;
       if (us)
       {
@@ -10801,6 +11028,7 @@ int MYSQL_BIN_LOG::ordered_commit(THD *thd, bool all, bool skip_commit,
   my_off_t total_bytes= 0;
   bool do_rotate= false;
   THD *semisync_queue= nullptr;
+  ulonglong stage_start_time;
 
   /*
     These values are used while flushing a transaction, so clear
@@ -10842,6 +11070,18 @@ int MYSQL_BIN_LOG::ordered_commit(THD *thd, bool all, bool skip_commit,
                        YESNO(thd->transaction.flags.pending),
                        thd->commit_error, thd->thread_id()));
 
+  /*
+    Checksum the caches before queueing for the flush stage, so that
+    sessions do it in parallel instead of the leader doing it for the
+    whole group under LOCK_log.
+  */
+  if (opt_binlog_pipelined_flush && !enable_raft_plugin)
+  {
+    binlog_cache_mngr *cache_mngr= thd_get_cache_mngr(thd);
+    if (cache_mngr)
+      cache_mngr->prepare_for_flush();
+  }
+
   /*
     Stage #1: flushing transactions to binary log
 
@@ -10895,6 +11135,7 @@ int MYSQL_BIN_LOG::ordered_commit(THD *thd, bool all, bool skip_commit,
     goto commit_stage;
   }
   DEBUG_SYNC(thd, "waiting_in_the_middle_of_flush_stage");
+  stage_start_time= my_timer_now();
   flush_stage_error= process_flush_stage_queue(&total_bytes, &do_rotate,
                                          &final_queue, async);
 
@@ -10905,6 +11146,8 @@ int MYSQL_BIN_LOG::ordered_commit(THD *thd, bool all, bool skip_commit,
    */
   if (total_bytes > 0)
     flush_error= flush_cache_to_file(&flush_end_pos);
+  latency_histogram_increment(&histogram_binlog_flush_stage,
+                              my_timer_since(stage_start_time), 1);
 
   DBUG_EXECUTE_IF("crash_after_flush_binlog", DBUG_SUICIDE(););
   /*
@@ -10933,8 +11176,11 @@ int MYSQL_BIN_LOG::ordered_commit(THD *thd, bool all, bool skip_commit,
     if (total_bytes > 0)
     {
       DEBUG_SYNC(thd, "before_sync_binlog_file");
+      stage_start_time= my_timer_now();
       std::pair<bool, bool> result = sync_binlog_file(false, async);
       flush_error = result.first;
+      latency_histogram_increment(&histogram_binlog_sync_stage,
+                                  my_timer_since(stage_start_time), 1);
     }
 
     /*
@@ -22,6 +22,8 @@
 #include "rpl_gtid.h"
 #include <atomic>
 #include <list>
+#include <set>
+#include <shared_mutex>
 #include <unordered_map>
 
 extern ulong rpl_read_size;
@@ -32,6 +34,8 @@ extern latency_histogram histogram_binlog_fsync;
 extern latency_histogram histogram_raft_trx_wait;
 extern latency_histogram histogram_binlog_group_commit_trx;
 extern latency_histogram histogram_binlog_engine_commit_trx;
+extern latency_histogram histogram_binlog_flush_stage;
+extern latency_histogram histogram_binlog_sync_stage;
 extern counter_histogram histogram_binlog_group_commit;
 extern Slow_log_throttle log_throttle_sbr_unsafe_query;
 class Relay_log_info;
@@ -369,7 +373,7 @@ class HybridLogicalClock {
 
   /**
    * Block the THD if the query attribute specified HLC isn't
-   * present in the engine according to database_applied_hlc_
+   * present in the engine according to the applied HLC of the database
    */
   bool wait_for_hlc_applied(THD *thd, TABLE_LIST *all_tables);
 
@@ -411,15 +415,9 @@ private:
   // nanosecond precision internal clock
   std::atomic<uint64_t> current_;
 
-  /**
-   * A map of applied HLC for each database. The key is the name of the database
-   * and the value is the applied_hlc for that database. Applied HLC is the HLC
-   * of the last known trx that was applied (committed) to the engine
-   */
-  std::unordered_map<std::string, uint64_t> database_applied_hlc_;
-  std::mutex database_applied_hlc_lock_;
-
-  // Per-database entry to track the list of waiting queries
+  // Per-database entry to track the applied HLC and the list of waiting
+  // queries. Applied HLC is the HLC of the last known trx that was applied
+  // (committed) to the engine
   class DatabaseEntry {
   public:
     DatabaseEntry() {
@@ -446,25 +444,41 @@ private:
     }
 
   private:
+    void add_waiter(uint64_t requested_hlc);
+    void remove_waiter(uint64_t requested_hlc);
+
     mysql_mutex_t mutex_;
     mysql_cond_t cond_;
     std::atomic<uint64_t> max_applied_hlc_{0};
+
+    // Requested HLCs of the queries blocked on cond_, protected by mutex_
+    std::multiset<uint64_t> waiting_hlcs_;
+
+    // Smallest of waiting_hlcs_, or ULLONG_MAX when there are no waiters.
+    // Commits only take mutex_ to wake the waiters once they applied an HLC
+    // at least this large
+    std::atomic<uint64_t> min_waiting_hlc_{ULLONG_MAX};
   };
 
-  std::shared_ptr<DatabaseEntry> getEntry(const std::string& database) {
-    std::shared_ptr<DatabaseEntry> entry = nullptr;
-    auto entryIt = database_map_.find(database);
-    if (entryIt == database_map_.end()) {
-      entry = std::make_shared<DatabaseEntry>();
-      database_map_.emplace(database, entry);
-    } else {
-      entry = entryIt->second;
-    }
-    return entry;
+  // The map of databases is split in shards by the hash of the database name
+  // so that commits to different databases do not contend on the same lock.
+  // Commits only take the shard lock in shared mode, unless the database is
+  // seen for the first time.
+  static constexpr size_t DATABASE_MAP_SHARDS = 64;
+
+  struct DatabaseMapShard {
+    std::unordered_map<std::string, std::shared_ptr<DatabaseEntry>> map;
+    mutable std::shared_mutex lock;
+  } MY_ATTRIBUTE((aligned(CPU_LEVEL1_DCACHE_LINESIZE)));
+
+  DatabaseMapShard& getShard(const std::string& database) {
+    return database_map_[std::hash<std::string>()(database) %
+                         DATABASE_MAP_SHARDS];
   }
 
-  std::unordered_map<std::string, std::shared_ptr<DatabaseEntry>> database_map_;
-  mutable std::mutex database_map_lock_;
+  std::shared_ptr<DatabaseEntry> getEntry(const std::string& database);
+
+  DatabaseMapShard database_map_[DATABASE_MAP_SHARDS];
 };
 
 class MYSQL_BIN_LOG: public TC_LOG, private MYSQL_LOG
@@ -1094,6 +1108,7 @@ public:
   bool write_cache(THD *thd, class binlog_cache_data *binlog_cache_data,
                    bool async);
   int  do_write_cache(IO_CACHE *cache);
+  int  do_write_prepared_cache(class binlog_cache_data *cache_data);
 
   /**
    * Called after a THD's iocache is written to binlog (i.e binlog's cache)
@@ -1296,6 +1311,10 @@ public:
                             opt_histogram_binlog_commit_time_step_size);
       latency_histogram_init(&histogram_binlog_group_commit_trx,
                             opt_histogram_binlog_commit_time_step_size);
+      latency_histogram_init(&histogram_binlog_flush_stage,
+                            opt_histogram_binlog_commit_time_step_size);
+      latency_histogram_init(&histogram_binlog_sync_stage,
+                            opt_histogram_binlog_commit_time_step_size);
     }
     mysql_mutex_unlock(&LOCK_log);
   }
@@ -1490,6 +1509,7 @@ extern const char *log_bin_index;
 extern const char *log_bin_basename;
 extern bool opt_binlog_order_commits;
 extern bool opt_gtid_precommit;
+extern bool opt_binlog_pipelined_flush;
 
 /**
   Turns a relative log binary log path into a full path, based on the
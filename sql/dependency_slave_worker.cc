@@ -13,62 +13,108 @@ void clear_current_group_events(Slave_worker *worker,
                                 Relay_log_info *rli,
                                 bool overfill);
 
+// Pops the next begin event from the queues, returns nullptr if none could be
+// popped right now
 std::shared_ptr<Log_event_wrapper>
-Dependency_slave_worker::get_begin_event(Commit_order_manager *co_mngr)
+Dependency_slave_worker::dequeue_begin_event(Commit_order_manager *co_mngr)
 {
   std::shared_ptr<Log_event_wrapper> ret;
+  const uint num_queues= c_rli->dep_num_queues;
 
-  mysql_mutex_lock(&c_rli->dep_lock);
+  // case: commits are ordered, trxs must be registered in the commit order
+  // queue in the order they were enqueued, so we can only take the oldest trx
+  if (co_mngr != NULL)
+  {
+    DBUG_ASSERT(c_rli->mts_dependency_order_commits);
+    const uint idx= c_rli->dep_dequeue_seq % num_queues;
+    auto& queue= c_rli->dep_queues[idx];
+    mysql_mutex_lock(&queue.lock);
+    // NOTE: only the holder of this queue's lock can pop the oldest trx and
+    // advance the sequence, so re-check it under the lock
+    const auto seq= c_rli->dep_dequeue_seq.load();
+    if (seq % num_queues == idx &&
+        !queue.events.empty() && queue.events.front().first == seq)
+    {
+      ret= std::move(queue.events.front().second);
+      queue.events.pop_front();
+      // case: if we need to order commits by DB we set current DB
+      if (c_rli->mts_dependency_order_commits == DEP_RPL_ORDER_DB)
+        set_current_db(ret->get_db());
+      co_mngr->register_trx(this);
+      c_rli->dep_dequeue_seq= seq + 1;
+    }
+    mysql_mutex_unlock(&queue.lock);
+  }
+  // case: start with our own queue and steal from the others if it's empty
+  else
+  {
+    for (uint i= 0; !ret && i < num_queues; ++i)
+    {
+      auto& queue= c_rli->dep_queues[(id + i) % num_queues];
+      mysql_mutex_lock(&queue.lock);
+      if (!queue.events.empty())
+      {
+        ret= std::move(queue.events.front().second);
+        queue.events.pop_front();
+      }
+      mysql_mutex_unlock(&queue.lock);
+    }
+  }
+
+  if (ret)
+    --c_rli->dep_queue_size;
+  return ret;
+}
 
-  PSI_stage_info old_stage;
-  info_thd->ENTER_COND(&c_rli->dep_empty_cond, &c_rli->dep_lock,
-                       &stage_slave_waiting_event_from_coordinator,
-                       &old_stage);
+std::shared_ptr<Log_event_wrapper>
+Dependency_slave_worker::get_begin_event(Commit_order_manager *co_mngr)
+{
+  std::shared_ptr<Log_event_wrapper> ret;
 
   while (!info_thd->killed &&
          running_status == RUNNING &&
-         c_rli->dep_queue.empty())
+         !(ret= dequeue_begin_event(co_mngr)))
   {
-    ++c_rli->begin_event_waits;
+    // case: nothing left to pop, wait for the coordinator
+    mysql_mutex_lock(&c_rli->dep_lock);
+
+    PSI_stage_info old_stage;
+    info_thd->ENTER_COND(&c_rli->dep_empty_cond, &c_rli->dep_lock,
+                         &stage_slave_waiting_event_from_coordinator,
+                         &old_stage);
+
+    // NOTE: @num_workers_waiting is incremented before checking the queue
+    // size, the coordinator does the opposite before signalling
     ++c_rli->num_workers_waiting;
-    const auto timeout_nsec= c_rli->mts_dependency_cond_wait_timeout * 1000000;
-    struct timespec abstime;
-    set_timespec_nsec(abstime, timeout_nsec);
-    mysql_cond_timedwait(&c_rli->dep_empty_cond, &c_rli->dep_lock, &abstime);
+    if (c_rli->dep_queue_size == 0 &&
+        !info_thd->killed &&
+        running_status == RUNNING)
+    {
+      ++c_rli->begin_event_waits;
+      const auto timeout_nsec=
+        c_rli->mts_dependency_cond_wait_timeout * 1000000;
+      struct timespec abstime;
+      set_timespec_nsec(abstime, timeout_nsec);
+      mysql_cond_timedwait(&c_rli->dep_empty_cond, &c_rli->dep_lock, &abstime);
+    }
     --c_rli->num_workers_waiting;
-  }
 
-  ret= c_rli->dequeue_dep();
-
-  // case: place ourselves in the commit order queue
-  if (ret && co_mngr != NULL)
-  {
-    DBUG_ASSERT(c_rli->mts_dependency_order_commits);
-    // case: if we need to order commits by DB we set current DB
-    if (c_rli->mts_dependency_order_commits == DEP_RPL_ORDER_DB)
-      set_current_db(ret->get_db());
-    co_mngr->register_trx(this);
+    info_thd->EXIT_COND(&old_stage);
   }
 
-  // case: signal if queue is now empty
-  if (c_rli->dep_queue.empty())
-    mysql_cond_signal(&c_rli->dep_empty_cond);
-
   // admission control
-  if (unlikely(c_rli->dep_full))
+  if (ret && unlikely(c_rli->dep_full))
   {
-    DBUG_ASSERT(c_rli->dep_queue.size() > 0);
+    mysql_mutex_lock(&c_rli->dep_lock);
     // case: signal if dep has space
-    if (c_rli->dep_queue.size() <
-        (c_rli->mts_dependency_size *
-         c_rli->mts_dependency_refill_threshold / 100))
+    if (c_rli->dep_full && c_rli->dep_below_refill_threshold())
     {
       c_rli->dep_full= false;
       mysql_cond_signal(&c_rli->dep_full_cond);
     }
+    mysql_mutex_unlock(&c_rli->dep_lock);
   }
 
-  info_thd->EXIT_COND(&old_stage);
   return ret;
 }
 
@@ -212,24 +258,40 @@ Dependency_slave_worker::finalize_event(std::shared_ptr<Log_event_wrapper> &ev)
    *    remove the key-value pair from the map.
    * 2) The "value" of the key-value pair is _not_ equal to this event. In this
    *    case, leave it be; the event corresponds to a later transaction.
+   *
+   * The coordinator can still add keys to this event while we execute it
+   * (in TBL mode the keys of a trx are added to its penultimate event when
+   * the end event is scheduled), so the event is finalized only once we
+   * hold the shards of all its keys. No key can be added after that.
    */
-  mysql_mutex_lock(&c_rli->dep_key_lookup_mutex);
-  if (likely(!c_rli->dep_key_lookup.empty()))
+  std::bitset<Relay_log_info::DEP_KEY_LOOKUP_SHARDS> shards, needed;
+  while (!ev->finalize_if([&](const std::unordered_set<Dependency_key>& keys)
+                          {
+                            needed= c_rli->dep_key_shards(keys);
+                            return (needed & ~shards).none();
+                          }))
   {
-    for (const auto& key : ev->keys)
-    {
-      const auto it= c_rli->dep_key_lookup.find(key);
-      DBUG_ASSERT(it != c_rli->dep_key_lookup.end());
+    c_rli->unlock_dep_key_shards(shards);
+    shards= needed;
+    c_rli->lock_dep_key_shard_set(shards);
+  }
 
-      /* Case 1. (Case 2 is implicitly handled by doing nothing.) */
-      if (it->second == ev)
-      {
-        c_rli->dep_key_lookup.erase(it);
-      }
+  for (const auto& key : ev->get_keys())
+  {
+    auto& lookup= c_rli->dep_key_lookup[c_rli->dep_key_shard(key)].keys;
+    if (unlikely(lookup.empty()))
+      continue;
+
+    const auto it= lookup.find(key);
+    DBUG_ASSERT(it != lookup.end());
+
+    /* Case 1. (Case 2 is implicitly handled by doing nothing.) */
+    if (it->second == ev)
+    {
+      lookup.erase(it);
     }
   }
-  ev->finalize();
-  mysql_mutex_unlock(&c_rli->dep_key_lookup_mutex);
+  c_rli->unlock_dep_key_shards(shards);
 }
 
 Dependency_slave_worker::Dependency_slave_worker(Relay_log_info *rli
@@ -259,8 +321,8 @@ Dependency_slave_worker::Dependency_slave_worker(Relay_log_info *rli
 
 void Dependency_slave_worker::start()
 {
-  DBUG_ASSERT(c_rli->dep_queue.empty() &&
-              dep_key_lookup.empty() &&
+  DBUG_ASSERT(c_rli->dep_queue_size == 0 &&
+              dep_key_lookup_empty() &&
               keys_accessed_by_group.empty() &&
               dbs_accessed_by_group.empty());
 
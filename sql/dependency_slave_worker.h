@@ -9,6 +9,8 @@ class Commit_order_manager;
 
 class Dependency_slave_worker : public Slave_worker
 {
+  std::shared_ptr<Log_event_wrapper>
+    dequeue_begin_event(Commit_order_manager *co_mngr);
   std::shared_ptr<Log_event_wrapper>
     get_begin_event(Commit_order_manager *co_mngr);
   bool execute_group();
@@ -2473,6 +2473,12 @@ bool MYSQL_QUERY_LOG::write(THD *thd, time_t current_time,
       tmp_errno=errno;
     }
 
+    if (!thd->engine_perf_context.empty())
+    {
+      if (my_b_printf(&log_file, "# %s\n",
+                      thd->engine_perf_context.c_str()) == (uint) -1)
+        tmp_errno= errno;
+    }
 
     if (thd->db && strcmp(thd->db, db))
     {						// Database changed
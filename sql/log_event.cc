@@ -3271,7 +3271,7 @@ bool Log_event::schedule_dep(Relay_log_info *rli)
 {
   DBUG_ENTER("Log_event::schedule_dep");
 
-  auto ev= std::make_shared<Log_event_wrapper>(this, rli->current_begin_event);
+  auto ev= rli->dep_event_pool.acquire(this, rli->current_begin_event);
   prepare_dep(rli, ev);
 
   if (starts_group())
@@ -3346,33 +3346,42 @@ bool Log_event::schedule_dep(Relay_log_info *rli)
   if (!rli->trx_queued &&
       (rli->dep_sync_group || !rli->current_begin_event->get_db().empty()))
   {
-    mysql_mutex_lock(&rli->dep_lock);
-
     // wait if queue has reached full capacity
-    while (unlikely(rli->dep_full))
+    if (unlikely(rli->dep_full))
     {
-      const auto timeout_nsec= rli->mts_dependency_cond_wait_timeout * 1000000;
-      struct timespec abstime;
-      set_timespec_nsec(abstime, timeout_nsec);
-      mysql_cond_timedwait(&rli->dep_full_cond, &rli->dep_lock, &abstime);
+      mysql_mutex_lock(&rli->dep_lock);
+      // NOTE: workers clear @dep_full, but we also re-check the queue size
+      // ourselves in case they drained it before we set the flag
+      while (rli->dep_full && !rli->dep_below_refill_threshold())
+      {
+        const auto timeout_nsec=
+          rli->mts_dependency_cond_wait_timeout * 1000000;
+        struct timespec abstime;
+        set_timespec_nsec(abstime, timeout_nsec);
+        mysql_cond_timedwait(&rli->dep_full_cond, &rli->dep_lock, &abstime);
+      }
+      rli->dep_full= false;
+      mysql_mutex_unlock(&rli->dep_lock);
     }
 
+    // NOTE: this must be incremented before the trx is visible to workers
+    ++rli->num_in_flight_trx;
     rli->enqueue_dep(rli->current_begin_event);
 
-    // case: workers are waiting on empty queue, let's signal
-    if (likely(rli->num_workers_waiting > 0))
+    // case: workers are waiting on empty queues, let's signal
+    if (unlikely(rli->num_workers_waiting > 0))
     {
+      mysql_mutex_lock(&rli->dep_lock);
       DBUG_ASSERT(rli->num_workers_waiting <= rli->opt_slave_parallel_workers);
       mysql_cond_signal(&rli->dep_empty_cond);
+      mysql_mutex_unlock(&rli->dep_lock);
     }
 
     // admission control in dep queue
-    rli->dep_full= rli->dep_queue.size() >= rli->mts_dependency_size;
+    if (unlikely(rli->dep_queue_size >= rli->mts_dependency_size))
+      rli->dep_full= true;
 
-    ++rli->num_in_flight_trx;
     rli->trx_queued= true;
-
-    mysql_mutex_unlock(&rli->dep_lock);
   }
 
   DBUG_ASSERT(ev->is_begin_event || rli->prev_event);
@@ -3486,16 +3495,17 @@ Log_event::handle_terminal_dep_event(Relay_log_info *rli,
     auto to_add=
       rli->mts_dependency_replication == DEP_RPL_TABLE && rli->prev_event ?
       rli->prev_event : ev;
-    mysql_mutex_lock(&rli->dep_key_lookup_mutex);
-    if (!to_add->finalized())
+    //
+    // NOTE: All shards covering the keys are held while adding them to
+    // @to_add, a worker finalizes @to_add only while holding the shards of
+    // all its keys, see @Dependency_slave_worker::finalize_event()
+    const auto shards= rli->lock_dep_key_shards(rli->keys_accessed_by_group);
+    if (to_add->add_keys(rli->keys_accessed_by_group))
     {
       for (const auto& key : rli->keys_accessed_by_group)
-      {
-        rli->dep_key_lookup[key]= to_add;
-        to_add->keys.insert(key);
-      }
+        rli->dep_key_lookup[rli->dep_key_shard(key)].keys[key]= to_add;
     }
-    mysql_mutex_unlock(&rli->dep_key_lookup_mutex);
+    rli->unlock_dep_key_shards(shards);
 
     // update rli state
     rli->table_map_events.clear();
@@ -12647,17 +12657,19 @@ void Rows_log_event::prepare_dep(Relay_log_info *rli,
     rli->keys_accessed_by_group.insert(m_keylist.begin(), m_keylist.end());
   }
 
-  mysql_mutex_lock(&rli->dep_key_lookup_mutex);
-  /* Handle dependencies. */
+  /* Handle dependencies. Only the shard of each key needs to be held, an
+     event found in the lookup cannot be finalized until it's removed */
   for (const auto& k : m_keylist)
   {
-    auto last_key_event= rli->dep_key_lookup.find(k);
-    if (last_key_event != rli->dep_key_lookup.end())
+    auto& shard= rli->dep_key_lookup[rli->dep_key_shard(k)];
+    mysql_mutex_lock(&shard.lock);
+    auto last_key_event= shard.keys.find(k);
+    if (last_key_event != shard.keys.end())
     {
       last_key_event->second->add_dependent(ev);
     }
+    mysql_mutex_unlock(&shard.lock);
   }
-  mysql_mutex_unlock(&rli->dep_key_lookup_mutex);
 
   DBUG_VOID_RETURN;
 }
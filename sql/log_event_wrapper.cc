@@ -9,7 +9,7 @@ void Log_event_wrapper::put_next(std::shared_ptr<Log_event_wrapper> &ev)
               (ev->begin_event() == begin_ev.lock() ||
                is_begin_event));
   next_ev= ev;
-  mysql_cond_signal(&next_event_cond);
+  mysql_cond_signal(&cond);
   mysql_mutex_unlock(&mutex);
 }
 
@@ -48,7 +48,7 @@ std::shared_ptr<Log_event_wrapper> Log_event_wrapper::next()
   DBUG_ASSERT(worker);
   auto info_thd= worker->info_thd;
   PSI_stage_info old_stage;
-  info_thd->ENTER_COND(&next_event_cond, &mutex,
+  info_thd->ENTER_COND(&cond, &mutex,
                        &stage_slave_waiting_event_from_coordinator, &old_stage);
   while (!info_thd->killed &&
          worker->running_status == Slave_worker::RUNNING &&
@@ -59,7 +59,7 @@ std::shared_ptr<Log_event_wrapper> Log_event_wrapper::next()
       worker->c_rli->mts_dependency_cond_wait_timeout * 1000000;
     struct timespec abstime;
     set_timespec_nsec(abstime, timeout_nsec);
-    mysql_cond_timedwait(&next_event_cond, &mutex, &abstime);
+    mysql_cond_timedwait(&cond, &mutex, &abstime);
   }
   info_thd->EXIT_COND(&old_stage);
   return next_ev;
@@ -76,3 +76,48 @@ bool Log_event_wrapper::path_exists(
   }
   return false;
 }
+
+std::shared_ptr<Log_event_wrapper>
+Log_event_wrapper_pool::acquire(Log_event *raw_ev,
+                                std::shared_ptr<Log_event_wrapper> &begin_ev)
+{
+  // case: our own wrappers are used up, take the ones returned by workers
+  if (local.empty())
+  {
+    mysql_mutex_lock(&lock);
+    local.swap(returned);
+    mysql_mutex_unlock(&lock);
+  }
+
+  Log_event_wrapper *ev;
+  if (likely(!local.empty()))
+  {
+    ev= local.back();
+    local.pop_back();
+    ev->reuse(raw_ev, begin_ev);
+  }
+  else
+  {
+    ev= new Log_event_wrapper(raw_ev, begin_ev);
+  }
+
+  // NOTE: the control block is still allocated per event, this way weak
+  // references to a previous use of the wrapper expire as usual
+  return std::shared_ptr<Log_event_wrapper>(
+      ev, [this](Log_event_wrapper *ev) { release(ev); });
+}
+
+void Log_event_wrapper_pool::release(Log_event_wrapper *ev)
+{
+  ev->recycle();
+
+  mysql_mutex_lock(&lock);
+  if (likely(returned.size() < MAX_IDLE))
+  {
+    returned.push_back(ev);
+    ev= nullptr;
+  }
+  mysql_mutex_unlock(&lock);
+
+  delete ev;
+}
@@ -20,22 +20,23 @@ class Log_event_wrapper
 
   // mutex for everything in this event
   mysql_mutex_t mutex;
-  // cond var for dependency tracking
+  // cond var for dependency tracking and for the next event in the group,
+  // only the worker executing the group ever waits on it
   mysql_cond_t cond;
-  // cond var for next event in the group
-  mysql_cond_t next_event_cond;
 
   // has all dependendents of this event been notified after execution?
   bool is_finalized= false;
 
   std::string db;
 
+  // keys touched by this event, it should not be empty for rows event. The
+  // coordinator can add keys until the event is finalized, so this is
+  // protected by @mutex until then
+  std::unordered_set<Dependency_key> keys;
+
 public:
   std::shared_ptr<Log_event_wrapper> next_ev;
 
-  // keys touched by this event, it should not be empty for rows event
-  std::unordered_set<Dependency_key> keys;
-
   // has this event been assigned to a worker queue?
   std::atomic_bool is_appended_to_queue{false};
   // is this the first event of a group?
@@ -51,10 +52,43 @@ public:
   {
     mysql_mutex_init(0, &mutex, MY_MUTEX_INIT_FAST);
     mysql_cond_init(0, &cond, NULL);
-    mysql_cond_init(0, &next_event_cond, NULL);
   }
 
   ~Log_event_wrapper()
+  {
+    release_raw_event();
+    mysql_mutex_destroy(&mutex);
+    mysql_cond_destroy(&cond);
+  }
+
+  /* Reinitializes a wrapper taken from @Log_event_wrapper_pool */
+  void reuse(Log_event *raw_ev, std::shared_ptr<Log_event_wrapper> &begin_ev)
+  {
+    DBUG_ASSERT(!this->raw_ev);
+    this->raw_ev= raw_ev;
+    this->begin_ev= begin_ev;
+  }
+
+  /* Drops everything owned by this wrapper but keeps the mutex, cond var and
+     container capacity around so that the wrapper can be reused */
+  void recycle()
+  {
+    release_raw_event();
+    begin_ev.reset();
+    dependents.clear();
+    dependencies= 0;
+    is_finalized= false;
+    db.clear();
+    next_ev.reset();
+    keys.clear();
+    is_appended_to_queue= false;
+    is_begin_event= false;
+    is_end_event= false;
+    whole_group_scheduled= false;
+  }
+
+private:
+  void release_raw_event()
   {
     // case: event was not appended to a worker's queue, so we need to delete it
     if (unlikely(!is_appended_to_queue)) { delete raw_ev; }
@@ -65,12 +99,9 @@ public:
     DBUG_ASSERT(!is_appended_to_queue || dependencies == 0);
     mysql_mutex_unlock(&mutex);
 #endif
-
-    mysql_mutex_destroy(&mutex);
-    mysql_cond_destroy(&cond);
-    mysql_cond_destroy(&next_event_cond);
   }
 
+public:
   Log_event* raw_event() const { return raw_ev; }
 
   std::shared_ptr<Log_event_wrapper>
@@ -102,9 +133,38 @@ public:
 
   bool wait(Slave_worker *worker);
 
-  void finalize()
+  /* Adds @new_keys to this event unless it's already finalized, returns false
+     if it is. The caller holds the key lookup shards covering @new_keys */
+  template <class Keys>
+  bool add_keys(const Keys &new_keys)
+  {
+    mysql_mutex_lock(&mutex);
+    const bool added= !is_finalized;
+    if (likely(added))
+      keys.insert(new_keys.begin(), new_keys.end());
+    mysql_mutex_unlock(&mutex);
+    return added;
+  }
+
+  /* Keys of this event, only stable once it's finalized */
+  const std::unordered_set<Dependency_key>& get_keys() const
+  {
+    DBUG_ASSERT(is_finalized);
+    return keys;
+  }
+
+  /* Finalizes this event if @covered(keys) returns true, @covered is called
+     with @mutex held so no key can be added in between. Returns false if
+     the event was not finalized */
+  template <class Pred>
+  bool finalize_if(Pred covered)
   {
     mysql_mutex_lock(&mutex);
+    if (!covered(keys))
+    {
+      mysql_mutex_unlock(&mutex);
+      return false;
+    }
     if (likely(!is_finalized))
     {
       for (auto& dep : dependents)
@@ -119,6 +179,7 @@ public:
       is_finalized= true;
     }
     mysql_mutex_unlock(&mutex);
+    return true;
   }
 
   bool finalized()
@@ -151,4 +212,42 @@ public:
   }
 };
 
+/**
+  @class Log_event_wrapper_pool
+
+  Recycles wrappers created by the coordinator for dependency replication so
+  that their mutex, cond var and containers are not allocated and initialized
+  for every replicated event. Wrappers are handed out by the coordinator and
+  returned by whichever thread drops the last reference to them.
+  */
+class Log_event_wrapper_pool
+{
+  // max number of idle wrappers kept around, the rest are deleted
+  static const size_t MAX_IDLE= 4096;
+
+  // wrappers only accessed by the coordinator, does not need @lock
+  std::vector<Log_event_wrapper*> local;
+  // wrappers returned by any thread, protected by @lock
+  std::vector<Log_event_wrapper*> returned;
+  mysql_mutex_t lock;
+
+  void release(Log_event_wrapper *ev);
+
+public:
+  Log_event_wrapper_pool()
+  {
+    mysql_mutex_init(0, &lock, MY_MUTEX_INIT_FAST);
+  }
+
+  ~Log_event_wrapper_pool()
+  {
+    for (auto ev : local) delete ev;
+    for (auto ev : returned) delete ev;
+    mysql_mutex_destroy(&lock);
+  }
+
+  std::shared_ptr<Log_event_wrapper>
+  acquire(Log_event *raw_ev, std::shared_ptr<Log_event_wrapper> &begin_ev);
+};
+
 #endif // LOG_EVENT_WRAPPER_H
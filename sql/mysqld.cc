@@ -580,6 +580,9 @@ my_bool opt_local_infile, opt_slave_compressed_protocol;
 my_bool opt_slave_compressed_event_protocol;
 ulonglong opt_max_compressed_event_cache_size;
 ulonglong opt_compressed_event_cache_evict_threshold;
+ulonglong opt_binlog_event_ring_size;
+std::atomic<ulonglong> binlog_event_ring_hits{0};
+std::atomic<ulonglong> binlog_event_ring_misses{0};
 ulong opt_slave_compression_lib;
 ulonglong opt_slave_dump_thread_wait_sleep_usec;
 my_bool rpl_wait_for_semi_sync_ack;
@@ -624,6 +627,7 @@ my_bool relay_log_recovery;
 my_bool opt_sync_frm, opt_allow_suspicious_udfs;
 my_bool opt_secure_auth= 0;
 char* opt_secure_file_priv;
+char* opt_io_cache_compression_dictionary;
 my_bool opt_log_slow_admin_statements= 0;
 my_bool opt_log_slow_slave_statements= 0;
 my_bool lower_case_file_system= 0;
@@ -673,6 +677,12 @@ ulonglong histogram_group_commit_trx_values[NUMBER_OF_HISTOGRAM_BINS];
 SHOW_VAR latency_histogram_engine_commit_trx[NUMBER_OF_HISTOGRAM_BINS + 1];
 ulonglong histogram_engine_commit_trx_values[NUMBER_OF_HISTOGRAM_BINS];
 
+/* status variables for binlog flush and sync stage times */
+SHOW_VAR latency_histogram_binlog_flush_stage[NUMBER_OF_HISTOGRAM_BINS + 1];
+ulonglong histogram_binlog_flush_stage_values[NUMBER_OF_HISTOGRAM_BINS];
+SHOW_VAR latency_histogram_binlog_sync_stage[NUMBER_OF_HISTOGRAM_BINS + 1];
+ulonglong histogram_binlog_sync_stage_values[NUMBER_OF_HISTOGRAM_BINS];
+
 SHOW_VAR
   histogram_binlog_group_commit_var[NUMBER_OF_COUNTER_HISTOGRAM_BINS + 1];
 ulonglong
@@ -1050,6 +1060,8 @@ char server_version[SERVER_VERSION_LENGTH];
 char *mysqld_unix_port, *opt_mysql_tmpdir;
 char *mysqld_socket_umask;
 ulong thread_handling;
+uint thread_pool_size;
+uint thread_pool_max_threads;
 
 /** name of reference on left expression in rewritten IN subquery */
 const char *in_left_expr_name= "<left expr>";
@@ -2594,6 +2606,8 @@ void clean_up(bool print_message)
   free_latency_histogram_sysvars(latency_histogram_raft_trx_wait);
   free_latency_histogram_sysvars(latency_histogram_group_commit_trx);
   free_latency_histogram_sysvars(latency_histogram_engine_commit_trx);
+  free_latency_histogram_sysvars(latency_histogram_binlog_flush_stage);
+  free_latency_histogram_sysvars(latency_histogram_binlog_sync_stage);
   free_counter_histogram_sysvars(histogram_binlog_group_commit_var);
 
   /*
@@ -2685,8 +2699,10 @@ void clean_up(bool print_message)
 #ifdef HAVE_REPLICATION
   end_slave_list();
   free_compressed_event_cache();
+  free_binlog_event_ring();
   destroy_semi_sync_last_acked();
 #endif
+  io_cache_compression_free_dictionary();
   delete binlog_filter;
   delete rpl_filter;
   end_ssl();
@@ -6262,9 +6278,17 @@ static int init_server_components()
   randominit(&sql_rand,(ulong) server_start_time,(ulong) server_start_time/2);
   setup_fpu();
   init_thr_lock();
+  if (opt_io_cache_compression_dictionary &&
+      io_cache_compression_load_dictionary(opt_io_cache_compression_dictionary))
+  {
+    sql_print_error("Failed to load the compression dictionary '%s'",
+                    opt_io_cache_compression_dictionary);
+    unireg_abort(1);
+  }
 #ifdef HAVE_REPLICATION
   init_slave_list();
   init_compressed_event_cache();
+  init_binlog_event_ring();
 #endif
 
   /* Setup logs */
@@ -10405,9 +10429,7 @@ static int show_slave_dependency_in_queue(THD *thd, SHOW_VAR *var, char *buff)
   {
     var->type= SHOW_LONGLONG;
     var->value= buff;
-    mysql_mutex_lock(&active_mi->rli->dep_lock);
-    *((ulonglong *)buff)= active_mi->rli->dep_queue.size();
-    mysql_mutex_unlock(&active_mi->rli->dep_lock);
+    *((ulonglong *)buff)= active_mi->rli->dep_queue_size.load();
   }
   else
     var->type= SHOW_UNDEF;
@@ -10526,6 +10548,22 @@ static int show_slave_received_heartbeats(THD *thd, SHOW_VAR *var, char *buff)
   return 0;
 }
 
+static int show_binlog_event_ring_hits(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_LONGLONG;
+  var->value= buff;
+  *((longlong *)buff)= binlog_event_ring_hits.load();
+  return 0;
+}
+
+static int show_binlog_event_ring_misses(THD *thd, SHOW_VAR *var, char *buff)
+{
+  var->type= SHOW_LONGLONG;
+  var->value= buff;
+  *((longlong *)buff)= binlog_event_ring_misses.load();
+  return 0;
+}
+
 static int show_slave_lag_sla_misses(THD *thd, SHOW_VAR *var, char *buff)
 {
   if (active_mi && active_mi->rli)
@@ -10721,6 +10759,42 @@ static int show_latency_histogram_engine_commit_trx(
   return 0;
 }
 
+static int show_latency_histogram_binlog_flush_stage(
+  THD *thd, SHOW_VAR *var, char *buffIgnored)
+{
+  for (int i = 0; i < NUMBER_OF_HISTOGRAM_BINS; ++i)
+  {
+    histogram_binlog_flush_stage_values[i] =
+      latency_histogram_get_count(&histogram_binlog_flush_stage, i);
+  }
+
+  prepare_latency_histogram_vars(&histogram_binlog_flush_stage,
+                                 latency_histogram_binlog_flush_stage,
+                                 histogram_binlog_flush_stage_values);
+  var->type= SHOW_ARRAY;
+  var->value = (char*) &latency_histogram_binlog_flush_stage;
+
+  return 0;
+}
+
+static int show_latency_histogram_binlog_sync_stage(
+  THD *thd, SHOW_VAR *var, char *buffIgnored)
+{
+  for (int i = 0; i < NUMBER_OF_HISTOGRAM_BINS; ++i)
+  {
+    histogram_binlog_sync_stage_values[i] =
+      latency_histogram_get_count(&histogram_binlog_sync_stage, i);
+  }
+
+  prepare_latency_histogram_vars(&histogram_binlog_sync_stage,
+                                 latency_histogram_binlog_sync_stage,
+                                 histogram_binlog_sync_stage_values);
+  var->type= SHOW_ARRAY;
+  var->value = (char*) &latency_histogram_binlog_sync_stage;
+
+  return 0;
+}
+
 #if defined(HAVE_OPENSSL) && !defined(EMBEDDED_LIBRARY)
 /* Functions relying on CTX */
 static int show_ssl_ctx_sess_accept(THD *thd, SHOW_VAR *var, char *buff)
@@ -11278,6 +11352,9 @@ SHOW_VAR status_vars[]= {
   {"Handler_savepoint_rollback",(char*) offsetof(STATUS_VAR, ha_savepoint_rollback_count), SHOW_LONGLONG_STATUS},
   {"Handler_update",           (char*) offsetof(STATUS_VAR, ha_update_count), SHOW_LONGLONG_STATUS},
   {"Handler_write",            (char*) offsetof(STATUS_VAR, ha_write_count), SHOW_LONGLONG_STATUS},
+  {"Io_cache_compression_bytes_in",  (char*) &io_cache_compression_bytes_in,  SHOW_LONGLONG},
+  {"Io_cache_compression_bytes_out", (char*) &io_cache_compression_bytes_out, SHOW_LONGLONG},
+  {"Io_cache_compression_usecs",     (char*) &io_cache_compression_usecs,     SHOW_LONGLONG},
 #ifdef HAVE_JEMALLOC
 #ifndef EMBEDDED_LIBRARY
   {"Jemalloc_arenas_narenas",  (char*) &show_jemalloc_arenas_narenas,   SHOW_FUNC},
@@ -11408,6 +11485,8 @@ SHOW_VAR status_vars[]= {
   {"Rpl_seconds_delete_rows",  (char*) &repl_event_times[DELETE_ROWS_EVENT],   SHOW_TIMER},
   {"Rpl_seconds_incident",     (char*) &repl_event_times[INCIDENT_EVENT],      SHOW_TIMER},
   {"Compressed_event_cache_hit_ratio", (char*) &comp_event_cache_hit_ratio, SHOW_DOUBLE},
+  {"Binlog_event_ring_hits",   (char*) &show_binlog_event_ring_hits, SHOW_FUNC},
+  {"Binlog_event_ring_misses", (char*) &show_binlog_event_ring_misses, SHOW_FUNC},
   {"Rpl_semi_sync_master_ack_waits",  (char*) &repl_semi_sync_master_ack_waits, SHOW_LONGLONG},
   {"Rpl_last_semi_sync_acked_pos", (char*) &show_last_acked_binlog_pos,
     SHOW_FUNC},
@@ -11522,6 +11601,10 @@ SHOW_VAR status_vars[]= {
    (char*) &show_latency_histogram_group_commit_trx, SHOW_FUNC},
   {"engine_commit_trx_histogram",
    (char*) &show_latency_histogram_engine_commit_trx, SHOW_FUNC},
+  {"binlog_flush_stage_histogram",
+   (char*) &show_latency_histogram_binlog_flush_stage, SHOW_FUNC},
+  {"binlog_sync_stage_histogram",
+   (char*) &show_latency_histogram_binlog_sync_stage, SHOW_FUNC},
   {NullS, NullS, SHOW_LONG}
 };
 
@@ -12651,6 +12734,16 @@ static int get_options(int *argc_ptr, char ***argv_ptr, my_bool logging)
 #else
   if (thread_handling <= SCHEDULER_ONE_THREAD_PER_CONNECTION)
     one_thread_per_connection_scheduler();
+  else if (thread_handling == SCHEDULER_POOL_OF_THREADS)
+  {
+#ifdef HAVE_EPOLL
+    pool_of_threads_scheduler();
+#else
+    sql_print_error("thread_handling=pool-of-threads is not supported on "
+                    "this platform");
+    return 1;
+#endif
+  }
   else                  /* thread_handling == SCHEDULER_NO_THREADS) */
     one_thread_scheduler();
 #endif
@@ -333,6 +333,9 @@ extern my_bool opt_slave_compressed_protocol, use_temp_pool;
 extern my_bool opt_slave_compressed_event_protocol;
 extern ulonglong opt_max_compressed_event_cache_size;
 extern ulonglong opt_compressed_event_cache_evict_threshold;
+extern ulonglong opt_binlog_event_ring_size;
+extern std::atomic<ulonglong> binlog_event_ring_hits;
+extern std::atomic<ulonglong> binlog_event_ring_misses;
 extern ulong opt_slave_compression_lib;
 extern ulonglong opt_slave_dump_thread_wait_sleep_usec;
 extern my_bool rpl_wait_for_semi_sync_ack;
@@ -366,6 +369,7 @@ extern "C" int check_enough_stack_size(int);
 extern my_bool opt_enable_named_pipe, opt_sync_frm, opt_allow_suspicious_udfs;
 extern my_bool opt_secure_auth;
 extern char* opt_secure_file_priv;
+extern char* opt_io_cache_compression_dictionary;
 extern char* opt_secure_backup_file_priv;
 extern size_t opt_secure_backup_file_priv_len;
 extern my_bool opt_log_slow_admin_statements, opt_log_slow_slave_statements;
@@ -1725,6 +1729,8 @@ extern uint mysql_data_home_len;
 extern uint mysql_real_data_home_len;
 extern const char *mysql_real_data_home_ptr;
 extern ulong thread_handling;
+extern uint thread_pool_size;
+extern uint thread_pool_max_threads;
 extern MYSQL_PLUGIN_IMPORT char  *mysql_data_home;
 extern "C" MYSQL_PLUGIN_IMPORT char server_version[SERVER_VERSION_LENGTH];
 extern MYSQL_PLUGIN_IMPORT char mysql_real_data_home[];
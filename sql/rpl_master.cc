@@ -34,6 +34,7 @@
 // stop_handle_slave_stats_daemon, start_handle_slave_stats_daemon
 #include "slave_stats_daemon.h"
 #include <queue>
+#include <deque>
 
 #include "sql_show.h" // schema_table_store_record
 #include "tztime.h" // struct Time_zone
@@ -284,6 +285,155 @@ void free_compressed_event_cache()
   }
 }
 
+/*
+  Ring of the most recent events of the active binlog, shared by all dump
+  threads. The first dump thread to read an event from the file appends it
+  here, dump threads tailing right behind copy it from the ring instead of
+  reading and checksumming it again. Lagging dump threads miss the ring and
+  keep reading the file.
+*/
+struct binlog_ring_event
+{
+  my_off_t pos;
+  std::shared_ptr<uchar> buff;
+  size_t len;
+};
+
+static mysql_rwlock_t LOCK_binlog_event_ring;
+#ifdef HAVE_PSI_INTERFACE
+static PSI_rwlock_key key_LOCK_binlog_event_ring;
+#endif
+
+// events ordered by position, each one ends where the next one starts
+static std::deque<binlog_ring_event> binlog_event_ring;
+// binlog file the events in the ring belong to
+static std::string binlog_event_ring_file;
+// end position of the last event in the ring
+static my_off_t binlog_event_ring_end= 0;
+static size_t binlog_event_ring_bytes= 0;
+static bool binlog_event_ring_inited= false;
+
+static void evict_binlog_ring_events(size_t max_size)
+{
+  while (binlog_event_ring_bytes > max_size && !binlog_event_ring.empty())
+  {
+    binlog_event_ring_bytes-= binlog_event_ring.front().len;
+    binlog_event_ring.pop_front();
+  }
+}
+
+void init_binlog_event_ring()
+{
+  mysql_rwlock_init(key_LOCK_binlog_event_ring, &LOCK_binlog_event_ring);
+  binlog_event_ring_inited= true;
+}
+
+void clear_binlog_event_ring()
+{
+  mysql_rwlock_wrlock(&LOCK_binlog_event_ring);
+  evict_binlog_ring_events(0);
+  binlog_event_ring_file.clear();
+  binlog_event_ring_end= 0;
+  mysql_rwlock_unlock(&LOCK_binlog_event_ring);
+}
+
+void resize_binlog_event_ring()
+{
+  if (!binlog_event_ring_inited)
+    return;
+  mysql_rwlock_wrlock(&LOCK_binlog_event_ring);
+  evict_binlog_ring_events((1 << 20) * opt_binlog_event_ring_size);
+  mysql_rwlock_unlock(&LOCK_binlog_event_ring);
+}
+
+void free_binlog_event_ring()
+{
+  if (binlog_event_ring_inited)
+  {
+    clear_binlog_event_ring();
+    mysql_rwlock_destroy(&LOCK_binlog_event_ring);
+    binlog_event_ring_inited= false;
+  }
+}
+
+/**
+  Look up the event starting at @c pos of @c log_file_name in the ring.
+
+  @return true if found, @c ev then shares the event buffer
+*/
+static bool get_binlog_ring_event(const char *log_file_name, my_off_t pos,
+                                  binlog_ring_event *ev)
+{
+  bool found= false;
+  mysql_rwlock_rdlock(&LOCK_binlog_event_ring);
+  if (!binlog_event_ring.empty() &&
+      pos >= binlog_event_ring.front().pos && pos < binlog_event_ring_end &&
+      binlog_event_ring_file == log_file_name)
+  {
+    auto it= std::lower_bound(binlog_event_ring.begin(),
+                              binlog_event_ring.end(), pos,
+                              [](const binlog_ring_event &e, my_off_t p)
+                              { return e.pos < p; });
+    if (it != binlog_event_ring.end() && it->pos == pos)
+    {
+      *ev= *it;
+      found= true;
+    }
+  }
+  mysql_rwlock_unlock(&LOCK_binlog_event_ring);
+  return found;
+}
+
+/**
+  Whether an event read from the file at @c pos extends the ring. It does
+  when it follows the last event of the ring, or when the reader is ahead
+  of the ring in the active binlog, which then restarts from this event.
+  Lock on the ring must be held.
+*/
+static bool binlog_ring_accepts(const char *log_file_name, my_off_t pos)
+{
+  if (binlog_event_ring_file == log_file_name)
+    return pos >= binlog_event_ring_end;
+  return dump_log.is_active(log_file_name);
+}
+
+static void add_binlog_ring_event(const char *log_file_name, my_off_t pos,
+                                  const char *event, size_t len)
+{
+  const size_t max_size= (1 << 20) * opt_binlog_event_ring_size;
+  if (len > max_size)
+    return;
+
+  // case: lagging reader, don't bother taking the write lock
+  mysql_rwlock_rdlock(&LOCK_binlog_event_ring);
+  bool accepts= binlog_ring_accepts(log_file_name, pos);
+  mysql_rwlock_unlock(&LOCK_binlog_event_ring);
+  if (!accepts)
+    return;
+
+  std::shared_ptr<uchar> buff((uchar*) my_malloc(len, MYF(0)), my_free);
+  if (unlikely(!buff))
+    return;
+  memcpy(buff.get(), event, len);
+
+  mysql_rwlock_wrlock(&LOCK_binlog_event_ring);
+  // another dump thread may have appended this event in the meantime
+  if (binlog_ring_accepts(log_file_name, pos))
+  {
+    if (binlog_event_ring_file != log_file_name ||
+        pos != binlog_event_ring_end)
+    {
+      evict_binlog_ring_events(0);
+      binlog_event_ring_file= log_file_name;
+    }
+    binlog_event_ring.push_back({pos, buff, len});
+    binlog_event_ring_bytes+= len;
+    binlog_event_ring_end= pos + len;
+    evict_binlog_ring_events(max_size);
+  }
+  mysql_rwlock_unlock(&LOCK_binlog_event_ring);
+}
+
 /**
   Populates slave statistics data-point into the slave_lists hash table.
   These stats are sent by slaves to master at regular intervals.
@@ -1980,6 +2130,53 @@ static bool set_dscp(THD *thd) {
   return true;
 }
 
+/**
+  Read the next event of a dump thread, from the shared event ring when
+  it's there, from the binlog file otherwise.
+
+  Takes the same arguments and returns the same values as
+  Log_event::read_log_event().
+*/
+static int read_binlog_event(IO_CACHE *log, String *packet,
+                             uint8 checksum_alg, const char *log_file_name,
+                             bool *is_active_binlog)
+{
+  const my_off_t pos= my_b_tell(log);
+  const size_t ev_offset= packet->length();
+  const bool use_ring= opt_binlog_event_ring_size &&
+    !DBUG_EVALUATE_IF("corrupt_read_log_event", true, false);
+
+  if (use_ring)
+  {
+    binlog_ring_event ev;
+    const size_t max_len=
+      std::max<size_t>(current_thd->variables.max_allowed_packet,
+                  opt_binlog_rows_event_max_size + MAX_LOG_EVENT_HEADER);
+    // Events over max_allowed_packet are read from the file, which reports
+    // the error.
+    if (get_binlog_ring_event(log_file_name, pos, &ev) && ev.len <= max_len)
+    {
+      if (is_active_binlog)
+        *is_active_binlog= dump_log.is_active(log_file_name);
+      if (packet->append((const char*) ev.buff.get(), ev.len))
+        return LOG_READ_MEM;
+      my_b_seek(log, pos + ev.len);
+      ++binlog_event_ring_hits;
+      return 0;
+    }
+  }
+
+  int error= Log_event::read_log_event(log, packet, checksum_alg,
+                                       log_file_name, is_active_binlog);
+  if (use_ring && !error)
+  {
+    ++binlog_event_ring_misses;
+    add_binlog_ring_event(log_file_name, pos, packet->ptr() + ev_offset,
+                          packet->length() - ev_offset);
+  }
+  return error;
+}
+
 void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
                        const Gtid_set* slave_gtid_executed, int flags)
 {
@@ -2495,10 +2692,10 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
       GOTO_ERR;
     bool is_active_binlog= false;
     while (!thd->killed &&
-           !(error= Log_event::read_log_event(&log, packet,
-                                              current_checksum_alg,
-                                              log_file_name,
-                                              &is_active_binlog)))
+           !(error= read_binlog_event(&log, packet,
+                                      current_checksum_alg,
+                                      log_file_name,
+                                      &is_active_binlog)))
     {
       DBUG_EXECUTE_IF("simulate_dump_thread_kill",
                       {
@@ -2928,9 +3125,9 @@ void mysql_binlog_send(THD* thd, char* log_ident, my_off_t pos,
           has not been updated since last read.
 	*/
 
-        switch (error= Log_event::read_log_event(&log, packet,
-                                                 current_checksum_alg,
-                                                 log_file_name)) {
+        switch (error= read_binlog_event(&log, packet,
+                                         current_checksum_alg,
+                                         log_file_name, NULL)) {
 	case 0:
           DBUG_PRINT("info", ("read_log_event returned 0 on line %d",
                               __LINE__));
@@ -3690,6 +3887,9 @@ int reset_master(THD* thd, bool force)
   if (mysql_bin_log.reset_logs(thd))
     return 1;
 
+  // binlog file names are reused from the start
+  clear_binlog_event_ring();
+
   // semi-sync is called only when raft is disabled
   if (!enable_raft_plugin)
     (void) RUN_HOOK(binlog_transmit, after_reset_master, (thd, 0 /* flags */));
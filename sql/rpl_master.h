@@ -73,6 +73,10 @@ void end_slave_list();
 void init_compressed_event_cache();
 void clear_compressed_event_cache();
 void free_compressed_event_cache();
+void init_binlog_event_ring();
+void clear_binlog_event_ring();
+void resize_binlog_event_ring();
+void free_binlog_event_ring();
 bool is_semi_sync_slave(THD *thd);
 int store_replica_stats(THD *thd, uchar *packet, uint packet_length);
 int get_current_replication_lag();
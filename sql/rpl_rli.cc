@@ -188,7 +188,10 @@ Relay_log_info::Relay_log_info(bool is_slave_recovery
   recovery_sid_map= new Sid_map(recovery_sid_lock);
 
   mysql_mutex_init(0, &dep_lock, MY_MUTEX_INIT_FAST);
-  mysql_mutex_init(0, &dep_key_lookup_mutex, MY_MUTEX_INIT_FAST);
+  for (auto& queue : dep_queues)
+    mysql_mutex_init(0, &queue.lock, MY_MUTEX_INIT_FAST);
+  for (auto& shard : dep_key_lookup)
+    mysql_mutex_init(0, &shard.lock, MY_MUTEX_INIT_FAST);
   mysql_cond_init(0, &dep_full_cond, NULL);
   mysql_cond_init(0, &dep_empty_cond, NULL);
   mysql_cond_init(0, &dep_trx_all_done_cond, NULL);
@@ -261,7 +264,10 @@ Relay_log_info::~Relay_log_info()
   recovery_sid_map= NULL;
 
   mysql_mutex_destroy(&dep_lock);
-  mysql_mutex_destroy(&dep_key_lookup_mutex);
+  for (auto& queue : dep_queues)
+    mysql_mutex_destroy(&queue.lock);
+  for (auto& shard : dep_key_lookup)
+    mysql_mutex_destroy(&shard.lock);
   mysql_cond_destroy(&dep_full_cond);
   mysql_cond_destroy(&dep_empty_cond);
 
@@ -31,6 +31,7 @@
 #endif // HAVE_REPLICATION and !MYSQL_CLIENT
 
 #include <atomic>
+#include <bitset>
 #include <deque>
 
 struct RPL_TABLE_LIST;
@@ -1157,14 +1158,43 @@ public:
   ulong mts_dependency_order_commits= 0;
   ulonglong mts_dependency_cond_wait_timeout= 0;
 
-  std::deque<std::shared_ptr<Log_event_wrapper>> dep_queue;
+  /* Recycles the wrappers of scheduled events, must outlive all of them */
+  Log_event_wrapper_pool dep_event_pool;
+
+  /* Number of shards of the key lookup, must be a power of two */
+  static constexpr uint DEP_KEY_LOOKUP_SHARDS= 16;
+  /* Upper bound on the number of begin event queues */
+  static constexpr uint DEP_MAX_QUEUES= 16;
+
+  /* One begin event queue, events are tagged with their enqueue sequence */
+  struct Dep_queue
+  {
+    mysql_mutex_t lock;
+    std::deque<std::pair<ulonglong, std::shared_ptr<Log_event_wrapper>>>
+                                            events;
+  };
+
+  /* Begin events are spread round-robin over the first @dep_num_queues
+     queues, workers pop from their own queue and steal from the others */
+  Dep_queue dep_queues[DEP_MAX_QUEUES];
+  uint dep_num_queues= 1;
+  /* Sequence of the next enqueued trx, only touched by the coordinator */
+  ulonglong dep_enqueue_seq= 0;
+  /* Sequence of the next trx to dequeue when commits are ordered */
+  std::atomic<ulonglong> dep_dequeue_seq{0};
+  /* Total number of trxs in all the queues */
+  std::atomic<ulonglong> dep_queue_size{0};
   mysql_mutex_t dep_lock;
 
-  /* Mapping from key to penultimate (for multi event trx)/end event of the
-     last trx that updated that table */
-  std::unordered_map<Dependency_key, std::shared_ptr<Log_event_wrapper>>
-                                            dep_key_lookup;
-  mysql_mutex_t dep_key_lookup_mutex;
+  /* One shard of the mapping from key to penultimate (for multi event
+     trx)/end event of the last trx that updated that table */
+  struct Dep_key_lookup_shard
+  {
+    mysql_mutex_t lock;
+    std::unordered_map<Dependency_key, std::shared_ptr<Log_event_wrapper>>
+                                            keys;
+  };
+  Dep_key_lookup_shard dep_key_lookup[DEP_KEY_LOOKUP_SHARDS];
 
   /* Set of keys accessed by the group */
   std::unordered_set<Dependency_key> keys_accessed_by_group;
@@ -1177,11 +1207,11 @@ public:
 
   // Mutex-condition pair to notify when queue is/is not full
   mysql_cond_t dep_full_cond;
-  bool dep_full= false;
+  std::atomic<bool> dep_full{false};
 
   // Mutex-condition pair to notify when queue is/is not empty
   mysql_cond_t dep_empty_cond;
-  ulonglong num_workers_waiting= 0;
+  std::atomic<ulonglong> num_workers_waiting{0};
 
   std::shared_ptr<Log_event_wrapper> prev_event;
   std::unordered_map<ulonglong, Table_map_log_event *> table_map_events;
@@ -1193,7 +1223,9 @@ public:
   std::atomic<bool> dependency_worker_error{false};
 
   mysql_cond_t dep_trx_all_done_cond;
-  ulonglong num_in_flight_trx= 0;
+  // Incremented by the coordinator without @dep_lock, decremented by workers
+  // under @dep_lock
+  std::atomic<ulonglong> num_in_flight_trx{0};
   ulonglong num_events_in_current_group= 0;
 
   // Statistics
@@ -1213,21 +1245,71 @@ public:
       ++num_syncs;
   }
 
+  static uint dep_key_shard(const Dependency_key &key)
+  {
+    return std::hash<Dependency_key>()(key) & (DEP_KEY_LOOKUP_SHARDS - 1);
+  }
+
+  /* Set of the key lookup shards covering @keys */
+  template <class Keys>
+  static std::bitset<DEP_KEY_LOOKUP_SHARDS> dep_key_shards(const Keys &keys)
+  {
+    std::bitset<DEP_KEY_LOOKUP_SHARDS> shards;
+    for (const auto& key : keys)
+      shards.set(dep_key_shard(key));
+    return shards;
+  }
+
+  /* Locks the key lookup shards covering @keys in shard order, returns the
+     set of locked shards that must be passed to @unlock_dep_key_shards */
+  template <class Keys>
+  std::bitset<DEP_KEY_LOOKUP_SHARDS> lock_dep_key_shards(const Keys &keys)
+  {
+    const auto shards= dep_key_shards(keys);
+    lock_dep_key_shard_set(shards);
+    return shards;
+  }
+
+  /* Locks @shards in shard order */
+  void lock_dep_key_shard_set(const std::bitset<DEP_KEY_LOOKUP_SHARDS> &shards)
+  {
+    for (uint i= 0; i < DEP_KEY_LOOKUP_SHARDS; ++i)
+      if (shards.test(i))
+        mysql_mutex_lock(&dep_key_lookup[i].lock);
+  }
+
+  void unlock_dep_key_shards(const std::bitset<DEP_KEY_LOOKUP_SHARDS> &shards)
+  {
+    for (uint i= 0; i < DEP_KEY_LOOKUP_SHARDS; ++i)
+      if (shards.test(i))
+        mysql_mutex_unlock(&dep_key_lookup[i].lock);
+  }
+
+  bool dep_key_lookup_empty() const
+  {
+    for (const auto& shard : dep_key_lookup)
+      if (!shard.keys.empty())
+        return false;
+    return true;
+  }
+
+  /* Called by the coordinator, does not need @dep_lock */
   bool enqueue_dep(
       const std::shared_ptr<Log_event_wrapper> &begin_event)
   {
-    mysql_mutex_assert_owner(&dep_lock);
-    dep_queue.push_back(begin_event);
+    const ulonglong seq= dep_enqueue_seq++;
+    auto& queue= dep_queues[seq % dep_num_queues];
+    mysql_mutex_lock(&queue.lock);
+    queue.events.emplace_back(seq, begin_event);
+    mysql_mutex_unlock(&queue.lock);
+    ++dep_queue_size;
     return true;
   }
 
-  std::shared_ptr<Log_event_wrapper> dequeue_dep()
+  bool dep_below_refill_threshold() const
   {
-    mysql_mutex_assert_owner(&dep_lock);
-    if (dep_queue.empty()) { return nullptr; }
-    auto ret= dep_queue.front();
-    dep_queue.pop_front();
-    return ret;
+    return dep_queue_size <
+           mts_dependency_size * mts_dependency_refill_threshold / 100;
   }
 
   void cleanup_group(std::shared_ptr<Log_event_wrapper> begin_event)
@@ -1256,11 +1338,23 @@ public:
     if (need_dep_lock)
       mysql_mutex_lock(&dep_lock);
 
-    DBUG_ASSERT(num_in_flight_trx >= dep_queue.size());
-    num_in_flight_trx -= dep_queue.size();
-    for (const auto& begin_event : dep_queue)
-      cleanup_group(begin_event);
-    dep_queue.clear();
+    for (uint i= 0; i < dep_num_queues; ++i)
+      mysql_mutex_lock(&dep_queues[i].lock);
+    for (uint i= 0; i < dep_num_queues; ++i)
+    {
+      auto& events= dep_queues[i].events;
+      DBUG_ASSERT(num_in_flight_trx >= events.size());
+      num_in_flight_trx -= events.size();
+      dep_queue_size -= events.size();
+      for (const auto& event : events)
+        cleanup_group(event.second);
+      events.clear();
+    }
+    DBUG_ASSERT(dep_queue_size == 0);
+    dep_enqueue_seq= 0;
+    dep_dequeue_seq= 0;
+    for (uint i= 0; i < dep_num_queues; ++i)
+      mysql_mutex_unlock(&dep_queues[i].lock);
 
     prev_event.reset();
     current_begin_event.reset();
@@ -1275,9 +1369,12 @@ public:
 
     dep_full= false;
 
-    mysql_mutex_lock(&dep_key_lookup_mutex);
-    dep_key_lookup.clear();
-    mysql_mutex_unlock(&dep_key_lookup_mutex);
+    for (auto& shard : dep_key_lookup)
+    {
+      mysql_mutex_lock(&shard.lock);
+      shard.keys.clear();
+      mysql_mutex_unlock(&shard.lock);
+    }
 
     trx_queued= false;
     num_events_in_current_group= 0;
@@ -6903,7 +6903,7 @@ void slave_stop_workers(Relay_log_info *rli, bool *mts_inited)
       // care about partial trx that has been pulled by a worker, since the
       // queue is going to be emptied next anyway, we make this check by
       // checking of the queue is empty
-      partial= rli->dep_queue.empty() && rli->trx_queued;
+      partial= rli->dep_queue_size == 0 && rli->trx_queued;
       // let's cleanup, we can clear the queue in this case
       rli->clear_dep(false);
     }
@@ -7106,6 +7106,9 @@ pthread_handler_t handle_slave_sql(void *arg)
   rli->mts_dependency_max_keys= opt_mts_dependency_max_keys;
   rli->mts_dependency_order_commits= opt_mts_dependency_order_commits;
   rli->mts_dependency_cond_wait_timeout= opt_mts_dependency_cond_wait_timeout;
+  rli->dep_num_queues=
+    std::max(1UL, std::min<ulong>(rli->opt_slave_parallel_workers,
+                                  Relay_log_info::DEP_MAX_QUEUES));
 
   if (rli->mts_dependency_replication &&
       !slave_use_idempotent_for_recovery_options)
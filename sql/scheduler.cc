@@ -132,6 +132,21 @@ void one_thread_per_connection_scheduler()
 }
 #endif
 
+/*
+  Initialize scheduler for --thread-handling=pool-of-threads
+*/
+
+#if defined(HAVE_EPOLL) && !defined(EMBEDDED_LIBRARY)
+extern scheduler_functions pool_of_threads_scheduler_functions;
+
+void pool_of_threads_scheduler()
+{
+  scheduler_init();
+  pool_of_threads_scheduler_functions.max_threads= max_connections;
+  thread_scheduler= &pool_of_threads_scheduler_functions;
+}
+#endif
+
 /*
   Initailize scheduler for --thread-handling=no-threads
 */
@@ -62,11 +62,15 @@ enum scheduler_types
   */
   SCHEDULER_ONE_THREAD_PER_CONNECTION=0,
   SCHEDULER_NO_THREADS,
+  SCHEDULER_POOL_OF_THREADS,
   SCHEDULER_TYPES_COUNT
 };
 
 void one_thread_per_connection_scheduler();
 void one_thread_scheduler();
+#if defined(HAVE_EPOLL) && !defined(EMBEDDED_LIBRARY)
+void pool_of_threads_scheduler();
+#endif
 
 /*
  To be used for pool-of-threads (implemeneted differently on various OSs)
@@ -1845,6 +1845,8 @@ void THD::release_resources()
   mutex_assert_not_owner_shard(SHARDED(&LOCK_thread_count), this);
   DBUG_ASSERT(m_release_resources_done == false);
 
+  flush_thd_sql_stats(this);
+
   if (variables.sql_stats_snapshot)
     toggle_sql_stats_snapshot(this);
 
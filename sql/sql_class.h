@@ -2611,6 +2611,8 @@ public:
   ulonglong semisync_ack_time = 0;
   /* record the engine commit time */
   ulonglong engine_commit_time = 0;
+  /* storage engine perf context of the statement, for the slow query log */
+  std::string engine_perf_context;
 
   /* record the bytes written into binlog by the transaction */
   ulonglong trx_bytes_written = 0;
@@ -2769,6 +2771,25 @@ public:
     should_update_stats = false;
   }
 
+  /*
+    Stats of statements whose SQL_STATISTICS entry already exists, merged
+    into global_sql_stats in batches by flush_thd_sql_stats() rather than
+    taking LOCK_global_sql_stats for every statement. Protected by
+    LOCK_thd_data.
+  */
+  struct Pending_sql_stats {
+    SHARED_SQL_STATS shared_stats;
+    ulonglong count;
+    ulonglong skipped_count;
+    uint query_sample_seen;
+    bool dirty;
+  };
+  std::unordered_map<md5_key, Pending_sql_stats> pending_sql_stats;
+  /* Value of sql_stats_epoch when the pending stats were started */
+  ulonglong pending_sql_stats_epoch = 0;
+  /* When the pending stats were last flushed */
+  uint pending_sql_stats_flushed = 0;
+
 /*end stats tracking*/
 
 public:
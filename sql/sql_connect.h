@@ -42,6 +42,7 @@ bool setup_connection_thread_globals(THD *thd);
 bool thd_prepare_connection(THD *thd);
 bool thd_is_connection_alive(THD *thd);
 void thd_update_net_stats(THD* thd);
+void set_conn_timeout_err(THD *thd, char *msg_buf);
 
 int check_user(THD *thd, enum enum_server_command command,
 	       const char *passwd, uint passwd_len, const char *db,
@@ -20,6 +20,8 @@
 #include "sql_show.h"
 #include "sql_multi_tenancy.h"
 #include "global_threads.h"
+#include "scheduler.h"
+#include "sql_callback.h"
 #include "handler.h"
 #include "m_string.h"
 
@@ -620,16 +622,34 @@ Ac_result AC::admission_control_enter(THD *thd,
   Ac_result res = Ac_result::AC_ADMITTED;
   const char* prev_proc_info = thd->proc_info;
   THD_STAGE_INFO(thd, stage_admission_control_enter);
+
+  const ulong max_running = max_running_queries;
+  if (!max_running) {
+    thd->proc_info = prev_proc_info;
+    return res;
+  }
+
+  auto &ac_info = thd->ac_node->ac_info;
+  thd->ac_node->queue = get_queue(thd);
+
+  // Fast path: if nobody is waiting and we are below the max running limit
+  // then take a slot without any lock.
+  if (ac_info->waiting_queries == 0 &&
+      try_take_slot(ac_info.get(), max_running)) {
+    ++ac_info->queues[thd->ac_node->queue].running_queries;
+    DBUG_ASSERT(!thd->ac_node->running);
+    thd->ac_node->running = true;
+    thd->proc_info = prev_proc_info;
+    return res;
+  }
+
   // Unlock this before waiting.
   mysql_rwlock_rdlock(&LOCK_ac);
   if (max_running_queries) {
-    auto ac_info = thd->ac_node->ac_info;
-    thd->ac_node->queue = get_queue(thd);
     mysql_mutex_lock(&ac_info->lock);
 
-    if (ac_info->running_queries < max_running_queries) {
+    if (try_take_slot(ac_info.get(), max_running_queries)) {
       // We are below the max running limit.
-      ++ac_info->running_queries;
       ++ac_info->queues[thd->ac_node->queue].running_queries;
       DBUG_ASSERT(!thd->ac_node->running);
       thd->ac_node->running = true;
@@ -643,8 +663,19 @@ Ac_result AC::admission_control_enter(THD *thd,
       res = Ac_result::AC_ABORTED;
     }
     else {
-      bool timeout;
+      bool timeout = false;
       enqueue(thd, ac_info, mode);
+
+      // A query may have exited on the fast path after we failed to take a
+      // slot above but before it could see us waiting, so check again.
+      // NOTE: waiting_queries is incremented before running_queries is read
+      // here, admission_control_exit() does the opposite.
+      if (try_take_slot(ac_info.get(), max_running_queries)) {
+        dequeue(thd, ac_info);
+        ++ac_info->queues[thd->ac_node->queue].running_queries;
+        DBUG_ASSERT(!thd->ac_node->running);
+        thd->ac_node->running = true;
+      }
       /**
         Inserting or deleting in std::map will not invalidate existing
         iterators except of course if the current iterator is erased. If the
@@ -655,7 +686,7 @@ Ac_result AC::admission_control_enter(THD *thd,
         is that waiting queries here shouldn't block other operations
         modifying ac_map or max_running_queries/max_waiting_queries.
       */
-      while (true) {
+      while (!thd->ac_node->running) {
         mysql_rwlock_unlock(&LOCK_ac);
         timeout = wait_for_signal(thd, thd->ac_node, ac_info, mode);
         // Retake locks in correct lock order.
@@ -734,6 +765,10 @@ bool AC::wait_for_signal(THD *thd, std::shared_ptr<st_ac_node> &ac_node,
     ? &stage_waiting_for_readmission : &stage_waiting_for_admission;
   thd->ENTER_COND(&ac_node->cond, &ac_node->lock,
                                   stage, &old_stage);
+  // Let a pooled scheduler run other connections while this one is queued.
+  // The scheduler hook is called directly, thd_wait_begin() would try to
+  // exit admission control again.
+  MYSQL_CALLBACK(thread_scheduler, thd_wait_begin, (thd, THD_WAIT_USER_LOCK));
 
   if (thd->variables.admission_control_queue_timeout == 0) {
     // Don't bother waiting if timeout is 0.
@@ -749,6 +784,7 @@ bool AC::wait_for_signal(THD *thd, std::shared_ptr<st_ac_node> &ac_node,
     res = mysql_cond_timedwait(&ac_node->cond, &ac_node->lock, &wait_timeout);
     DBUG_ASSERT(res == 0 || res == ETIMEDOUT);
   }
+  MYSQL_CALLBACK(thread_scheduler, thd_wait_end, (thd));
   thd->EXIT_COND(&old_stage);
 
   return res == ETIMEDOUT;
@@ -768,16 +804,27 @@ void AC::admission_control_exit(THD* thd) {
   const char* prev_proc_info = thd->proc_info;
   THD_STAGE_INFO(thd, stage_admission_control_exit);
 
-  auto ac_info = thd->ac_node->ac_info;
-  mysql_rwlock_rdlock(&LOCK_ac);
-  mysql_mutex_lock(&ac_info->lock);
+  auto &ac_info = thd->ac_node->ac_info;
 
-  DBUG_ASSERT(ac_info->running_queries > 0);
-  --ac_info->running_queries;
   DBUG_ASSERT(ac_info->queues[thd->ac_node->queue].running_queries > 0);
   --ac_info->queues[thd->ac_node->queue].running_queries;
   thd->ac_node->running = false;
 
+  // NOTE: running_queries is decremented before waiting_queries is read
+  // here, admission_control_enter() does the opposite, so that either we
+  // see the waiting query or it sees the free slot.
+  DBUG_ASSERT(ac_info->running_queries > 0);
+  --ac_info->running_queries;
+
+  // Fast path: nobody to signal.
+  if (ac_info->waiting_queries == 0) {
+    thd->proc_info = prev_proc_info;
+    return;
+  }
+
+  mysql_rwlock_rdlock(&LOCK_ac);
+  mysql_mutex_lock(&ac_info->lock);
+
   // Assert that max_running_queries == 0 implies no waiting queries.
   DBUG_ASSERT(max_running_queries != 0 || ac_info->waiting_queries == 0);
 
@@ -791,24 +838,26 @@ void AC::admission_control_exit(THD* thd) {
   // We calculate a score for all queues that have waiting queries, and pick
   // the queue with the minimum score. In case of ties, we arbitrarily pick
   // the first encountered queue.
-  if (ac_info->waiting_queries > 0 && ac_info->running_queries < max_running_queries) {
-    double min_score = std::numeric_limits<double>::max();
+  //
+  // Slots freed on the fast path by queries that didn't see waiting queries
+  // are handed out here too, so keep going while slots are available.
+  while (ac_info->waiting_queries > 0 &&
+         try_take_slot(ac_info.get(), max_running_queries)) {
+    ulong min_score = std::numeric_limits<ulong>::max();
     ulong min_queue = 0;
 #ifndef DBUG_OFF
-    ulong running_queries_sum = 0;
     ulong waiting_queries_sum = 0;
 #endif
 
     for (ulong i = 0; i < MAX_AC_QUEUES; i++) {
+      // Skip queues that don't have waiting queries.
+      if (!ac_info->waiting_queues.test(i)) continue;
+
       const auto& queue = ac_info->queues[i];
 #ifndef DBUG_OFF
-      running_queries_sum += queue.running_queries;
       waiting_queries_sum += queue.waiting_queries();
 #endif
-      // Skip queues that don't have waiting queries.
-      if (queue.waiting_queries() == 0) continue;
-
-      double score = queue.running_queries / (weights[i] ? weights[i] : 1);
+      ulong score = queue.running_queries / (weights[i] ? weights[i] : 1);
 
       if (score < min_score) {
         min_queue = i;
@@ -817,10 +866,9 @@ void AC::admission_control_exit(THD* thd) {
     }
 
     DBUG_ASSERT(ac_info->waiting_queries == waiting_queries_sum);
-    DBUG_ASSERT(ac_info->running_queries == running_queries_sum);
 
     auto& candidate = ac_info->queues[min_queue].queue.front();
-    dequeue_and_run(candidate->thd, ac_info);
+    dequeue_and_run(candidate->thd, ac_info, true /* slot_taken */);
   }
 
   mysql_mutex_unlock(&ac_info->lock);
@@ -848,6 +896,7 @@ void AC::enqueue(THD *thd, std::shared_ptr<Ac_info> ac_info, enum_admission_cont
     ac_node->pos = --ac_info->queues[queue].queue.end();
   }
   ac_node->queued = true;
+  ac_info->waiting_queues.set(queue);
   ++ac_info->waiting_queries;
 }
 
@@ -862,7 +911,10 @@ void AC::dequeue(THD *thd, std::shared_ptr<Ac_info> ac_info) {
   auto& ac_node = thd->ac_node;
 
   DBUG_ASSERT(ac_node->queued);
-  ac_info->queues[ac_node->queue].queue.erase(ac_node->pos);
+  auto& queue = ac_info->queues[ac_node->queue];
+  queue.queue.erase(ac_node->pos);
+  if (queue.queue.empty())
+    ac_info->waiting_queues.reset(ac_node->queue);
   ac_node->queued = false;
   --ac_info->waiting_queries;
 }
@@ -870,16 +922,20 @@ void AC::dequeue(THD *thd, std::shared_ptr<Ac_info> ac_info) {
 /*
  * @param thd THD
  * @param ac_info AC info
+ * @param slot_taken whether ac_info->running_queries was already incremented
+ *                   for thd by the caller, see AC::try_take_slot()
  *
  * Dequeues thd from its queue. Sets its state to running, and signals
  * that thread to start running.
  */
-void AC::dequeue_and_run(THD *thd, std::shared_ptr<Ac_info> ac_info) {
+void AC::dequeue_and_run(THD *thd, std::shared_ptr<Ac_info> ac_info,
+                         bool slot_taken) {
   mysql_mutex_assert_owner(&ac_info->lock);
 
   dequeue(thd, ac_info);
 
-  ++ac_info->running_queries;
+  if (!slot_taken)
+    ++ac_info->running_queries;
   ++ac_info->queues[thd->ac_node->queue].running_queries;
   DBUG_ASSERT(!thd->ac_node->running);
   thd->ac_node->running = true;
@@ -1051,7 +1107,7 @@ int fill_ac_queue(THD *thd, TABLE_LIST *tables, Item *) {
       const auto& q = ac_info->queues[i];
 
       auto waiting = q.waiting_queries();
-      auto running = q.running_queries;
+      auto running = q.running_queries.load();
       auto timeout = q.timeout_queries;
       auto aborted = q.aborted_queries;
       // Skip queues with no waiting/running queries.
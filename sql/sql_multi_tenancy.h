@@ -23,6 +23,8 @@
 #include <mysql/plugin_multi_tenancy.h>
 #include "sql_class.h"
 
+#include <atomic>
+#include <bitset>
 #include <list>
 
 /*
@@ -111,8 +113,8 @@ struct Ac_queue {
   inline size_t waiting_queries() const {
     return queue.size();
   }
-  // Track number of running queries.
-  unsigned long running_queries = 0;
+  // Track number of running queries, also updated without Ac_info::lock.
+  std::atomic<unsigned long> running_queries{0};
   // Track number of rejected queries.
   unsigned long aborted_queries = 0;
   // Track number of timed out queries.
@@ -137,10 +139,14 @@ class Ac_info {
   // Entity name used as key in ac_info map.
   std::string entity;
 
-  // Count for waiting queries in queues for this Ac_info.
-  unsigned long waiting_queries = 0;
-  // Count for running queries in queues for this Ac_info.
-  unsigned long running_queries = 0;
+  // Count for waiting queries in queues for this Ac_info. Only modified
+  // under lock, but read without it on the admission fast path.
+  std::atomic<unsigned long> waiting_queries{0};
+  // Count for running queries in queues for this Ac_info. Slots are taken
+  // with a CAS so that queries below the limit don't need lock.
+  std::atomic<unsigned long> running_queries{0};
+  // Bit i is set iff queues[i] has waiting queries. Protected by lock.
+  std::bitset<MAX_AC_QUEUES> waiting_queues;
   // Count for rejected queries in queues for this Ac_info.
   unsigned long aborted_queries = 0;
   // Count for timed out queries in queues for this Ac_info.
@@ -186,9 +192,10 @@ class AC {
 
   // This map is protected by the rwlock LOCK_ac.
   std::unordered_map<std::string, std::shared_ptr<Ac_info>> ac_map;
-  // Variables to track global limits
-  ulong max_running_queries;
-  ulong max_waiting_queries;
+  // Variables to track global limits. The query limits are read without
+  // LOCK_ac, but only modified under it.
+  std::atomic<ulong> max_running_queries;
+  std::atomic<ulong> max_waiting_queries;
   ulong max_connections;
 
   std::array<unsigned long, MAX_AC_QUEUES> weights{};
@@ -284,18 +291,27 @@ public:
     mysql_rwlock_unlock(&LOCK_ac);
   }
 
-  inline ulong get_max_running_queries() {
-    mysql_rwlock_rdlock(&LOCK_ac);
-    ulong res = max_running_queries;
-    mysql_rwlock_unlock(&LOCK_ac);
-    return res;
+  inline ulong get_max_running_queries() const {
+    return max_running_queries;
   }
 
-  inline ulong get_max_waiting_queries() {
-    mysql_rwlock_rdlock(&LOCK_ac);
-    ulong res = max_waiting_queries;
-    mysql_rwlock_unlock(&LOCK_ac);
-    return res;
+  inline ulong get_max_waiting_queries() const {
+    return max_waiting_queries;
+  }
+
+  /**
+    Takes a running slot for ac_info if it is below max_running, without
+    taking any lock.
+
+    @return true if the slot was taken
+  */
+  static inline bool try_take_slot(Ac_info *ac_info, ulong max_running) {
+    ulong running = ac_info->running_queries;
+    while (running < max_running) {
+      if (ac_info->running_queries.compare_exchange_weak(running, running + 1))
+        return true;
+    }
+    return false;
   }
 
   Ac_result admission_control_enter(THD *, enum_admission_control_request_mode);
@@ -304,7 +320,8 @@ public:
                        std::shared_ptr<Ac_info> ac_info, enum_admission_control_request_mode);
   static void enqueue(THD *thd, std::shared_ptr<Ac_info> ac_info, enum_admission_control_request_mode);
   static void dequeue(THD *thd, std::shared_ptr<Ac_info> ac_info);
-  static void dequeue_and_run(THD *thd, std::shared_ptr<Ac_info> ac_info);
+  static void dequeue_and_run(THD *thd, std::shared_ptr<Ac_info> ac_info,
+                              bool slot_taken = false);
 
   Ac_result add_connection(THD *, const char *);
   void close_connection(THD*);
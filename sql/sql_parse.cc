@@ -7966,6 +7966,7 @@ void THD::reset_for_next_command()
   thd->set_trans_pos(NULL, 0, NULL);
   thd->m_gap_lock_log_written= false;
   thd->m_fb_json_functions_audited = 0;
+  thd->engine_perf_context.clear();
 
   if (unlikely(!thd->prepared_engine))
     thd->prepared_engine= new engine_lsn_map();
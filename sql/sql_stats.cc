@@ -8,8 +8,10 @@
 #include "structs.h"
 #include "tztime.h"                             // struct Time_zone
 #include "rpl_master.h"                         // get_current_replication_lag
+#include "global_threads.h"
 #include <mysql/plugin_rim.h>
 #include <handler.h>
+#include <atomic>
 
 /* Global map to track the number of active identical sql statements */
 static std::unordered_map<md5_key, uint> global_active_sql;
@@ -1695,6 +1697,20 @@ ulonglong max_sql_stats_size;
 ulonglong sql_stats_count= 0;
 ulonglong sql_stats_size= 0; // extern from mysqld.h
 
+/*
+  Incremented, under LOCK_global_sql_stats, whenever global_sql_stats entries
+  are freed or moved to a snapshot. Stats pending in a THD are dropped if the
+  epoch changed since they were started.
+*/
+static std::atomic<ulonglong> sql_stats_epoch{0};
+
+/*
+  Pending stats in a THD are merged into global_sql_stats at least this often
+  (in seconds), and at most this many distinct entries are kept per THD.
+*/
+static const uint PENDING_SQL_STATS_FLUSH_INTERVAL = 1;
+static const size_t PENDING_SQL_STATS_MAX_ENTRIES = 64;
+
 /*
   These are used to determine if existing stats need to be flushed on changing
   the limits.
@@ -2209,6 +2225,7 @@ void free_global_sql_stats(bool limits_updated)
   }
 
   free_sql_stats_maps(global_sql_stats);
+  ++sql_stats_epoch;
 
   sql_stats_count = 0;
   sql_stats_size = 0;
@@ -2362,6 +2379,136 @@ void store_sql_findings(THD *thd, const char *query_text, int query_length) {
                 End - Functions to support SQL findings
 ************************************************************************/
 
+/*
+  add_shared_sql_stats
+    Adds up the per-statement counters of two SHARED_SQL_STATS.
+*/
+static void add_shared_sql_stats(SHARED_SQL_STATS *to,
+                                 const SHARED_SQL_STATS *from)
+{
+  to->rows_sent += from->rows_sent;
+  to->tmp_table_bytes_written += from->tmp_table_bytes_written;
+  to->filesort_bytes_written += from->filesort_bytes_written;
+  to->index_dive_count += from->index_dive_count;
+  to->index_dive_cpu += from->index_dive_cpu;
+  to->compilation_cpu += from->compilation_cpu;
+  to->tmp_table_disk_usage += from->tmp_table_disk_usage;
+  to->filesort_disk_usage += from->filesort_disk_usage;
+
+  // Update CPU stats
+  to->stmt_cpu_utime += from->stmt_cpu_utime;
+
+  // Update elapsed time
+  to->stmt_elapsed_utime += from->stmt_elapsed_utime;
+
+  // Update Row counts
+  to->rows_inserted += from->rows_inserted;
+  to->rows_updated += from->rows_updated;
+  to->rows_deleted += from->rows_deleted;
+  to->rows_read += from->rows_read;
+}
+
+/*
+  add_sql_stats
+    Adds the stats of a statement to a SQL_STATS entry.
+*/
+static void add_sql_stats(SQL_STATS *sql_stats, const SHARED_SQL_STATS *stats,
+                          bool statement_completed, bool skipped)
+{
+  add_shared_sql_stats(&sql_stats->shared_stats, stats);
+
+  if (statement_completed) {
+    sql_stats->count++;
+    if (skipped)
+      sql_stats->skipped_count++;
+  }
+}
+
+/*
+  add_pending_sql_stats
+    Accumulates the stats of a statement in the THD if the statement's
+    SQL_STATISTICS entry is known to exist and doesn't need a new sample.
+    Pending stats are flushed once they get old.
+  Returns: true if the stats were accumulated, false if global_sql_stats
+    must be updated directly.
+*/
+static bool add_pending_sql_stats(THD *thd, const md5_key &key,
+                                  const SHARED_SQL_STATS *stats,
+                                  bool statement_completed, bool skipped,
+                                  uint time_now)
+{
+  bool added = false;
+  bool flush = false;
+
+  mysql_mutex_lock(&thd->LOCK_thd_data);
+  if (thd->pending_sql_stats_epoch != sql_stats_epoch)
+  {
+    /* Global stats were freed or moved since, so is our knowledge */
+    thd->pending_sql_stats.clear();
+  }
+  else
+  {
+    auto iter = thd->pending_sql_stats.find(key);
+    if (iter != thd->pending_sql_stats.end() &&
+        !(max_digest_sample_age > 0 &&
+          time_now - iter->second.query_sample_seen > max_digest_sample_age))
+    {
+      THD::Pending_sql_stats &pending = iter->second;
+      add_shared_sql_stats(&pending.shared_stats, stats);
+      if (statement_completed) {
+        pending.count++;
+        if (skipped)
+          pending.skipped_count++;
+      }
+      pending.dirty = true;
+      added = true;
+    }
+
+    flush = time_now - thd->pending_sql_stats_flushed >=
+            PENDING_SQL_STATS_FLUSH_INTERVAL;
+    DBUG_EXECUTE_IF("skip_pending_sql_stats_flush", flush = false;);
+  }
+  mysql_mutex_unlock(&thd->LOCK_thd_data);
+
+  if (flush)
+  {
+    flush_thd_sql_stats(thd);
+    thd->pending_sql_stats_flushed = time_now;
+  }
+
+  return added;
+}
+
+/*
+  remember_sql_stats_entry
+    Records in the THD that the SQL_STATISTICS entry of a statement exists,
+    so the stats of its next executions can be accumulated locally.
+*/
+static void remember_sql_stats_entry(THD *thd, const md5_key &key,
+                                     ulonglong epoch, uint query_sample_seen,
+                                     uint time_now)
+{
+  mysql_mutex_lock(&thd->LOCK_thd_data);
+  if (thd->pending_sql_stats_epoch != epoch)
+  {
+    thd->pending_sql_stats.clear();
+    thd->pending_sql_stats_epoch = epoch;
+    thd->pending_sql_stats_flushed = time_now;
+  }
+
+  auto iter = thd->pending_sql_stats.find(key);
+  if (iter != thd->pending_sql_stats.end())
+    iter->second.query_sample_seen = query_sample_seen;
+  else if (thd->pending_sql_stats.size() < PENDING_SQL_STATS_MAX_ENTRIES)
+  {
+    THD::Pending_sql_stats pending = {};
+    pending.shared_stats.reset();
+    pending.query_sample_seen = query_sample_seen;
+    thd->pending_sql_stats.emplace(key, pending);
+  }
+  mysql_mutex_unlock(&thd->LOCK_thd_data);
+}
+
 /*
   update_sql_stats_for_statement
     Updates the SQL stats for every SQL statement. The function is invoked
@@ -2411,6 +2558,16 @@ void update_sql_stats_for_statement(THD *thd, SHARED_SQL_STATS *stats,
                                sql_stats_cache_key.data()))
     return;
 
+  bool skipped = statement_completed &&
+      thd->get_stmt_da()->is_error() &&
+      thd->get_stmt_da()->sql_errno() == ER_DUPLICATE_STATEMENT_EXECUTION;
+  uint time_now = my_time(true);
+
+  /* Entry is known to exist, so just accumulate the stats in the THD. */
+  if (add_pending_sql_stats(thd, sql_stats_cache_key, stats,
+                            statement_completed, skipped, time_now))
+    return;
+
   bool lock_acquired = mt_lock(&LOCK_global_sql_stats);
 
   // Check again inside the lock and release the lock if exiting
@@ -2420,6 +2577,7 @@ void update_sql_stats_for_statement(THD *thd, SHARED_SQL_STATS *stats,
     return;
   }
 
+  const ulonglong epoch = sql_stats_epoch;
   current_max_sql_stats_count = max_sql_stats_count;
   current_max_sql_stats_size = max_sql_stats_size;
 
@@ -2509,7 +2667,6 @@ void update_sql_stats_for_statement(THD *thd, SHARED_SQL_STATS *stats,
   }
 
   /* Re-sample if last sample is too old */
-	uint time_now = my_time(true);
   if (!get_sample_query && max_digest_sample_age > 0) {
 			uint sample_age = time_now - sql_stats->query_sample_seen;
 			/* Comparison in micro seconds. */
@@ -2523,35 +2680,136 @@ void update_sql_stats_for_statement(THD *thd, SHARED_SQL_STATS *stats,
     sql_stats->query_sample_text[sub_query_length] = '\0';
     sql_stats->query_sample_seen = time_now;
   }
-  /* Update stats */
-  sql_stats->shared_stats.rows_sent += stats->rows_sent;
-  sql_stats->shared_stats.tmp_table_bytes_written += stats->tmp_table_bytes_written;
-  sql_stats->shared_stats.filesort_bytes_written += stats->filesort_bytes_written;
-  sql_stats->shared_stats.index_dive_count += stats->index_dive_count;
-  sql_stats->shared_stats.index_dive_cpu += stats->index_dive_cpu;
-  sql_stats->shared_stats.compilation_cpu += stats->compilation_cpu;
-  sql_stats->shared_stats.tmp_table_disk_usage += stats->tmp_table_disk_usage;
-  sql_stats->shared_stats.filesort_disk_usage += stats->filesort_disk_usage;
+  add_sql_stats(sql_stats, stats, statement_completed, skipped);
+  const uint query_sample_seen = sql_stats->query_sample_seen;
 
-  // Update CPU stats
-  sql_stats->shared_stats.stmt_cpu_utime += stats->stmt_cpu_utime;
+  mt_unlock(lock_acquired, &LOCK_global_sql_stats);
 
-  // Update elapsed time
-  sql_stats->shared_stats.stmt_elapsed_utime += stats->stmt_elapsed_utime;
+  remember_sql_stats_entry(thd, sql_stats_cache_key, epoch, query_sample_seen,
+                           time_now);
+}
 
-  // Update Row counts
-  sql_stats->shared_stats.rows_inserted += stats->rows_inserted;
-  sql_stats->shared_stats.rows_updated += stats->rows_updated;
-  sql_stats->shared_stats.rows_deleted += stats->rows_deleted;
-  sql_stats->shared_stats.rows_read += stats->rows_read;
+/*
+  take_pending_sql_stats
+    Moves the non-empty pending stats of a THD to a list, resetting them in
+    the THD. Stats started before the given epoch are dropped. With forget
+    set the THD also forgets which global entries exist, see
+    merge_all_thd_sql_stats().
+    LOCK_thd_data of the THD must be held.
+*/
+static void take_pending_sql_stats(
+    THD *thd, ulonglong epoch, bool forget,
+    std::vector<std::pair<md5_key, THD::Pending_sql_stats>> *out)
+{
+  mysql_mutex_assert_owner(&thd->LOCK_thd_data);
 
-  if (statement_completed) {
-    sql_stats->count++;
-    if (thd->get_stmt_da()->is_error() &&
-        thd->get_stmt_da()->sql_errno() == ER_DUPLICATE_STATEMENT_EXECUTION)
-      sql_stats->skipped_count++;
+  /* The THD drops stale stats itself on its next statement */
+  if (thd->pending_sql_stats_epoch == epoch)
+  {
+    for (auto &entry : thd->pending_sql_stats)
+    {
+      if (!entry.second.dirty)
+        continue;
+
+      out->emplace_back(entry);
+
+      const uint query_sample_seen = entry.second.query_sample_seen;
+      entry.second = {};
+      entry.second.shared_stats.reset();
+      entry.second.query_sample_seen = query_sample_seen;
+    }
+  }
+
+  if (forget)
+  {
+    thd->pending_sql_stats.clear();
+    thd->pending_sql_stats_epoch = epoch + 1;
   }
+}
+
+/*
+  merge_pending_sql_stats
+    Adds pending stats to their global_sql_stats entries, if the entries are
+    still there. LOCK_global_sql_stats must be held.
+*/
+static void merge_pending_sql_stats(
+    const std::vector<std::pair<md5_key, THD::Pending_sql_stats>> &pending)
+{
+  for (const auto &entry : pending)
+  {
+    auto iter = global_sql_stats.stats->find(entry.first);
+    if (iter == global_sql_stats.stats->end())
+      continue;
 
+    SQL_STATS *sql_stats = iter->second;
+    add_shared_sql_stats(&sql_stats->shared_stats, &entry.second.shared_stats);
+    sql_stats->count += entry.second.count;
+    sql_stats->skipped_count += entry.second.skipped_count;
+  }
+}
+
+/*
+  flush_thd_sql_stats
+    Merges the stats pending in the THD into global_sql_stats.
+  Input:
+    thd    in: - THD
+*/
+void flush_thd_sql_stats(THD *thd)
+{
+  std::vector<std::pair<md5_key, THD::Pending_sql_stats>> pending;
+
+  /* Only this session adds pending stats, others can only take them */
+  mysql_mutex_lock(&thd->LOCK_thd_data);
+  const bool empty = thd->pending_sql_stats.empty();
+  mysql_mutex_unlock(&thd->LOCK_thd_data);
+  if (empty)
+    return;
+
+  /* Taken under LOCK_global_sql_stats, so that sql_stats_epoch can't
+     change before they are merged */
+  bool lock_acquired = mt_lock(&LOCK_global_sql_stats);
+  mysql_mutex_lock(&thd->LOCK_thd_data);
+  take_pending_sql_stats(thd, sql_stats_epoch, false, &pending);
+  mysql_mutex_unlock(&thd->LOCK_thd_data);
+  merge_pending_sql_stats(pending);
+  mt_unlock(lock_acquired, &LOCK_global_sql_stats);
+}
+
+/*
+  merge_all_thd_sql_stats
+    Merges the stats pending in all sessions into global_sql_stats, so that
+    readers see the same stats as if every statement updated them directly.
+    Callers that bump sql_stats_epoch before releasing the lock set forget:
+    the sessions then forget which global entries exist, so until the bump
+    their statements update global_sql_stats directly, waiting for the lock,
+    instead of adding stats that the bump would drop.
+    LOCK_global_sql_stats must be held.
+*/
+static void merge_all_thd_sql_stats(bool forget)
+{
+  mysql_mutex_assert_owner(&LOCK_global_sql_stats);
+
+  std::vector<std::pair<md5_key, THD::Pending_sql_stats>> pending;
+  const ulonglong epoch = sql_stats_epoch;
+  std::set<THD*> global_thread_list_copy;
+
+  mutex_lock_all_shards(SHARDED(&LOCK_thd_remove));
+  copy_global_thread_list(&global_thread_list_copy);
+  for (THD *tmp : global_thread_list_copy)
+  {
+    mysql_mutex_lock(&tmp->LOCK_thd_data);
+    take_pending_sql_stats(tmp, epoch, forget, &pending);
+    mysql_mutex_unlock(&tmp->LOCK_thd_data);
+  }
+  mutex_unlock_all_shards(SHARDED(&LOCK_thd_remove));
+
+  merge_pending_sql_stats(pending);
+}
+
+static void flush_all_thd_sql_stats()
+{
+  bool lock_acquired = mt_lock(&LOCK_global_sql_stats);
+  merge_all_thd_sql_stats(false);
   mt_unlock(lock_acquired, &LOCK_global_sql_stats);
 }
 
@@ -2696,6 +2954,10 @@ public:
     /* Before starting iteration see if auto snapshot should be created. */
     thd->auto_create_sql_stats_snapshot();
 
+    /* Global stats are read so merge what sessions have pending first. */
+    if (!thd->variables.sql_stats_snapshot)
+      flush_all_thd_sql_stats();
+
     /* Iterator always takes read lock on snapshot even if snapshot doesn't
        exist. Since in that case it will also take the global stats mutex,
        that would have blocked creation of new snapshot anyway. */
@@ -3183,6 +3445,7 @@ bool toggle_sql_stats_snapshot(THD *thd)
   /* Assume success. */
   bool result = false;
   Sql_stats_maps old_stats;
+
   mysql_rwlock_wrlock(&LOCK_sql_stats_snapshot);
 
   /* Validate snapshot state. */
@@ -3200,11 +3463,15 @@ bool toggle_sql_stats_snapshot(THD *thd)
       {
         bool lock_acquired = mt_lock(&LOCK_global_sql_stats);
 
+        /* Merge what sessions have pending before the maps are moved. */
+        merge_all_thd_sql_stats(true);
+
         /* Move global stats to snapshot. */
         sql_stats_snapshot.move_maps(global_sql_stats);
 
         /* Set new empty stats maps. */
         global_sql_stats.move_maps(new_maps);
+        ++sql_stats_epoch;
 
         mt_unlock(lock_acquired, &LOCK_global_sql_stats);
 
@@ -3232,6 +3499,9 @@ bool toggle_sql_stats_snapshot(THD *thd)
         ulonglong dup_size = 0;
         bool lock_acquired = mt_lock(&LOCK_global_sql_stats);
 
+        /* Merge what sessions have pending before the maps are merged. */
+        merge_all_thd_sql_stats(true);
+
         /* Merge current stats into snapshot. */
         sql_stats_map_merge(sql_stats_snapshot.stats, global_sql_stats.stats,
                             dup_count, dup_size);
@@ -3253,6 +3523,7 @@ bool toggle_sql_stats_snapshot(THD *thd)
 
         /* Replace current stats with snapshot. */
         global_sql_stats.move_maps(sql_stats_snapshot);
+        ++sql_stats_epoch;
 
         mt_unlock(lock_acquired, &LOCK_global_sql_stats);
       }
@@ -1126,6 +1126,14 @@ static Sys_var_mybool Sys_binlog_order_commits(
        GLOBAL_VAR(opt_binlog_order_commits),
        CMD_LINE(OPT_ARG), DEFAULT(TRUE));
 
+static Sys_var_mybool Sys_binlog_pipelined_flush(
+       "binlog_pipelined_flush",
+       "Checksum the binlog cache of each transaction in its own session "
+       "before it enters the group commit flush stage, instead of in the "
+       "flush stage leader.",
+       GLOBAL_VAR(opt_binlog_pipelined_flush),
+       CMD_LINE(OPT_ARG), DEFAULT(FALSE));
+
 #ifdef HAVE_REPLICATION
 static Sys_var_mybool Sys_reset_seconds_behind_master(
        "reset_seconds_behind_master",
@@ -3318,16 +3326,34 @@ static Sys_var_ulong Sys_trans_prealloc_size(
 
 static const char *thread_handling_names[]=
 {
-  "one-thread-per-connection", "no-threads", "loaded-dynamically",
-  0
+  "one-thread-per-connection", "no-threads", "pool-of-threads",
+  "loaded-dynamically", 0
 };
 static Sys_var_enum Sys_thread_handling(
        "thread_handling",
        "Define threads usage for handling queries, one of "
-       "one-thread-per-connection, no-threads, loaded-dynamically"
+       "one-thread-per-connection, no-threads, pool-of-threads, "
+       "loaded-dynamically"
        , READ_ONLY GLOBAL_VAR(thread_handling), CMD_LINE(REQUIRED_ARG),
        thread_handling_names, DEFAULT(0));
 
+static Sys_var_uint Sys_thread_pool_max_threads(
+       "thread_pool_max_threads",
+       "Maximum number of worker threads when "
+       "thread_handling=pool-of-threads, including the ones started while "
+       "others are blocked. Beyond it statements wait in the queue for a "
+       "worker",
+       READ_ONLY GLOBAL_VAR(thread_pool_max_threads), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(1, 65536), DEFAULT(1000), BLOCK_SIZE(1));
+
+static Sys_var_uint Sys_thread_pool_size(
+       "thread_pool_size",
+       "Number of worker threads executing statements when "
+       "thread_handling=pool-of-threads. More workers are started while "
+       "others are blocked. 0 means the number of CPUs",
+       READ_ONLY GLOBAL_VAR(thread_pool_size), CMD_LINE(REQUIRED_ARG),
+       VALID_RANGE(0, 1024), DEFAULT(0), BLOCK_SIZE(1));
+
 static const char *allow_noncurrent_db_rw_levels[] =
 {
   "ON", "LOG", "LOG_WARN", "OFF", 0
@@ -3493,6 +3519,25 @@ static Sys_var_ulonglong Sys_compressed_event_cache_evict_threshold(
        CMD_LINE(OPT_ARG), VALID_RANGE(0, 100), DEFAULT(60),
        BLOCK_SIZE(1), NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0), ON_UPDATE(0));
 
+static bool fix_binlog_event_ring_size(sys_var *self, THD *thd,
+                                       enum_var_type type)
+{
+#ifdef HAVE_REPLICATION
+  resize_binlog_event_ring();
+#endif
+  return false;
+}
+
+static Sys_var_ulonglong Sys_binlog_event_ring_size(
+       "binlog_event_ring_size",
+       "Max size in MB of the ring of recent binlog events shared by the "
+       "dump threads. Dump threads tailing the binlog read events from the "
+       "ring instead of the binlog file. 0 disables the ring.",
+       GLOBAL_VAR(opt_binlog_event_ring_size), CMD_LINE(OPT_ARG),
+       VALID_RANGE(0, 1000000), DEFAULT(0),
+       BLOCK_SIZE(1), NO_MUTEX_GUARD, NOT_IN_BINLOG, ON_CHECK(0),
+       ON_UPDATE(fix_binlog_event_ring_size));
+
 static Sys_var_ulonglong Sys_slave_dump_thread_wait_sleep_usec(
        "slave_dump_thread_wait_sleep_usec",
        "Time (in microsecs) to sleep on the master's dump thread before "
@@ -3834,6 +3879,27 @@ static Sys_var_long Sys_zstd_net_compression_level(
       GLOBAL_VAR(zstd_net_compression_level), CMD_LINE(OPT_ARG),
       VALID_RANGE(LONG_MIN, 22), DEFAULT(ZSTD_CLEVEL_DEFAULT), BLOCK_SIZE(1));
 
+static Sys_var_long Sys_io_cache_compression_level(
+      "io_cache_compression_level",
+      "zstd compression level of compressed files such as SELECT ... INTO "
+      "OUTFILE ... COMPRESSED.",
+      GLOBAL_VAR(io_cache_compression_level), CMD_LINE(OPT_ARG),
+      VALID_RANGE(LONG_MIN, 22), DEFAULT(ZSTD_CLEVEL_DEFAULT), BLOCK_SIZE(1));
+
+static Sys_var_uint Sys_io_cache_compression_workers(
+      "io_cache_compression_workers",
+      "Number of zstd worker threads compressing each compressed file in "
+      "parallel. 0 compresses in the writing thread.",
+      GLOBAL_VAR(io_cache_compression_workers), CMD_LINE(OPT_ARG),
+      VALID_RANGE(0, 64), DEFAULT(0), BLOCK_SIZE(1));
+
+static Sys_var_charptr Sys_io_cache_compression_dictionary(
+      "io_cache_compression_dictionary",
+      "File with a zstd dictionary used to compress and decompress "
+      "compressed files.",
+      READ_ONLY GLOBAL_VAR(opt_io_cache_compression_dictionary),
+      CMD_LINE(REQUIRED_ARG), IN_FS_CHARSET, DEFAULT(0));
+
 static Sys_var_ulong Sys_sort_buffer(
        "sort_buffer_size",
        "Each thread that needs to do a sort allocates a buffer of this size",
@@ -0,0 +1,643 @@
+/* Copyright (c) 2016, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software Foundation,
+   51 Franklin Street, Suite 500, Boston, MA 02110-1335 USA */
+
+/*
+  Scheduler for --thread-handling=pool-of-threads
+
+  Idle connections are not bound to an OS thread. Their sockets are
+  registered with one epoll instance, watched by a single listener thread.
+  When a socket becomes readable the connection is queued and one of
+  thread_pool_size worker threads attaches to its THD, executes the
+  pending command(s), detaches and re-arms the socket.
+
+  KILL of an idle connection writes to an eventfd watched by the
+  listener, which then hands every idle connection marked
+  KILL_CONNECTION to a worker to end the session. The listener is the
+  only thread that moves connections out of the idle set.
+
+  Workers report blocking waits through thd_wait_begin()/thd_wait_end().
+  While fewer than thread_pool_size workers are runnable and work is
+  queued, an extra worker is started so that long waits (row locks,
+  admission control queues, ...) do not starve the pool. Surplus workers
+  exit as soon as they find the queue empty. No more than
+  thread_pool_max_threads workers are ever alive: once that many are
+  blocked, queued work waits until one of them is done, so a burst of
+  waits cannot bring back one OS thread per connection.
+*/
+
+#include "sql_priv.h"
+#include "unireg.h"
+#include "sql_class.h"
+#include "sql_connect.h"                  // thd_prepare_connection
+#include "sql_parse.h"                    // do_command
+#include "sql_audit.h"                    // mysql_audit_release
+#include "sql_multi_tenancy.h"            // multi_tenancy_close_connection
+#include "scheduler.h"
+#include "global_threads.h"
+#include "mysqld.h"
+
+#if defined(HAVE_EPOLL) && !defined(EMBEDDED_LIBRARY)
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <deque>
+#include <unordered_set>
+
+/* How often the listener wakes up to expire idle connections. */
+static const int POOL_LISTENER_TIMEOUT_MS= 1000;
+static const int POOL_MAX_EVENTS= 64;
+
+struct Pool_connection
+{
+  enum enum_state { IDLE, QUEUED, RUNNING };
+
+  THD *thd;
+  enum_state state;
+  bool logged_in;
+  bool registered;                 // socket has been added to the epoll set
+  bool timed_out;                  // expired by the listener while idle
+  ulonglong idle_deadline;         // my_micro_time() after which it expires
+  ulong conn_timeout;
+  char timeout_err_msg_buf[256];
+
+  explicit Pool_connection(THD *thd_arg)
+    : thd(thd_arg), state(QUEUED), logged_in(false), registered(false),
+      timed_out(false), idle_deadline(0), conn_timeout(0)
+  {
+    timeout_err_msg_buf[0]= '\0';
+  }
+};
+
+static int pool_epoll_fd= -1;
+static int pool_wakeup_fd= -1;        // eventfd, data.ptr is NULL in epoll
+static bool pool_shutdown= false;
+static pthread_t pool_listener_thread;
+
+/* LOCK_pool protects everything below. */
+static mysql_mutex_t LOCK_pool;
+static mysql_cond_t COND_pool_work;
+static mysql_cond_t COND_pool_exit;
+static std::deque<Pool_connection*> pool_work;
+static std::unordered_set<Pool_connection*> pool_idle;
+static uint pool_threads= 0;          // worker threads alive
+static uint pool_waiting_workers= 0;  // workers waiting for work
+static uint pool_blocked_workers= 0;  // workers inside thd_wait_begin()
+
+/* Set for pool workers, nesting depth of thd_wait_begin() calls. */
+static thread_local bool pool_worker= false;
+static thread_local uint pool_wait_depth= 0;
+
+#ifdef HAVE_PSI_INTERFACE
+static PSI_mutex_key key_LOCK_pool;
+static PSI_cond_key key_COND_pool_work, key_COND_pool_exit;
+static PSI_thread_key key_thread_pool_listener, key_thread_pool_worker;
+
+static PSI_mutex_info pool_mutexes[]=
+{
+  { &key_LOCK_pool, "LOCK_pool", PSI_FLAG_GLOBAL}
+};
+
+static PSI_cond_info pool_conds[]=
+{
+  { &key_COND_pool_work, "COND_pool_work", PSI_FLAG_GLOBAL},
+  { &key_COND_pool_exit, "COND_pool_exit", PSI_FLAG_GLOBAL}
+};
+
+static PSI_thread_info pool_threads_info[]=
+{
+  { &key_thread_pool_listener, "pool_listener", PSI_FLAG_GLOBAL},
+  { &key_thread_pool_worker, "pool_worker", PSI_FLAG_GLOBAL}
+};
+
+static void init_pool_psi_keys()
+{
+  const char *category= "sql";
+  mysql_mutex_register(category, pool_mutexes, array_elements(pool_mutexes));
+  mysql_cond_register(category, pool_conds, array_elements(pool_conds));
+  mysql_thread_register(category, pool_threads_info,
+                        array_elements(pool_threads_info));
+}
+#endif /* HAVE_PSI_INTERFACE */
+
+static void *pool_worker_main(void *arg);
+
+/**
+  Start one more worker. LOCK_pool must be held.
+*/
+static bool start_pool_worker()
+{
+  mysql_mutex_assert_owner(&LOCK_pool);
+  pthread_t id;
+  int error;
+  if ((error= mysql_thread_create(key_thread_pool_worker, &id,
+                                  &connection_attrib, pool_worker_main,
+                                  NULL)))
+  {
+    sql_print_error("Can't create thread pool worker (errno= %d)", error);
+    return true;
+  }
+  ++pool_threads;
+  return false;
+}
+
+/**
+  Number of workers that are neither waiting for work nor blocked.
+  LOCK_pool must be held.
+*/
+static uint runnable_pool_workers()
+{
+  return pool_threads - pool_waiting_workers - pool_blocked_workers;
+}
+
+/**
+  Whether another worker may be started to replace blocked ones.
+  LOCK_pool must be held.
+*/
+static bool pool_can_grow()
+{
+  return runnable_pool_workers() < thread_pool_size &&
+         pool_threads < thread_pool_max_threads;
+}
+
+/**
+  Queue a connection for a worker. LOCK_pool must be held.
+*/
+static void queue_pool_connection(Pool_connection *conn)
+{
+  mysql_mutex_assert_owner(&LOCK_pool);
+  conn->state= Pool_connection::QUEUED;
+  pool_work.push_back(conn);
+  if (pool_waiting_workers)
+    mysql_cond_signal(&COND_pool_work);
+  else if (pool_can_grow())
+    start_pool_worker();
+}
+
+/**
+  Attach the connection to the current worker thread.
+*/
+static bool attach_pool_connection(THD *thd, char *stack_start)
+{
+  thd->thread_stack= stack_start;
+  if (thd->store_globals())
+    return true;
+  mysql_socket_set_thread_owner(thd->get_net()->vio->mysql_socket);
+  return false;
+}
+
+/**
+  Detach the connection so another worker can pick it up later. The
+  mysys_var of this worker must not be reachable through the idle THD,
+  otherwise a KILL would signal whatever the worker waits on next.
+*/
+static void detach_pool_connection(THD *thd)
+{
+  thd->restore_globals();
+  thd->set_mysys_var(NULL);
+}
+
+static my_socket pool_connection_fd(THD *thd)
+{
+  return mysql_socket_getfd(thd->get_net()->vio->mysql_socket);
+}
+
+static bool pool_connection_has_data(THD *thd)
+{
+  Vio *vio= thd->get_net()->vio;
+  return vio->has_data(vio);
+}
+
+/**
+  Register the socket of an idle connection for one readiness event.
+*/
+static bool arm_pool_connection(Pool_connection *conn)
+{
+  struct epoll_event ev;
+  ev.events= EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+  ev.data.ptr= conn;
+
+  mysql_mutex_lock(&LOCK_pool);
+  conn->state= Pool_connection::IDLE;
+  conn->idle_deadline= my_micro_time() +
+    conn->thd->variables.net_wait_timeout_seconds * 1000000ULL;
+  pool_idle.insert(conn);
+  int op= conn->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  if (epoll_ctl(pool_epoll_fd, op, pool_connection_fd(conn->thd), &ev))
+  {
+    pool_idle.erase(conn);
+    conn->state= Pool_connection::RUNNING;
+    mysql_mutex_unlock(&LOCK_pool);
+    sql_print_error("Thread pool failed to watch connection %u (errno= %d)",
+                    conn->thd->thread_id(), errno);
+    return true;
+  }
+  conn->registered= true;
+  mysql_mutex_unlock(&LOCK_pool);
+  return false;
+}
+
+/**
+  Release a finished connection, the pool counterpart of
+  one_thread_per_connection_end().
+*/
+static void end_pool_connection(Pool_connection *conn)
+{
+  THD *thd= conn->thd;
+
+  /* Closing the socket has already removed it from the epoll set. */
+  thd->release_resources();
+  remove_global_thread(thd);
+  dec_connection_count();
+  delete thd;
+  delete conn;
+
+  my_pthread_setspecific_ptr(THR_THD, NULL);
+}
+
+/**
+  Send the wait_timeout error to a connection expired while idle, as
+  my_real_read() would have done for a blocking read.
+*/
+static void expire_pool_connection(THD *thd)
+{
+  NET *net= thd->get_net();
+  const char *msg= net->vio->timeout_err_msg;
+  if (msg)
+  {
+    /* Force the packet serial number to 1 for client compatibility */
+    net->pkt_nr= 1;
+    net_write_command(net, (uchar) 255, (uchar*) "", 0,
+                      (uchar*) msg, strlen(msg));
+  }
+  net->last_errno= ER_NET_READ_INTERRUPTED;
+  net->error= 2;
+}
+
+/**
+  Run everything that is pending for a connection: the login handshake
+  for a new one, otherwise the commands available on its socket.
+*/
+static void handle_pool_connection(Pool_connection *conn)
+{
+  THD *thd= conn->thd;
+  bool run_commands= true;
+
+  if (attach_pool_connection(thd, (char*) &thd))
+  {
+    close_connection(thd, ER_OUT_OF_RESOURCES);
+    statistic_increment(connection_errors_out_of_resources, &LOCK_status);
+    statistic_increment(aborted_connects, &LOCK_status);
+    end_pool_connection(conn);
+    return;
+  }
+
+  if (!conn->logged_in)
+  {
+    thd->thr_create_utime= my_micro_time();
+    if (thd_prepare_connection(thd))
+    {
+      close_connection(thd);
+      end_pool_connection(conn);
+      return;
+    }
+    conn->logged_in= true;
+
+    /*
+      Set per user session variables for this user.
+      Ignore the return value of the function but errors will logged.
+    */
+    per_user_session_variables.set_thd(thd);
+    thd->set_dscp_on_socket();
+
+    conn->conn_timeout= thd->variables.net_wait_timeout_seconds;
+    set_conn_timeout_err(thd, conn->timeout_err_msg_buf);
+    run_commands= pool_connection_has_data(thd);
+  }
+  else if (conn->timed_out)
+  {
+    expire_pool_connection(thd);
+    run_commands= false;
+  }
+
+  /*
+    Keep going while the client has pipelined more commands, epoll will
+    not report data that has already been read into the vio buffer.
+  */
+  while (run_commands && thd_is_connection_alive(thd))
+  {
+    mysql_audit_release(thd);
+    if (do_command(thd))
+      break;
+
+    /*
+      Update the error message with new timeout value if wait_timeout
+      was changed in this session.
+    */
+    if (conn->conn_timeout != thd->variables.net_wait_timeout_seconds)
+    {
+      conn->conn_timeout= thd->variables.net_wait_timeout_seconds;
+      set_conn_timeout_err(thd, conn->timeout_err_msg_buf);
+    }
+    run_commands= pool_connection_has_data(thd);
+  }
+
+  if (thd_is_connection_alive(thd))
+  {
+    detach_pool_connection(thd);
+    if (!arm_pool_connection(conn))
+      return;
+    attach_pool_connection(thd, (char*) &thd);
+  }
+
+  thd_update_net_stats(thd);
+  multi_tenancy_close_connection(thd);
+  end_connection(thd);
+  close_connection(thd);
+  end_pool_connection(conn);
+}
+
+/**
+  Make the listener return from epoll_wait() and sweep the idle set.
+*/
+static void wake_pool_listener()
+{
+  uint64_t one= 1;
+  /* Can only fail with EAGAIN when the counter is already nonzero. */
+  if (write(pool_wakeup_fd, &one, sizeof(one)) != sizeof(one))
+    DBUG_ASSERT(errno == EAGAIN);
+}
+
+static void *pool_worker_main(void *arg __attribute__((unused)))
+{
+  my_thread_init();
+  pool_worker= true;
+
+  mysql_mutex_lock(&LOCK_pool);
+  for (;;)
+  {
+    while (pool_work.empty() && !pool_shutdown &&
+           pool_threads - pool_blocked_workers <= thread_pool_size)
+    {
+      ++pool_waiting_workers;
+      mysql_cond_wait(&COND_pool_work, &LOCK_pool);
+      --pool_waiting_workers;
+    }
+    /* Exit on shutdown, or when surplus workers are no longer needed. */
+    if (pool_work.empty())
+      break;
+
+    Pool_connection *conn= pool_work.front();
+    pool_work.pop_front();
+    conn->state= Pool_connection::RUNNING;
+    mysql_mutex_unlock(&LOCK_pool);
+
+    handle_pool_connection(conn);
+
+    mysql_mutex_lock(&LOCK_pool);
+  }
+  --pool_threads;
+  mysql_cond_broadcast(&COND_pool_exit);
+  mysql_mutex_unlock(&LOCK_pool);
+
+  my_thread_end();
+  pthread_exit(0);
+  return NULL;
+}
+
+static void *pool_listener_main(void *arg __attribute__((unused)))
+{
+  my_thread_init();
+  struct epoll_event events[POOL_MAX_EVENTS];
+
+  for (;;)
+  {
+    int n= epoll_wait(pool_epoll_fd, events, POOL_MAX_EVENTS,
+                      POOL_LISTENER_TIMEOUT_MS);
+
+    mysql_mutex_lock(&LOCK_pool);
+    if (pool_shutdown)
+    {
+      mysql_mutex_unlock(&LOCK_pool);
+      break;
+    }
+
+    for (int i= 0; i < n; i++)
+    {
+      Pool_connection *conn= (Pool_connection*) events[i].data.ptr;
+      if (conn == NULL)
+      {
+        uint64_t count;
+        if (read(pool_wakeup_fd, &count, sizeof(count)) < 0)
+          DBUG_ASSERT(errno == EAGAIN);
+        continue;
+      }
+      if (conn->state != Pool_connection::IDLE)
+        continue;
+      pool_idle.erase(conn);
+      queue_pool_connection(conn);
+    }
+
+    /*
+      End killed connections, their socket may already be closed and gone
+      from the epoll set. Expire connections idle for longer than their
+      wait_timeout.
+    */
+    ulonglong now= my_micro_time();
+    for (auto it= pool_idle.begin(); it != pool_idle.end();)
+    {
+      Pool_connection *conn= *it;
+      bool killed= conn->thd->killed == THD::KILL_CONNECTION;
+      if (!killed && conn->idle_deadline > now)
+      {
+        ++it;
+        continue;
+      }
+      it= pool_idle.erase(it);
+      /* Fails harmlessly when the socket has been closed by THD::awake(). */
+      epoll_ctl(pool_epoll_fd, EPOLL_CTL_DEL, pool_connection_fd(conn->thd), NULL);
+      conn->registered= false;
+      conn->timed_out= !killed;
+      queue_pool_connection(conn);
+    }
+    mysql_mutex_unlock(&LOCK_pool);
+  }
+
+  my_thread_end();
+  return NULL;
+}
+
+static bool pool_init()
+{
+#ifdef HAVE_PSI_INTERFACE
+  init_pool_psi_keys();
+#endif
+  if (!thread_pool_size)
+    thread_pool_size= my_getncpus();
+  if (thread_pool_size > thread_pool_max_threads)
+    thread_pool_size= thread_pool_max_threads;
+
+  if ((pool_epoll_fd= epoll_create(POOL_MAX_EVENTS)) < 0)
+  {
+    sql_print_error("Thread pool failed to create epoll instance (errno= %d)",
+                    errno);
+    return true;
+  }
+
+  struct epoll_event ev;
+  ev.events= EPOLLIN;
+  ev.data.ptr= NULL;
+  if ((pool_wakeup_fd= eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0 ||
+      epoll_ctl(pool_epoll_fd, EPOLL_CTL_ADD, pool_wakeup_fd, &ev))
+  {
+    sql_print_error("Thread pool failed to create its wakeup eventfd "
+                    "(errno= %d)", errno);
+    return true;
+  }
+
+  mysql_mutex_init(key_LOCK_pool, &LOCK_pool, MY_MUTEX_INIT_FAST);
+  mysql_cond_init(key_COND_pool_work, &COND_pool_work, NULL);
+  mysql_cond_init(key_COND_pool_exit, &COND_pool_exit, NULL);
+
+  mysql_mutex_lock(&LOCK_pool);
+  for (uint i= 0; i < thread_pool_size; i++)
+  {
+    if (start_pool_worker())
+      break;
+  }
+  bool error= (pool_threads == 0);
+  mysql_mutex_unlock(&LOCK_pool);
+
+  if (error || mysql_thread_create(key_thread_pool_listener,
+                                   &pool_listener_thread, NULL,
+                                   pool_listener_main, NULL))
+  {
+    sql_print_error("Thread pool failed to start its threads");
+    return true;
+  }
+  return false;
+}
+
+static void pool_end()
+{
+  mysql_mutex_lock(&LOCK_pool);
+  pool_shutdown= true;
+  mysql_cond_broadcast(&COND_pool_work);
+  mysql_mutex_unlock(&LOCK_pool);
+  wake_pool_listener();
+
+  pthread_join(pool_listener_thread, NULL);
+
+  mysql_mutex_lock(&LOCK_pool);
+  while (pool_threads)
+    mysql_cond_wait(&COND_pool_exit, &LOCK_pool);
+  mysql_mutex_unlock(&LOCK_pool);
+
+  close(pool_wakeup_fd);
+  pool_wakeup_fd= -1;
+  close(pool_epoll_fd);
+  pool_epoll_fd= -1;
+  mysql_cond_destroy(&COND_pool_exit);
+  mysql_cond_destroy(&COND_pool_work);
+  mysql_mutex_destroy(&LOCK_pool);
+}
+
+static void pool_add_connection(THD *thd)
+{
+  Pool_connection *conn= new (std::nothrow) Pool_connection(thd);
+
+  thd->prior_thr_create_utime= thd->start_utime= my_micro_time();
+  mutex_lock_shard(SHARDED(&LOCK_thread_count), thd);
+  add_global_thread(thd);
+  mutex_unlock_shard(SHARDED(&LOCK_thread_count), thd);
+
+  if (conn == NULL)
+  {
+    close_connection(thd, ER_OUT_OF_RESOURCES);
+    statistic_increment(connection_errors_out_of_resources, &LOCK_status);
+    statistic_increment(aborted_connects, &LOCK_status);
+    thd->release_resources();
+    remove_global_thread(thd);
+    delete thd;
+    dec_connection_count();
+    return;
+  }
+
+  mysql_mutex_lock(&LOCK_pool);
+  queue_pool_connection(conn);
+  mysql_mutex_unlock(&LOCK_pool);
+}
+
+/**
+  A worker is about to block. If that leaves queued work without a
+  runnable worker, start another one unless thread_pool_max_threads
+  workers are already alive.
+*/
+static void pool_wait_begin(THD *thd, int wait_type)
+{
+  if (!pool_worker || pool_wait_depth++ > 0)
+    return;
+
+  mysql_mutex_lock(&LOCK_pool);
+  ++pool_blocked_workers;
+  if (!pool_work.empty() && !pool_waiting_workers && pool_can_grow())
+    start_pool_worker();
+  mysql_mutex_unlock(&LOCK_pool);
+}
+
+static void pool_wait_end(THD *thd)
+{
+  if (!pool_worker || --pool_wait_depth > 0)
+    return;
+
+  mysql_mutex_lock(&LOCK_pool);
+  --pool_blocked_workers;
+  mysql_mutex_unlock(&LOCK_pool);
+}
+
+/**
+  An idle connection has no thread that would notice a KILL, let the
+  listener hand it to a worker. Queued and running connections check
+  thd->killed themselves.
+*/
+static void pool_post_kill_notification(THD *thd)
+{
+  if (thd->killed == THD::KILL_CONNECTION)
+    wake_pool_listener();
+}
+
+/**
+  Connections are released by the worker that ends them, never through
+  the generic end_thread hook. Returning true tells callers that the
+  calling thread must not go on serving the connection.
+*/
+static bool pool_end_thread(THD *thd, bool cache_thread)
+{
+  return true;
+}
+
+scheduler_functions pool_of_threads_scheduler_functions=
+{
+  0,                                     // max_threads
+  pool_init,                             // init
+  init_new_connection_handler_thread,    // init_new_connection_thread
+  pool_add_connection,                   // add_connection
+  pool_wait_begin,                       // thd_wait_begin
+  pool_wait_end,                         // thd_wait_end
+  pool_post_kill_notification,           // post_kill_notification
+  pool_end_thread,                       // end_thread
+  pool_end,                              // end
+};
+
+#endif /* HAVE_EPOLL && !EMBEDDED_LIBRARY */
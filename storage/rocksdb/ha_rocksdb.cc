@@ -75,6 +75,7 @@
 #include "./nosql_access.h"
 #include "./rdb_cf_manager.h"
 #include "./rdb_cf_options.h"
+#include "./rdb_compact_filter.h"
 #include "./rdb_converter.h"
 #include "./rdb_datadic.h"
 #include "./rdb_i_s.h"
@@ -277,6 +278,15 @@ static Rdb_index_stats_thread rdb_is_thread;
 static Rdb_manual_compaction_thread rdb_mc_thread;
 
 static Rdb_drop_index_thread rdb_drop_idx_thread;
+
+/*
+  Helper threads for overlapped MRR, see ha_rocksdb::mrr_prefetch_next_batch().
+  The pool is sized by @@rocksdb_mrr_prefetch_threads at startup and is empty
+  when the feature is disabled.
+*/
+static std::vector<std::unique_ptr<Rdb_mrr_prefetch_thread>>
+    rdb_mrr_prefetch_threads;
+static std::atomic<uint> rdb_mrr_prefetch_next_thread(0);
 // List of table names (using regex) that are exceptions to the strict
 // collation check requirement.
 Regex_list_handler *rdb_collation_exceptions;
@@ -432,6 +442,18 @@ static void rocksdb_select_bypass_rejected_query_history_size_update(
     THD *const thd, struct st_mysql_sys_var *const /* unused */,
     void *const var_ptr, const void *const save);
 
+static void rocksdb_select_bypass_query_shapes_size_update(
+    THD *const thd, struct st_mysql_sys_var *const /* unused */,
+    void *const var_ptr, const void *const save);
+
+static void rocksdb_select_bypass_plan_cache_size_update(
+    THD *const thd, struct st_mysql_sys_var *const /* unused */,
+    void *const var_ptr, const void *const save);
+
+static void rocksdb_perf_context_trace_size_update(
+    THD *const thd, struct st_mysql_sys_var *const /* unused */,
+    void *const var_ptr, const void *const save);
+
 static void rocksdb_force_flush_memtable_now_stub(
     THD *const thd, struct st_mysql_sys_var *const var, void *const var_ptr,
     const void *const save) {}
@@ -688,6 +710,7 @@ static char *rocksdb_checkpoint_name;
 static char *rocksdb_block_cache_trace_options_str;
 static char *rocksdb_trace_options_str;
 static my_bool rocksdb_signal_drop_index_thread;
+static my_bool rocksdb_drop_index_use_delete_range = 0;
 static my_bool rocksdb_strict_collation_check = 1;
 static my_bool rocksdb_ignore_unknown_options = 1;
 static my_bool rocksdb_enable_2pc = 0;
@@ -739,6 +762,7 @@ static my_bool rocksdb_error_on_suboptimal_collation = 1;
 static uint32_t rocksdb_stats_recalc_rate = 0;
 static uint32_t rocksdb_debug_manual_compaction_delay = 0;
 static uint32_t rocksdb_max_manual_compactions = 0;
+static uint32_t rocksdb_mrr_prefetch_threads = 0;
 static my_bool rocksdb_rollback_on_timeout = FALSE;
 static my_bool rocksdb_enable_insert_with_update_caching = TRUE;
 static uint64_t rocksdb_select_bypass_policy =
@@ -748,6 +772,10 @@ static my_bool rocksdb_select_bypass_log_rejected = TRUE;
 static my_bool rocksdb_select_bypass_log_failed = FALSE;
 static my_bool rocksdb_select_bypass_allow_filters = TRUE;
 static uint32_t rocksdb_select_bypass_rejected_query_history_size = 0;
+static uint32_t rocksdb_select_bypass_query_shapes_size = 0;
+static uint32_t rocksdb_select_bypass_plan_cache_size = 0;
+static uint32_t rocksdb_perf_context_trace_size = 10;
+static uint32_t rocksdb_scan_readahead_table_limit = 16;
 static uint32_t rocksdb_select_bypass_debug_row_delay = 0;
 static unsigned long long  // NOLINT(runtime/int)
     rocksdb_select_bypass_multiget_min = 0;
@@ -768,6 +796,8 @@ std::atomic<uint64_t> rocksdb_num_get_for_update_calls(0);
 std::atomic<uint64_t> rocksdb_select_bypass_executed(0);
 std::atomic<uint64_t> rocksdb_select_bypass_rejected(0);
 std::atomic<uint64_t> rocksdb_select_bypass_failed(0);
+std::atomic<uint64_t> rocksdb_bypass_plan_cache_hits(0);
+std::atomic<uint64_t> rocksdb_bypass_plan_cache_misses(0);
 
 static int rocksdb_trace_block_cache_access(
     THD *const thd MY_ATTRIBUTE((__unused__)),
@@ -1027,6 +1057,8 @@ static void rocksdb_set_reset_stats(
 
     s = rocksdb_stats->Reset();
     DBUG_ASSERT(s == rocksdb::Status::OK());
+
+    rdb_compact_filter_metadata.reset_stats();
   }
 
   RDB_MUTEX_UNLOCK_CHECK(rdb_sysvars_mutex);
@@ -1096,17 +1128,25 @@ const ulong RDB_DEFAULT_MAX_ROW_LOCKS = 1024 * 1024;
 const ulong RDB_MAX_ROW_LOCKS = 1024 * 1024 * 1024;
 const ulong RDB_DEFAULT_BULK_LOAD_SIZE = 1000;
 const ulong RDB_MAX_BULK_LOAD_SIZE = 1024 * 1024 * 1024;
+const uint RDB_MAX_BULK_LOAD_SST_THREADS = 64;
 const size_t RDB_DEFAULT_MERGE_BUF_SIZE = 64 * 1024 * 1024;
 const size_t RDB_MIN_MERGE_BUF_SIZE = 100;
 const size_t RDB_DEFAULT_MERGE_COMBINE_READ_SIZE = 1024 * 1024 * 1024;
 const size_t RDB_MIN_MERGE_COMBINE_READ_SIZE = 100;
 const size_t RDB_DEFAULT_MERGE_TMP_FILE_REMOVAL_DELAY = 0;
 const size_t RDB_MIN_MERGE_TMP_FILE_REMOVAL_DELAY = 0;
+const uint RDB_MAX_MERGE_THREADS = 64;
+const uint RDB_MAX_CHECK_TABLE_THREADS = 64;
+const uint RDB_CHECK_RANGES_PER_THREAD = 4;
 const int64 RDB_DEFAULT_BLOCK_CACHE_SIZE = 512 * 1024 * 1024;
 const int64 RDB_MIN_BLOCK_CACHE_SIZE = 1024;
 const int RDB_MAX_CHECKSUMS_PCT = 100;
 const ulong RDB_DEADLOCK_DETECT_DEPTH = 50;
+const ulong RDB_DEFAULT_SCAN_READAHEAD_SIZE = 2 * 1024 * 1024;
 const ulong ROCKSDB_MAX_MRR_BATCH_SIZE = 1000;
+const uint ROCKSDB_MAX_MRR_PREFETCH_THREADS = 64;
+// Overlapped MRR may grow its batches up to this many times mrr_batch_size
+const uint RDB_MRR_PREFETCH_MAX_GROWTH = 4;
 const uint ROCKSDB_MAX_BOTTOM_PRI_BACKGROUND_COMPACTIONS = 64;
 
 // TODO: 0 means don't wait at all, and we don't support it yet?
@@ -1328,6 +1368,14 @@ static MYSQL_THDVAR_ULONG(bulk_load_size, PLUGIN_VAR_RQCMDARG,
                           /*min*/ 1,
                           /*max*/ RDB_MAX_BULK_LOAD_SIZE, 0);
 
+static MYSQL_THDVAR_UINT(
+    bulk_load_sst_threads, PLUGIN_VAR_RQCMDARG,
+    "Number of threads building the SST files of a bulk load. The loading "
+    "thread then only buffers the rows of each file, up to this many files "
+    "are queued for the threads. 0 builds the files in the loading thread.",
+    nullptr, nullptr, /*default*/ 0, /*min*/ 0,
+    /*max*/ RDB_MAX_BULK_LOAD_SST_THREADS, 0);
+
 static MYSQL_THDVAR_ULONGLONG(
     merge_buf_size, PLUGIN_VAR_RQCMDARG,
     "Size to allocate for merge sort buffers written out to disk "
@@ -1359,6 +1407,22 @@ static MYSQL_THDVAR_ULONGLONG(
     /* min (0ms) */ RDB_MIN_MERGE_TMP_FILE_REMOVAL_DELAY,
     /* max */ SIZE_T_MAX, 1);
 
+static MYSQL_THDVAR_UINT(
+    merge_threads, PLUGIN_VAR_RQCMDARG,
+    "Number of threads used to sort and merge non-unique secondary keys "
+    "during inplace index creation. With 1, sorting and merging are done by "
+    "the thread running the ALTER TABLE.",
+    nullptr, nullptr, /* default */ 1, /* min */ 1,
+    /* max */ RDB_MAX_MERGE_THREADS, 0);
+
+static MYSQL_THDVAR_UINT(
+    check_table_threads, PLUGIN_VAR_RQCMDARG,
+    "Number of threads used by CHECK TABLE. With more than 1, every index "
+    "is split into key ranges at SST file boundaries which are checked "
+    "concurrently, and index entry counts are compared to the record count.",
+    nullptr, nullptr, /* default */ 1, /* min */ 1,
+    /* max */ RDB_MAX_CHECK_TABLE_THREADS, 0);
+
 static MYSQL_THDVAR_INT(
     manual_compaction_threads, PLUGIN_VAR_RQCMDARG,
     "How many rocksdb threads to run for manual compactions", nullptr, nullptr,
@@ -1467,6 +1531,21 @@ static MYSQL_THDVAR_INT(
     /* min */ rocksdb::PerfLevel::kUninitialized,
     /* max */ rocksdb::PerfLevel::kOutOfBounds - 1, 0);
 
+static MYSQL_THDVAR_BOOL(
+    perf_context_trace, PLUGIN_VAR_RQCMDARG,
+    "Collect the perf context of each statement, for the slow query log and "
+    "information_schema.rocksdb_perf_context_queries. Needs "
+    "rocksdb_perf_context_level to be at least 2",
+    nullptr, nullptr, FALSE);
+
+static MYSQL_SYSVAR_UINT(
+    perf_context_trace_size, rocksdb_perf_context_trace_size,
+    PLUGIN_VAR_RQCMDARG,
+    "Max number of statements tracked in "
+    "information_schema.rocksdb_perf_context_queries",
+    nullptr, rocksdb_perf_context_trace_size_update,
+    /* default */ 10, /* min */ 0, /* max */ 1000, 0);
+
 static MYSQL_SYSVAR_UINT(
     wal_recovery_mode, rocksdb_wal_recovery_mode, PLUGIN_VAR_RQCMDARG,
     "DBOptions::wal_recovery_mode for RocksDB. Default is kPointInTimeRecovery",
@@ -1920,6 +1999,30 @@ static MYSQL_THDVAR_BOOL(skip_fill_cache, PLUGIN_VAR_RQCMDARG,
                          "Skip filling block cache on read requests", nullptr,
                          nullptr, FALSE);
 
+static MYSQL_THDVAR_ULONGLONG(
+    scan_readahead_threshold, PLUGIN_VAR_RQCMDARG,
+    "Number of records a scan reads forward on one iterator before it starts "
+    "to read ahead. 0 means never",
+    nullptr, nullptr, /* default */ 0, /* min */ 0, /* max */ SIZE_T_MAX, 0);
+
+static MYSQL_THDVAR_ULONG(
+    scan_readahead_size, PLUGIN_VAR_RQCMDARG,
+    "ReadOptions::readahead_size for scans that passed "
+    "rocksdb_scan_readahead_threshold",
+    nullptr, nullptr, /* default */ RDB_DEFAULT_SCAN_READAHEAD_SIZE,
+    /* min */ 0, /* max */ ULONG_MAX, 0);
+
+static MYSQL_THDVAR_UINT(
+    scan_readahead_session_limit, PLUGIN_VAR_RQCMDARG,
+    "Max number of scans reading ahead in a session at the same time",
+    nullptr, nullptr, /* default */ 4, /* min */ 0, /* max */ INT_MAX, 0);
+
+static MYSQL_SYSVAR_UINT(
+    scan_readahead_table_limit, rocksdb_scan_readahead_table_limit,
+    PLUGIN_VAR_RQCMDARG,
+    "Max number of scans reading ahead on a table at the same time",
+    nullptr, nullptr, /* default */ 16, /* min */ 0, /* max */ INT_MAX, 0);
+
 static MYSQL_THDVAR_BOOL(
     unsafe_for_binlog, PLUGIN_VAR_RQCMDARG,
     "Allowing statement based binary logging which may break consistency",
@@ -1981,6 +2084,14 @@ static MYSQL_SYSVAR_BOOL(signal_drop_index_thread,
                          "Wake up drop index thread", nullptr,
                          rocksdb_drop_index_wakeup_thread, FALSE);
 
+static MYSQL_SYSVAR_BOOL(
+    drop_index_use_delete_range, rocksdb_drop_index_use_delete_range,
+    PLUGIN_VAR_RQCMDARG,
+    "Make the drop index thread cover each dropped index with a single "
+    "DeleteRange tombstone and leave reclaiming its space to regular "
+    "compactions, instead of compacting the index range",
+    nullptr, nullptr, FALSE);
+
 static MYSQL_SYSVAR_BOOL(pause_background_work, rocksdb_pause_background_work,
                          PLUGIN_VAR_RQCMDARG,
                          "Disable all rocksdb background operations", nullptr,
@@ -2261,6 +2372,14 @@ static MYSQL_SYSVAR_BOOL(table_stats_use_table_scan,
                          rocksdb_update_table_stats_use_table_scan,
                          rocksdb_table_stats_use_table_scan);
 
+static MYSQL_SYSVAR_BOOL(
+    table_stats_use_sketches, rocksdb_table_stats_use_sketches,
+    PLUGIN_VAR_RQCMDARG,
+    "Build distinct key prefix sketches for every new SST file and take "
+    "index cardinality from them. When all SST files of a table have "
+    "sketches, table scan based index calculation only scans memtables.",
+    nullptr, nullptr, rocksdb_table_stats_use_sketches);
+
 static MYSQL_SYSVAR_BOOL(
     large_prefix, rocksdb_large_prefix, PLUGIN_VAR_RQCMDARG,
     "Support large index prefix length of 3072 bytes. If off, the maximum "
@@ -2347,6 +2466,23 @@ static MYSQL_SYSVAR_UINT(
     nullptr, rocksdb_select_bypass_rejected_query_history_size_update, 0,
     /* min */ 0, /* max */ INT_MAX, 0);
 
+static MYSQL_SYSVAR_UINT(
+    select_bypass_query_shapes_size, rocksdb_select_bypass_query_shapes_size,
+    PLUGIN_VAR_RQCMDARG,
+    "Max number of query shapes tracked in "
+    "information_schema.rocksdb_bypass_query_shapes. "
+    "Set to 0 to turn off",
+    nullptr, rocksdb_select_bypass_query_shapes_size_update, 0,
+    /* min */ 0, /* max */ INT_MAX, 0);
+
+static MYSQL_SYSVAR_UINT(
+    select_bypass_plan_cache_size, rocksdb_select_bypass_plan_cache_size,
+    PLUGIN_VAR_RQCMDARG,
+    "Max number of SELECT bypass plans cached per table, keyed by statement "
+    "digest. Set to 0 to turn off",
+    nullptr, rocksdb_select_bypass_plan_cache_size_update, 0,
+    /* min */ 0, /* max */ INT_MAX, 0);
+
 static MYSQL_SYSVAR_UINT(
     select_bypass_debug_row_delay, rocksdb_select_bypass_debug_row_delay,
     PLUGIN_VAR_RQCMDARG,
@@ -2367,6 +2503,30 @@ static MYSQL_THDVAR_LONG(mrr_batch_size, PLUGIN_VAR_RQCMDARG,
                          nullptr, nullptr, /* default */ 100, /* min */ 0,
                          /* max */ ROCKSDB_MAX_MRR_BATCH_SIZE, 0);
 
+static MYSQL_SYSVAR_UINT(
+    mrr_prefetch_threads, rocksdb_mrr_prefetch_threads,
+    PLUGIN_VAR_RQCMDARG | PLUGIN_VAR_READONLY,
+    "Number of threads that issue MultiGet calls for the next batch of an "
+    "MRR scan while the current batch is being consumed. 0 disables "
+    "overlapped MRR",
+    nullptr, nullptr, /* default */ 0, /* min */ 0,
+    /* max */ ROCKSDB_MAX_MRR_PREFETCH_THREADS, 0);
+
+static MYSQL_THDVAR_BOOL(
+    mrr_prefetch, PLUGIN_VAR_RQCMDARG,
+    "Overlap MRR MultiGet calls with row consumption, and grow the MRR batch "
+    "size when the scan has to wait for a batch. Only takes effect when "
+    "rocksdb_mrr_prefetch_threads is non-zero",
+    nullptr, nullptr, TRUE);
+
+static MYSQL_THDVAR_LONG(
+    sk_lookahead_batch_size, PLUGIN_VAR_RQCMDARG,
+    "maximum number of rowids that an ordered secondary index scan resolves "
+    "with one MultiGet call. Batches start small and double on every refill. "
+    "Values below 2 disable the lookahead",
+    nullptr, nullptr, /* default */ 0, /* min */ 0,
+    /* max */ ROCKSDB_MAX_MRR_BATCH_SIZE, 0);
+
 static MYSQL_SYSVAR_BOOL(skip_locks_if_skip_unique_check,
                          rocksdb_skip_locks_if_skip_unique_check,
                          PLUGIN_VAR_RQCMDARG,
@@ -2408,6 +2568,7 @@ static struct st_mysql_sys_var *rocksdb_system_variables[] = {
     MYSQL_SYSVAR(read_free_rpl_tables),
     MYSQL_SYSVAR(read_free_rpl),
     MYSQL_SYSVAR(bulk_load_size),
+    MYSQL_SYSVAR(bulk_load_sst_threads),
     MYSQL_SYSVAR(merge_buf_size),
     MYSQL_SYSVAR(enable_bulk_load_api),
     MYSQL_SYSVAR(enable_pipelined_write),
@@ -2415,6 +2576,8 @@ static struct st_mysql_sys_var *rocksdb_system_variables[] = {
     MYSQL_SYSVAR(tmpdir),
     MYSQL_SYSVAR(merge_combine_read_size),
     MYSQL_SYSVAR(merge_tmp_file_removal_delay_ms),
+    MYSQL_SYSVAR(merge_threads),
+    MYSQL_SYSVAR(check_table_threads),
     MYSQL_SYSVAR(skip_bloom_filter_on_read),
 
     MYSQL_SYSVAR(create_if_missing),
@@ -2462,6 +2625,8 @@ static struct st_mysql_sys_var *rocksdb_system_variables[] = {
     MYSQL_SYSVAR(wal_bytes_per_sync),
     MYSQL_SYSVAR(enable_thread_tracking),
     MYSQL_SYSVAR(perf_context_level),
+    MYSQL_SYSVAR(perf_context_trace),
+    MYSQL_SYSVAR(perf_context_trace_size),
     MYSQL_SYSVAR(wal_recovery_mode),
     MYSQL_SYSVAR(track_and_verify_wals_in_manifest),
     MYSQL_SYSVAR(stats_level),
@@ -2495,6 +2660,10 @@ static struct st_mysql_sys_var *rocksdb_system_variables[] = {
     MYSQL_SYSVAR(write_ignore_missing_column_families),
 
     MYSQL_SYSVAR(skip_fill_cache),
+    MYSQL_SYSVAR(scan_readahead_threshold),
+    MYSQL_SYSVAR(scan_readahead_session_limit),
+    MYSQL_SYSVAR(scan_readahead_size),
+    MYSQL_SYSVAR(scan_readahead_table_limit),
     MYSQL_SYSVAR(unsafe_for_binlog),
 
     MYSQL_SYSVAR(records_in_range),
@@ -2507,6 +2676,7 @@ static struct st_mysql_sys_var *rocksdb_system_variables[] = {
     MYSQL_SYSVAR(compact_cf),
     MYSQL_SYSVAR(delete_cf),
     MYSQL_SYSVAR(signal_drop_index_thread),
+    MYSQL_SYSVAR(drop_index_use_delete_range),
     MYSQL_SYSVAR(pause_background_work),
     MYSQL_SYSVAR(enable_2pc),
     MYSQL_SYSVAR(ignore_unknown_options),
@@ -2546,6 +2716,7 @@ static struct st_mysql_sys_var *rocksdb_system_variables[] = {
     MYSQL_SYSVAR(table_stats_recalc_threshold_count),
     MYSQL_SYSVAR(table_stats_max_num_rows_scanned),
     MYSQL_SYSVAR(table_stats_use_table_scan),
+    MYSQL_SYSVAR(table_stats_use_sketches),
     MYSQL_SYSVAR(table_stats_background_thread_nice_value),
 
     MYSQL_SYSVAR(large_prefix),
@@ -2565,11 +2736,16 @@ static struct st_mysql_sys_var *rocksdb_system_variables[] = {
     MYSQL_SYSVAR(select_bypass_fail_unsupported),
     MYSQL_SYSVAR(select_bypass_log_failed),
     MYSQL_SYSVAR(select_bypass_rejected_query_history_size),
+    MYSQL_SYSVAR(select_bypass_query_shapes_size),
+    MYSQL_SYSVAR(select_bypass_plan_cache_size),
     MYSQL_SYSVAR(select_bypass_log_rejected),
     MYSQL_SYSVAR(select_bypass_allow_filters),
     MYSQL_SYSVAR(select_bypass_debug_row_delay),
     MYSQL_SYSVAR(select_bypass_multiget_min),
     MYSQL_SYSVAR(mrr_batch_size),
+    MYSQL_SYSVAR(mrr_prefetch_threads),
+    MYSQL_SYSVAR(mrr_prefetch),
+    MYSQL_SYSVAR(sk_lookahead_batch_size),
     MYSQL_SYSVAR(skip_locks_if_skip_unique_check),
     MYSQL_SYSVAR(alter_column_default_inplace),
     MYSQL_SYSVAR(alter_table_comment_inplace),
@@ -2738,6 +2914,40 @@ static inline uint32_t rocksdb_perf_context_level(THD *const thd) {
   return rocksdb::PerfLevel::kDisable;
 }
 
+/*
+  Publish the perf context of the statement running on thd: the non-zero
+  counters are written to the slow query log, and the statement is offered
+  to information_schema.rocksdb_perf_context_queries.
+*/
+static void rdb_trace_stmt_perf_context(THD *const thd,
+                                        const Rdb_perf_counters &counters) {
+  std::string &summary = thd->engine_perf_context;
+  summary = "RocksDB_perf_context:";
+  for (int i = 0; i < PC_MAX_IDX; i++) {
+    if (counters.m_value[i] != 0) {
+      summary += " " + rdb_pc_stat_types[i] + ": " +
+                 std::to_string(counters.m_value[i]);
+    }
+  }
+
+  if (rocksdb_perf_context_trace_size == 0) {
+    return;
+  }
+
+  Rdb_query_perf_context query;
+  query.m_query_id = thd->query_id;
+  query.m_thread_id = thd_thread_id(thd);
+  const LEX_STRING *const lex_str = thd_query_string(thd);
+  if (lex_str != nullptr && lex_str->str != nullptr) {
+    query.m_query.assign(lex_str->str,
+                         std::min(lex_str->length,
+                                  Rdb_query_perf_context::MAX_QUERY_LENGTH));
+  }
+  std::copy_n(counters.m_value, PC_MAX_IDX, query.m_value);
+
+  rdb_query_perf_tracker.record(query, rocksdb_perf_context_trace_size);
+}
+
 /*
   Very short (functor-like) interface to be passed to
   Rdb_transaction::walk_tx_list()
@@ -2798,11 +3008,29 @@ class Rdb_transaction {
  protected:
   THD *m_thd = nullptr;
 
-  static std::multiset<Rdb_transaction *> s_tx_list;
-  static mysql_mutex_t s_tx_list_mutex;
+  /*
+    The global list of active transactions, split into shards with a mutex
+    each so that connections registering and unregistering do not contend
+    on a single lock. A transaction stays in the shard picked from its
+    connection id; walkers visit the shards one at a time.
+  */
+  struct alignas(INNOBASE_CACHE_LINE_SIZE) Rdb_tx_list_shard {
+    mysql_mutex_t m_mutex;
+    std::unordered_set<Rdb_transaction *> m_list;
+  };
+  static constexpr uint TX_LIST_SHARDS = 64;
+  static Rdb_tx_list_shard s_tx_list[TX_LIST_SHARDS];
+  uint m_tx_list_shard = 0;
 
   Rdb_io_perf *m_tbl_io_perf;
 
+  /*
+    Perf context of the statement with query id m_stmt_perf_query_id, only
+    collected with rocksdb_perf_context_trace
+  */
+  Rdb_perf_counters m_stmt_perf_counters;
+  query_id_t m_stmt_perf_query_id = 0;
+
   bool m_tx_read_only = false;
 
   int m_timeout_sec; /* Cached value of @@rocksdb_lock_wait_timeout */
@@ -2868,6 +3096,12 @@ class Rdb_transaction {
   */
   int64_t m_n_mysql_tables_in_use = 0;
 
+  /*
+    Number of scans of this session that read ahead, see
+    @@rocksdb_scan_readahead_session_limit
+  */
+  uint m_readahead_scans = 0;
+
   /*
     for distinction between rdb_transaction_impl and rdb_writebatch_impl
     when using walk tx list
@@ -2875,24 +3109,30 @@ class Rdb_transaction {
   virtual bool is_writebatch_trx() const = 0;
 
   static void init_mutex() {
-    mysql_mutex_init(key_mutex_tx_list, &s_tx_list_mutex, MY_MUTEX_INIT_FAST);
+    for (auto &shard : s_tx_list) {
+      mysql_mutex_init(key_mutex_tx_list, &shard.m_mutex, MY_MUTEX_INIT_FAST);
+    }
   }
 
   static void term_mutex() {
-    DBUG_ASSERT(s_tx_list.size() == 0);
-    mysql_mutex_destroy(&s_tx_list_mutex);
+    for (auto &shard : s_tx_list) {
+      DBUG_ASSERT(shard.m_list.size() == 0);
+      mysql_mutex_destroy(&shard.m_mutex);
+    }
   }
 
   static void walk_tx_list(Rdb_tx_list_walker *walker) {
     DBUG_ASSERT(walker != nullptr);
 
-    RDB_MUTEX_LOCK_CHECK(s_tx_list_mutex);
+    for (auto &shard : s_tx_list) {
+      RDB_MUTEX_LOCK_CHECK(shard.m_mutex);
 
-    for (auto it : s_tx_list) {
-      walker->process_tran(it);
-    }
+      for (auto it : shard.m_list) {
+        walker->process_tran(it);
+      }
 
-    RDB_MUTEX_UNLOCK_CHECK(s_tx_list_mutex);
+      RDB_MUTEX_UNLOCK_CHECK(shard.m_mutex);
+    }
   }
 
   int set_status_error(THD *const thd, const rocksdb::Status &s,
@@ -2977,8 +3217,22 @@ class Rdb_transaction {
 
   void io_perf_end_and_record(void) {
     if (m_tbl_io_perf != nullptr) {
-      m_tbl_io_perf->end_and_record(rocksdb_perf_context_level(m_thd));
+      const uint32_t perf_context_level = rocksdb_perf_context_level(m_thd);
+      const bool trace = THDVAR(m_thd, perf_context_trace) &&
+                         perf_context_level > rocksdb::PerfLevel::kDisable;
+
+      if (trace && m_stmt_perf_query_id != m_thd->query_id) {
+        m_stmt_perf_counters.reset();
+        m_stmt_perf_query_id = m_thd->query_id;
+      }
+
+      m_tbl_io_perf->end_and_record(
+          perf_context_level, trace ? &m_stmt_perf_counters : nullptr);
       m_tbl_io_perf = nullptr;
+
+      if (trace) {
+        rdb_trace_stmt_perf_context(m_thd, m_stmt_perf_counters);
+      }
     }
   }
 
@@ -3211,7 +3465,8 @@ class Rdb_transaction {
         table_name = "./" + table_name;
         auto sst_info = std::make_shared<Rdb_sst_info>(
             rdb, table_name, index_name, rdb_merge.get_cf(),
-            *rocksdb_db_options, THDVAR(get_thd(), trace_sst_api));
+            *rocksdb_db_options, THDVAR(get_thd(), trace_sst_api),
+            THDVAR(get_thd(), bulk_load_sst_threads));
 
         while ((rc2 = rdb_merge.next(&merge_key, &merge_val)) == 0) {
           if ((rc2 = sst_info->put(merge_key, merge_val)) != 0) {
@@ -3446,7 +3701,7 @@ class Rdb_transaction {
       rocksdb::ColumnFamilyHandle *const column_family, bool skip_bloom_filter,
       bool fill_cache, const rocksdb::Slice &eq_cond_lower_bound,
       const rocksdb::Slice &eq_cond_upper_bound, bool read_current = false,
-      bool create_snapshot = true) {
+      bool create_snapshot = true, size_t readahead_size = 0) {
     // Make sure we are not doing both read_current (which implies we don't
     // want a snapshot) and create_snapshot which makes sure we create
     // a snapshot
@@ -3472,6 +3727,7 @@ class Rdb_transaction {
       options.prefix_same_as_start = true;
     }
     options.fill_cache = fill_cache;
+    options.readahead_size = readahead_size;
     if (read_current) {
       options.snapshot = nullptr;
     }
@@ -3592,9 +3848,11 @@ class Rdb_transaction {
     needed by information_schema queries.
   */
   void add_to_global_trx_list() {
-    RDB_MUTEX_LOCK_CHECK(s_tx_list_mutex);
-    s_tx_list.insert(this);
-    RDB_MUTEX_UNLOCK_CHECK(s_tx_list_mutex);
+    m_tx_list_shard = thd_thread_id(m_thd) % TX_LIST_SHARDS;
+    auto &shard = s_tx_list[m_tx_list_shard];
+    RDB_MUTEX_LOCK_CHECK(shard.m_mutex);
+    shard.m_list.insert(this);
+    RDB_MUTEX_UNLOCK_CHECK(shard.m_mutex);
   }
 
   void remove_from_global_trx_list(void) {
@@ -3610,19 +3868,23 @@ class Rdb_transaction {
       thd->restore_globals();
       delete thd;
     });
-    RDB_MUTEX_LOCK_CHECK(s_tx_list_mutex);
-    s_tx_list.erase(this);
-    RDB_MUTEX_UNLOCK_CHECK(s_tx_list_mutex);
+    auto &shard = s_tx_list[m_tx_list_shard];
+    RDB_MUTEX_LOCK_CHECK(shard.m_mutex);
+    shard.m_list.erase(this);
+    RDB_MUTEX_UNLOCK_CHECK(shard.m_mutex);
   }
 
   explicit Rdb_transaction(THD *const thd)
-      : m_thd(thd), m_tbl_io_perf(nullptr) {}
+      : m_thd(thd), m_tbl_io_perf(nullptr) {
+    m_stmt_perf_counters.reset();
+  }
 
   virtual ~Rdb_transaction() {
 #ifndef DEBUG_OFF
-    RDB_MUTEX_LOCK_CHECK(s_tx_list_mutex);
-    DBUG_ASSERT(s_tx_list.find(this) == s_tx_list.end());
-    RDB_MUTEX_UNLOCK_CHECK(s_tx_list_mutex);
+    auto &shard = s_tx_list[m_tx_list_shard];
+    RDB_MUTEX_LOCK_CHECK(shard.m_mutex);
+    DBUG_ASSERT(shard.m_list.find(this) == shard.m_list.end());
+    RDB_MUTEX_UNLOCK_CHECK(shard.m_mutex);
 #endif
   }
 };
@@ -4283,8 +4545,8 @@ void Rdb_snapshot_notifier::SnapshotCreated(
   }
 }
 
-std::multiset<Rdb_transaction *> Rdb_transaction::s_tx_list;
-mysql_mutex_t Rdb_transaction::s_tx_list_mutex;
+Rdb_transaction::Rdb_tx_list_shard
+    Rdb_transaction::s_tx_list[Rdb_transaction::TX_LIST_SHARDS];
 
 Rdb_transaction *&get_tx_from_thd(THD *const thd) {
   return *reinterpret_cast<Rdb_transaction **>(
@@ -5670,11 +5932,21 @@ static int rocksdb_init_func(void *const p) {
                            rdb_signal_drop_idx_psi_cond_key);
   rdb_is_thread.init(rdb_signal_is_psi_mutex_key, rdb_signal_is_psi_cond_key);
   rdb_mc_thread.init(rdb_signal_mc_psi_mutex_key, rdb_signal_mc_psi_cond_key);
+  for (uint i = 0; i < rocksdb_mrr_prefetch_threads; i++) {
+    rdb_mrr_prefetch_threads.emplace_back(new Rdb_mrr_prefetch_thread());
+    rdb_mrr_prefetch_threads.back()->init(
+        rdb_signal_mrr_prefetch_psi_mutex_key,
+        rdb_signal_mrr_prefetch_psi_cond_key);
+  }
 #else
   rdb_bg_thread.init();
   rdb_drop_idx_thread.init();
   rdb_is_thread.init();
   rdb_mc_thread.init();
+  for (uint i = 0; i < rocksdb_mrr_prefetch_threads; i++) {
+    rdb_mrr_prefetch_threads.emplace_back(new Rdb_mrr_prefetch_thread());
+    rdb_mrr_prefetch_threads.back()->init();
+  }
 #endif
   mysql_mutex_init(rdb_collation_data_mutex_key, &rdb_collation_data_mutex,
                    MY_MUTEX_INIT_FAST);
@@ -6141,6 +6413,23 @@ static int rocksdb_init_func(void *const p) {
     DBUG_RETURN(HA_EXIT_FAILURE);
   }
 
+  for (size_t i = 0; i < rdb_mrr_prefetch_threads.size(); i++) {
+    const std::string name =
+        std::string(MRR_PREFETCH_THREAD_NAME) + "-" + std::to_string(i);
+#ifndef HAVE_PSI_INTERFACE
+    err = rdb_mrr_prefetch_threads[i]->create_thread(name);
+#else
+    err = rdb_mrr_prefetch_threads[i]->create_thread(
+        name, rdb_mrr_prefetch_psi_thread_key);
+#endif
+    if (err != 0) {
+      // NO_LINT_DEBUG
+      sql_print_error(
+          "RocksDB: Couldn't start the MRR prefetch thread: (errno=%d)", err);
+      DBUG_RETURN(HA_EXIT_FAILURE);
+    }
+  }
+
   rdb_set_collation_exception_list(rocksdb_strict_collation_exceptions);
 
   if (rocksdb_pause_background_work) {
@@ -6236,6 +6525,11 @@ static int rocksdb_done_func(void *const p) {
   // signal the manual compaction thread to stop
   rdb_mc_thread.signal(true);
 
+  // signal the MRR prefetch threads to stop
+  for (const auto &thread : rdb_mrr_prefetch_threads) {
+    thread->signal(true);
+  }
+
   // Wait for the background thread to finish.
   auto err = rdb_bg_thread.join();
   if (err != 0) {
@@ -6270,6 +6564,17 @@ static int rocksdb_done_func(void *const p) {
         "RocksDB: Couldn't stop the manual compaction thread: (errno=%d)", err);
   }
 
+  // Wait for the MRR prefetch threads to finish.
+  for (const auto &thread : rdb_mrr_prefetch_threads) {
+    err = thread->join();
+    if (err != 0) {
+      // NO_LINT_DEBUG
+      sql_print_error(
+          "RocksDB: Couldn't stop the MRR prefetch thread: (errno=%d)", err);
+    }
+  }
+  rdb_mrr_prefetch_threads.clear();
+
   if (rdb_open_tables.count()) {
     // Looks like we are getting unloaded and yet we have some open tables
     // left behind.
@@ -6707,6 +7012,8 @@ ha_rocksdb::ha_rocksdb(my_core::handlerton *const hton,
       m_scan_it(nullptr),
       m_scan_it_skips_bloom(false),
       m_scan_it_snapshot(nullptr),
+      m_scan_it_next_count(0),
+      m_scan_it_readahead(false),
       m_scan_it_lower_bound(nullptr),
       m_scan_it_upper_bound(nullptr),
       m_tbl_def(nullptr),
@@ -6728,7 +7035,11 @@ ha_rocksdb::ha_rocksdb(my_core::handlerton *const hton,
       m_insert_with_update(false),
       m_dup_key_found(false),
       mrr_rowid_reader(nullptr),
-      mrr_n_elements(0),
+      mrr_cur(&mrr_batches[0]),
+      mrr_next(&mrr_batches[1]),
+      mrr_read_index(0),
+      mrr_prefetch(false),
+      mrr_batch_limit(0),
       mrr_enabled_keyread(false),
       mrr_used_cpk(false),
       m_in_rpl_delete_rows(false),
@@ -7204,6 +7515,8 @@ int ha_rocksdb::open(const char *const name, int mode, uint test_if_locked) {
 int ha_rocksdb::close(void) {
   DBUG_ENTER_FUNC();
 
+  if (mrr_rowid_reader) mrr_free();
+
   m_pk_descr = nullptr;
   m_key_descr_arr = nullptr;
   m_converter = nullptr;
@@ -8838,6 +9151,209 @@ int ha_rocksdb::secondary_index_read(const int keyno, uchar *const buf) {
   return HA_ERR_END_OF_FILE;
 }
 
+/**
+  @brief
+  Check if the next secondary index read can go through the lookahead buffer.
+
+  @detail
+  The lookahead is only used for plain non-locking SELECTs. Locking reads and
+  DML keep using get_row_by_rowid() which takes the row locks.
+*/
+bool ha_rocksdb::sk_lookahead_usable() const {
+  THD *const thd = table->in_use;
+
+  return THDVAR(thd, sk_lookahead_batch_size) > 1 &&
+         m_lock_rows == RDB_LOCK_NONE &&
+         active_index != table->s->primary_key &&
+         my_core::thd_sql_command(thd) == SQLCOM_SELECT;
+}
+
+/**
+  @brief
+  Read ahead the secondary index and fetch the rows for a batch of index
+  records with one MultiGet call.
+
+  @detail
+  m_scan_it points at an index record that passed ICP. This record and up to
+  next_batch-1 following ones are collected; the first row is returned right
+  away and the rest are returned by subsequent sk_lookahead_next() calls.
+
+  The batch size starts at 1 for every scan and doubles on every refill up to
+  @@rocksdb_sk_lookahead_batch_size, so that ORDER BY ... LIMIT n does not
+  read far past the last row it needs.
+
+  Collection stops early at the first record that cannot be batched (index or
+  range end, covered lookup, error). In that case m_scan_it is left at that
+  record with m_skip_scan_it_next_call set, so that the regular scan path
+  re-examines it once the buffer is drained.
+
+  @return
+    HA_EXIT_SUCCESS  OK
+    other            HA_ERR error code (can be SE-specific)
+*/
+int ha_rocksdb::sk_lookahead_fill(uchar *const buf, const bool move_forward) {
+  const Rdb_key_def &kd = *m_key_descr_arr[active_index];
+  THD *const thd = table->in_use;
+  sk_lookahead_info &la = m_sk_lookahead;
+  const uint max_batch = THDVAR(thd, sk_lookahead_batch_size);
+  const uint n_elements = std::min(la.next_batch, max_batch);
+
+  la.clear();
+  la.forward = move_forward;
+  la.next_batch = std::min(la.next_batch * 2, max_batch);
+
+  if (n_elements < 2) {
+    return secondary_index_read(active_index, buf);
+  }
+
+  // true <=> m_scan_it has moved past the last buffered record
+  bool stepped = false;
+
+  for (;;) {
+    if (!is_valid_iterator(m_scan_it)) break;
+
+    const rocksdb::Slice key = m_scan_it->key();
+    if (!kd.covers_key(key)) break;
+
+    const rocksdb::Slice value = m_scan_it->value();
+    if ((m_keyread_only && kd.can_cover_lookup()) ||
+        kd.covers_lookup(&value, m_converter->get_lookup_bitmap())) {
+      // Covered lookups do not need the PK record
+      break;
+    }
+
+    const uint pk_size =
+        kd.get_primary_key_tuple(table, *m_pk_descr, &key, m_pk_packed_tuple);
+    if (pk_size == RDB_INVALID_KEY_LEN) break;
+
+    sk_lookahead_info::entry e;
+    e.sk_offset = la.sk_buf.size();
+    e.sk_len = key.size();
+    e.pk_offset = la.pk_buf.size();
+    e.pk_len = pk_size;
+    la.sk_buf.append(key.data(), key.size());
+    la.pk_buf.append(reinterpret_cast<const char *>(m_pk_packed_tuple),
+                     pk_size);
+    la.entries.push_back(e);
+    stepped = false;
+
+    if (la.entries.size() == n_elements || thd->killed) break;
+
+    if (move_forward) {
+      scan_it_next(kd);
+    } else {
+      m_scan_it->Prev();
+    }
+    stepped = true;
+
+    if (rocksdb_skip_expired_records(kd, m_scan_it, !move_forward) ||
+        find_icp_matching_index_rec(move_forward, buf)) {
+      break;
+    }
+  }
+
+  if (la.entries.empty()) {
+    // The current record cannot be batched, read it the usual way
+    return secondary_index_read(active_index, buf);
+  }
+
+  // If m_scan_it is on a record we haven't buffered, the scan must not step
+  // over it once the buffer is drained.
+  m_skip_scan_it_next_call = stepped;
+
+  const uint n_keys = la.entries.size();
+  if (la.values_size < n_keys) {
+    la.values.reset(new rocksdb::PinnableSlice[max_batch]);
+    la.values_size = max_batch;
+  }
+  la.statuses.resize(n_keys);
+  for (const auto &e : la.entries) {
+    la.keys.emplace_back(la.pk_buf.data() + e.pk_offset, e.pk_len);
+  }
+
+  Rdb_transaction *const tx = get_or_create_tx(thd);
+  tx->acquire_snapshot(true);
+  tx->multi_get(m_pk_descr->get_cf(), n_keys, la.keys.data(), la.values.get(),
+                la.statuses.data(), false);
+
+  global_stats.sk_lookahead_batches.inc();
+  global_stats.sk_lookahead_keys.add(n_keys);
+
+  return sk_lookahead_next(buf);
+}
+
+/**
+  @brief
+  Return the next row from the lookahead buffer.
+
+  @return
+    HA_EXIT_SUCCESS  OK
+    other            HA_ERR error code (can be SE-specific)
+*/
+int ha_rocksdb::sk_lookahead_next(uchar *const buf) {
+  DBUG_ASSERT(m_sk_lookahead.has_rows());
+
+  sk_lookahead_info &la = m_sk_lookahead;
+  const uint cur = la.read_index++;
+  const rocksdb::Slice &rowkey = la.keys[cur];
+  const rocksdb::Status &s = la.statuses[cur];
+
+  stats.rows_requested++;
+  table->status = STATUS_NOT_FOUND;
+
+  if (!s.ok()) {
+    if (s.IsNotFound()) return HA_ERR_KEY_NOT_FOUND;
+
+    Rdb_transaction *const tx = get_or_create_tx(table->in_use);
+    return tx->set_status_error(table->in_use, s, *m_pk_descr, m_tbl_def,
+                                m_table_handler);
+  }
+
+  m_retrieved_record.Reset();
+  m_retrieved_record.PinSlice(la.values[cur], &la.values[cur]);
+
+  /* If we found the record, but it's expired, pretend we didn't find it.  */
+  Rdb_transaction *const tx = get_tx_from_thd(table->in_use);
+  if (m_pk_descr->has_ttl() &&
+      should_hide_ttl_rec(*m_pk_descr, m_retrieved_record,
+                          tx->m_snapshot_timestamp)) {
+    return HA_ERR_KEY_NOT_FOUND;
+  }
+
+  m_last_rowkey.copy(rowkey.data(), rowkey.size(), &my_charset_bin);
+  const int rc = convert_record_from_storage_format(&rowkey, buf);
+
+  if (!rc) {
+    table->status = 0;
+    stats.rows_read++;
+    stats.rows_index_next++;
+    update_row_stats(ROWS_READ);
+  }
+  return rc;
+}
+
+/**
+  @brief
+  Drop the lookahead buffer when the scan changes direction.
+
+  @detail
+  m_scan_it is ahead of the last row returned to the SQL layer, so put it back
+  on the index record of that row. The record is guaranteed to exist as the
+  iterator reads from the same snapshot.
+*/
+void ha_rocksdb::sk_lookahead_reposition() {
+  DBUG_ASSERT(m_sk_lookahead.read_index > 0);
+
+  const rocksdb::Slice last_key =
+      m_sk_lookahead.sk(m_sk_lookahead.read_index - 1);
+  m_scan_it->Seek(last_key);
+  DBUG_ASSERT(is_valid_iterator(m_scan_it) &&
+              m_scan_it->key().compare(last_key) == 0);
+
+  m_skip_scan_it_next_call = false;
+  m_sk_lookahead.reset();
+}
+
 /*
   ha_rocksdb::read_range_first overrides handler::read_range_first.
   The only difference from handler::read_range_first is that
@@ -9217,67 +9733,553 @@ int ha_rocksdb::index_read_last_map(uchar *const buf, const uchar *const key,
   DBUG_RETURN(index_read_map(buf, key, keypart_map, HA_READ_PREFIX_LAST));
 }
 
-/**
-   @return
-    HA_ADMIN_OK      OK
-    other            HA_ADMIN error code
+/*
+  CHECK TABLE with several threads. Every index is split into key ranges at
+  SST file boundaries and the ranges are handed out to the threads. All of
+  them read the same RocksDB snapshot, and each thread decodes and packs rows
+  through its own copy of the TABLE, as Rdb_key_def::pack_record() moves the
+  fields of the table it is given.
+
+  On top of the checks done by the serial CHECK TABLE, the number of entries
+  of every secondary index is compared to the number of table records, which
+  catches records missing from an index.
 */
-int ha_rocksdb::check(THD *const thd, HA_CHECK_OPT *const check_opt) {
-  DBUG_ENTER_FUNC();
+class Rdb_parallel_check {
+ public:
+  Rdb_parallel_check(THD *const thd, TABLE *const table,
+                     const Rdb_tbl_def *const tbl_def, const uint pk,
+                     const bool hidden_pk, const uint n_threads)
+      : m_thd(thd),
+        m_table(table),
+        m_tbl_def(tbl_def),
+        m_pk(pk),
+        m_hidden_pk(hidden_pk),
+        m_n_threads(n_threads),
+        m_table_name(table->s->table_name.str),
+        m_snapshot(nullptr),
+        m_next_range(0),
+        m_ranges_done(0),
+        m_table_checksums(0),
+        m_failed(false),
+        m_counts(new Rdb_index_counts[tbl_def->m_key_count]),
+        m_max_packed_len(0) {}
+
+  ~Rdb_parallel_check() {
+    for (const auto &worker : m_workers) {
+      worker->m_converter.reset();
+      closefrm(&worker->m_table, false);
+    }
+    if (m_snapshot != nullptr) {
+      rdb->ReleaseSnapshot(m_snapshot);
+    }
+  }
+
+  Rdb_parallel_check(const Rdb_parallel_check &) = delete;
+  Rdb_parallel_check &operator=(const Rdb_parallel_check &) = delete;
+
+  int run();
 
-  DBUG_ASSERT(thd != nullptr);
-  DBUG_ASSERT(check_opt != nullptr);
+ private:
+  /*
+    A key range of one index, checked as a whole by one thread.
+    m_end is empty for the last range of the index.
+  */
+  struct Rdb_check_range {
+    uint m_keyno;
+    std::string m_start;
+    std::string m_end;
+  };
+
+  struct Rdb_index_counts {
+    std::atomic<ha_rows> m_rows{0};
+    std::atomic<ha_rows> m_checksums{0};
+  };
+
+  struct Rdb_worker {
+    Rdb_parallel_check *m_check;
+    TABLE m_table;
+    std::unique_ptr<Rdb_converter> m_converter;
+    std::vector<uchar> m_pk_tuple;
+    std::vector<uchar> m_packed_tuple;
+    std::vector<uchar> m_pack_buffer;
+    std::string m_row;
+  };
+
+  void split_index(const uint keyno,
+                   const std::vector<rocksdb::LiveFileMetaData> &files);
+  int add_worker();
+  static void *thread_func(void *const worker_ptr);
+  void run_thread(Rdb_worker *const worker);
+  bool check_range(Rdb_worker *const worker, const Rdb_check_range &range);
+  bool check_pk_entry(Rdb_worker *const worker, const rocksdb::Slice &key,
+                      const rocksdb::Slice &value);
+  bool check_sk_entry(Rdb_worker *const worker, const uint keyno,
+                      const rocksdb::Slice &key, const rocksdb::Slice &value);
+  void print_entry(const char *const what, const rocksdb::Slice &entry) const;
+  void report_progress();
+
+  THD *const m_thd;
+  TABLE *const m_table;
+  const Rdb_tbl_def *const m_tbl_def;
+  const uint m_pk;
+  const bool m_hidden_pk;
+  const uint m_n_threads;
+  const char *const m_table_name;
+
+  const rocksdb::Snapshot *m_snapshot;
+  rocksdb::ReadOptions m_read_opts;
 
-  const uint pk = pk_index(table, m_tbl_def);
-  String rowkey_copy;
-  String sec_key_copy;
-  const char *const table_name = table->s->table_name.str;
+  std::vector<Rdb_check_range> m_ranges;
+  std::atomic<size_t> m_next_range;
+  std::atomic<size_t> m_ranges_done;
+  std::atomic<ha_rows> m_table_checksums;
+  std::atomic<bool> m_failed;
 
-  // Only when debugging: don't use snapshot when reading
-  // Rdb_transaction *tx= get_or_create_tx(table->in_use);
-  // tx->snapshot= nullptr;
+  // indexed by key number
+  std::unique_ptr<Rdb_index_counts[]> m_counts;
+  std::vector<std::unique_ptr<Rdb_worker>> m_workers;
+  uint m_max_packed_len;
+};
 
-  bool save_verify_row_debug_checksums =
-      m_converter->get_verify_row_debug_checksums();
-  m_converter->set_verify_row_debug_checksums(true);
-  /* For each secondary index, check that we can get a PK value from it */
-  // NO_LINT_DEBUG
-  sql_print_information("CHECKTABLE %s: Checking table %s", table_name,
-                        table_name);
-  ha_rows UNINIT_VAR(row_checksums_at_start);  // set/used iff first_index==true
-  ha_rows row_checksums = ha_rows(-1);
-  bool first_index = true;
+/*
+  Splits the key space of an index at the smallest keys of the SST files
+  which hold entries of it, keeping a few ranges per thread.
+*/
+void Rdb_parallel_check::split_index(
+    const uint keyno, const std::vector<rocksdb::LiveFileMetaData> &files) {
+  const Rdb_key_def &kd = *m_tbl_def->m_key_descr_arr[keyno];
+  const rocksdb::Comparator *const cmp = kd.get_cf()->GetComparator();
+  const std::string cf_name = kd.get_cf()->GetName();
 
-  for (uint keyno = 0; keyno < table->s->keys; keyno++) {
-    if (keyno != pk) {
-      extra(HA_EXTRA_KEYREAD);
-      ha_index_init(keyno, true);
-      ha_rows rows = 0;
-      ha_rows checksums = 0;
-      if (first_index) {
-        row_checksums_at_start = m_converter->get_row_checksums_checked();
-      }
-      int res;
-      // NO_LINT_DEBUG
-      sql_print_information("CHECKTABLE %s:   Checking index %s", table_name,
-                            table->key_info[keyno].name);
-      while (1) {
-        if (!rows) {
-          res = index_first(table->record[0]);
-        } else {
-          res = index_next(table->record[0]);
-        }
+  uchar buf[Rdb_key_def::INDEX_NUMBER_SIZE * 2];
+  const rocksdb::Range range = get_range(kd, buf);
 
-        if (res == HA_ERR_END_OF_FILE) break;
-        if (res) {
-          // error
-          // NO_LINT_DEBUG
-          sql_print_error("CHECKTABLE %s:   .. row %lld: index scan error %d",
-                          table_name, rows, res);
-          goto error;
-        }
-        rocksdb::Slice key = m_scan_it->key();
-        sec_key_copy.copy(key.data(), key.size(), &my_charset_bin);
+  std::vector<std::string> bounds;
+  for (const auto &file : files) {
+    if (file.column_family_name == cf_name &&
+        kd.covers_key(rocksdb::Slice(file.smallestkey)) &&
+        cmp->Compare(file.smallestkey, range.start) > 0) {
+      bounds.push_back(file.smallestkey);
+    }
+  }
+  std::sort(bounds.begin(), bounds.end(),
+            [cmp](const std::string &a, const std::string &b) {
+              return cmp->Compare(a, b) < 0;
+            });
+  bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+
+  const size_t max_ranges = m_n_threads * RDB_CHECK_RANGES_PER_THREAD;
+  const size_t n_ranges = std::min(bounds.size() + 1, max_ranges);
+
+  std::string start = range.start.ToString();
+  for (size_t i = 1; i < n_ranges; i++) {
+    const std::string &end = bounds[i * bounds.size() / n_ranges];
+    m_ranges.push_back({keyno, start, end});
+    start = end;
+  }
+  m_ranges.push_back({keyno, start, std::string()});
+
+  m_max_packed_len = std::max(m_max_packed_len, kd.max_storage_fmt_length());
+}
+
+int Rdb_parallel_check::add_worker() {
+  std::unique_ptr<Rdb_worker> worker(new Rdb_worker());
+  worker->m_check = this;
+  if (open_table_from_share(m_thd, m_table->s, "", 0, 0, 0, &worker->m_table,
+                            false)) {
+    return HA_EXIT_FAILURE;
+  }
+
+  bitmap_set_all(worker->m_table.read_set);
+  worker->m_converter.reset(
+      new Rdb_converter(m_thd, m_tbl_def, &worker->m_table));
+  worker->m_converter->set_verify_row_debug_checksums(true);
+  worker->m_converter->setup_field_decoders(worker->m_table.read_set, m_pk,
+                                            false, true);
+  worker->m_pk_tuple.resize(m_max_packed_len);
+  worker->m_packed_tuple.resize(m_max_packed_len);
+  worker->m_pack_buffer.resize(m_max_packed_len);
+
+  m_workers.push_back(std::move(worker));
+  return HA_EXIT_SUCCESS;
+}
+
+void *Rdb_parallel_check::thread_func(void *const worker_ptr) {
+  DBUG_ASSERT(worker_ptr != nullptr);
+  Rdb_worker *const worker = static_cast<Rdb_worker *>(worker_ptr);
+  my_thread_init();
+  worker->m_check->run_thread(worker);
+  my_thread_end();
+  return nullptr;
+}
+
+void Rdb_parallel_check::run_thread(Rdb_worker *const worker) {
+  for (;;) {
+    const size_t i = m_next_range++;
+    if (i >= m_ranges.size() || m_failed || m_thd->killed) {
+      break;
+    }
+
+    if (!check_range(worker, m_ranges[i])) {
+      m_failed = true;
+      break;
+    }
+    report_progress();
+  }
+}
+
+bool Rdb_parallel_check::check_range(Rdb_worker *const worker,
+                                     const Rdb_check_range &range) {
+  const Rdb_key_def &kd = *m_tbl_def->m_key_descr_arr[range.m_keyno];
+  const rocksdb::Comparator *const cmp = kd.get_cf()->GetComparator();
+  const ha_rows row_checksums_at_start =
+      worker->m_converter->get_row_checksums_checked();
+  ha_rows rows = 0;
+  ha_rows checksums = 0;
+  bool ok = true;
+
+  std::unique_ptr<rocksdb::Iterator> it(
+      rdb->NewIterator(m_read_opts, kd.get_cf()));
+  for (it->Seek(range.m_start); is_valid_iterator(it.get()); it->Next()) {
+    const rocksdb::Slice key = it->key();
+    if (!kd.covers_key(key) ||
+        (!range.m_end.empty() && cmp->Compare(key, range.m_end) >= 0)) {
+      break;
+    }
+
+    if (m_failed || m_thd->killed) {
+      ok = false;
+      break;
+    }
+
+    if (range.m_keyno == m_pk) {
+      ok = check_pk_entry(worker, key, it->value());
+    } else {
+      if (kd.unpack_info_has_checksum(it->value())) {
+        checksums++;
+      }
+      ok = check_sk_entry(worker, range.m_keyno, key, it->value());
+    }
+    if (!ok) {
+      break;
+    }
+    rows++;
+  }
+
+  if (ok && !it->status().ok()) {
+    // NO_LINT_DEBUG
+    sql_print_error("CHECKTABLE %s:   .. index %s: scan error %s",
+                    m_table_name, kd.get_name().c_str(),
+                    it->status().ToString().c_str());
+    ok = false;
+  }
+
+  m_counts[range.m_keyno].m_rows += rows;
+  m_counts[range.m_keyno].m_checksums += checksums;
+  if (range.m_keyno == m_pk) {
+    m_table_checksums += worker->m_converter->get_row_checksums_checked() -
+                         row_checksums_at_start;
+  }
+  return ok;
+}
+
+bool Rdb_parallel_check::check_pk_entry(Rdb_worker *const worker,
+                                        const rocksdb::Slice &key,
+                                        const rocksdb::Slice &value) {
+  const int res = worker->m_converter->decode(m_tbl_def->m_key_descr_arr[m_pk],
+                                              worker->m_table.record[0], &key,
+                                              &value);
+  if (res) {
+    // NO_LINT_DEBUG
+    sql_print_error("CHECKTABLE %s:   .. failed to decode record, error %d",
+                    m_table_name, res);
+    print_entry("rowkey", key);
+    print_entry("record", value);
+    return false;
+  }
+  return true;
+}
+
+bool Rdb_parallel_check::check_sk_entry(Rdb_worker *const worker,
+                                        const uint keyno,
+                                        const rocksdb::Slice &key,
+                                        const rocksdb::Slice &value) {
+  const std::shared_ptr<Rdb_key_def> &kd = m_tbl_def->m_key_descr_arr[keyno];
+  const std::shared_ptr<Rdb_key_def> &pk_descr =
+      m_tbl_def->m_key_descr_arr[m_pk];
+  TABLE *const table = &worker->m_table;
+  uchar *const record = table->record[0];
+
+  if (kd->unpack_record(table, record, &key, &value, true)) {
+    // NO_LINT_DEBUG
+    sql_print_error("CHECKTABLE %s:   .. index %s: failed to unpack entry",
+                    m_table_name, kd->get_name().c_str());
+    print_entry("index", key);
+    return false;
+  }
+
+  const uint pk_size = kd->get_primary_key_tuple(table, *pk_descr, &key,
+                                                 worker->m_pk_tuple.data());
+  if (pk_size == RDB_INVALID_KEY_LEN) {
+    // NO_LINT_DEBUG
+    sql_print_error("CHECKTABLE %s:   .. index %s: no rowid in entry",
+                    m_table_name, kd->get_name().c_str());
+    print_entry("index", key);
+    return false;
+  }
+  const rocksdb::Slice rowkey(
+      reinterpret_cast<const char *>(worker->m_pk_tuple.data()), pk_size);
+
+  const rocksdb::Status s =
+      rdb->Get(m_read_opts, pk_descr->get_cf(), rowkey, &worker->m_row);
+  const rocksdb::Slice row(worker->m_row);
+  if (!s.ok() || worker->m_converter->decode(pk_descr, record, &rowkey, &row)) {
+    // NO_LINT_DEBUG
+    sql_print_error(
+        "CHECKTABLE %s:   .. index %s: failed to fetch row by rowid",
+        m_table_name, kd->get_name().c_str());
+    print_entry("rowkey", rowkey);
+    print_entry("index", key);
+    return false;
+  }
+
+  longlong hidden_pk_id = 0;
+  if (m_hidden_pk) {
+    if (pk_size < Rdb_key_def::INDEX_NUMBER_SIZE + Field_longlong::PACK_LENGTH) {
+      // NO_LINT_DEBUG
+      sql_print_error("CHECKTABLE %s:   .. index %s: bad hidden rowid",
+                      m_table_name, kd->get_name().c_str());
+      print_entry("rowkey", rowkey);
+      return false;
+    }
+    const uchar *from =
+        worker->m_pk_tuple.data() + Rdb_key_def::INDEX_NUMBER_SIZE;
+    hidden_pk_id = rdb_netbuf_read_uint64(&from);
+  }
+
+  /* Check if we get the same PK value */
+  uint packed_size = pk_descr->pack_record(
+      table, worker->m_pack_buffer.data(), record,
+      worker->m_packed_tuple.data(), nullptr, false, hidden_pk_id);
+  if (packed_size != pk_size ||
+      memcmp(worker->m_packed_tuple.data(), rowkey.data(), packed_size)) {
+    // NO_LINT_DEBUG
+    sql_print_error("CHECKTABLE %s:   .. index %s: PK value mismatch",
+                    m_table_name, kd->get_name().c_str());
+    print_entry("rowkey", rowkey);
+    print_entry("record", row);
+    print_entry("index", key);
+    return false;
+  }
+
+  /* Check if we get the same secondary key value */
+  packed_size = kd->pack_record(table, worker->m_pack_buffer.data(), record,
+                                worker->m_packed_tuple.data(), nullptr, false,
+                                hidden_pk_id);
+  if (packed_size != key.size() ||
+      memcmp(worker->m_packed_tuple.data(), key.data(), packed_size)) {
+    // NO_LINT_DEBUG
+    sql_print_error(
+        "CHECKTABLE %s:   .. index %s: secondary index value mismatch",
+        m_table_name, kd->get_name().c_str());
+    print_entry("rowkey", rowkey);
+    print_entry("record", row);
+    print_entry("index", key);
+    return false;
+  }
+
+  return true;
+}
+
+void Rdb_parallel_check::print_entry(const char *const what,
+                                     const rocksdb::Slice &entry) const {
+  const std::string buf =
+      rdb_hexdump(entry.data(), entry.size(), RDB_MAX_HEXDUMP_LEN);
+  // NO_LINT_DEBUG
+  sql_print_error("CHECKTABLE %s:   %s: %s", m_table_name, what, buf.c_str());
+}
+
+/*
+  Logs progress every time another tenth of the key ranges is checked.
+*/
+void Rdb_parallel_check::report_progress() {
+  const size_t done = ++m_ranges_done;
+  const size_t total = m_ranges.size();
+  if (done * 10 / total != (done - 1) * 10 / total) {
+    // NO_LINT_DEBUG
+    sql_print_information("CHECKTABLE %s:   %zu of %zu key ranges checked",
+                          m_table_name, done, total);
+  }
+}
+
+/**
+   @return
+    HA_ADMIN_OK       OK
+    HA_ADMIN_CORRUPT  an inconsistency was found
+    HA_ADMIN_FAILED   the check could not be completed
+*/
+int Rdb_parallel_check::run() {
+  // NO_LINT_DEBUG
+  sql_print_information("CHECKTABLE %s: Checking table %s with %u threads",
+                        m_table_name, m_table_name, m_n_threads);
+
+  std::vector<rocksdb::LiveFileMetaData> files;
+  rdb->GetLiveFilesMetaData(&files);
+  split_index(m_pk, files);
+  for (uint keyno = 0; keyno < m_table->s->keys; keyno++) {
+    if (keyno != m_pk) {
+      split_index(keyno, files);
+    }
+  }
+
+  const size_t n_workers = std::min<size_t>(m_n_threads, m_ranges.size());
+  for (size_t i = 0; i < n_workers; i++) {
+    if (add_worker()) {
+      // NO_LINT_DEBUG
+      sql_print_error("CHECKTABLE %s: failed to open table", m_table_name);
+      return HA_ADMIN_FAILED;
+    }
+  }
+
+  m_snapshot = rdb->GetSnapshot();
+  m_read_opts.snapshot = m_snapshot;
+  m_read_opts.total_order_seek = true;
+  m_read_opts.fill_cache = false;
+
+  // This thread checks ranges as well, and takes over the ranges of any
+  // thread that could not be started
+  std::vector<pthread_t> threads;
+  for (size_t i = 1; i < m_workers.size(); i++) {
+    pthread_t handle;
+    if (mysql_thread_create(rdb_check_table_psi_thread_key, &handle, nullptr,
+                            thread_func, m_workers[i].get())) {
+      // NO_LINT_DEBUG
+      sql_print_warning("CHECKTABLE %s: failed to start check thread %zu",
+                        m_table_name, i);
+      break;
+    }
+    threads.push_back(handle);
+  }
+  run_thread(m_workers[0].get());
+  for (const auto &handle : threads) {
+    pthread_join(handle, nullptr);
+  }
+
+  if (m_thd->killed) {
+    return HA_ADMIN_FAILED;
+  }
+  if (m_failed) {
+    return HA_ADMIN_CORRUPT;
+  }
+
+  const ha_rows table_rows = m_counts[m_pk].m_rows;
+  int ret = HA_ADMIN_OK;
+  for (uint keyno = 0; keyno < m_table->s->keys; keyno++) {
+    if (keyno == m_pk) {
+      continue;
+    }
+    const Rdb_key_def &kd = *m_tbl_def->m_key_descr_arr[keyno];
+    const ha_rows rows = m_counts[keyno].m_rows;
+    // NO_LINT_DEBUG
+    sql_print_information(
+        "CHECKTABLE %s:   ... %lld index entries checked in index %s "
+        "(%lld had checksums)",
+        m_table_name, rows, m_table->key_info[keyno].name,
+        static_cast<ha_rows>(m_counts[keyno].m_checksums));
+
+    // Partial indexes are only materialized for some key prefixes
+    if (!kd.is_partial_index() && rows != table_rows) {
+      // NO_LINT_DEBUG
+      sql_print_error(
+          "CHECKTABLE %s:   .. index %s has %lld entries for %lld records",
+          m_table_name, kd.get_name().c_str(), rows, table_rows);
+      ret = HA_ADMIN_CORRUPT;
+    }
+  }
+
+  // NO_LINT_DEBUG
+  sql_print_information(
+      "CHECKTABLE %s:   %lld table records checked (%lld had checksums)",
+      m_table_name, table_rows, static_cast<ha_rows>(m_table_checksums));
+
+  return ret;
+}
+
+/**
+   @return
+    HA_ADMIN_OK      OK
+    other            HA_ADMIN error code
+*/
+int ha_rocksdb::check(THD *const thd, HA_CHECK_OPT *const check_opt) {
+  DBUG_ENTER_FUNC();
+
+  DBUG_ASSERT(thd != nullptr);
+  DBUG_ASSERT(check_opt != nullptr);
+
+  const uint pk = pk_index(table, m_tbl_def);
+
+  /*
+    Partitioned tables and tables with TTL keep the serial check: the former
+    can't be reopened from their share without the partitioning context, and
+    for the latter the raw reads of the threads would see expired records.
+  */
+  const uint check_threads = THDVAR(thd, check_table_threads);
+  if (check_threads > 1 && table->part_info == nullptr &&
+      !m_pk_descr->has_ttl()) {
+    Rdb_parallel_check checker(thd, table, m_tbl_def, pk, has_hidden_pk(table),
+                               check_threads);
+    DBUG_RETURN(checker.run());
+  }
+
+  String rowkey_copy;
+  String sec_key_copy;
+  const char *const table_name = table->s->table_name.str;
+
+  // Only when debugging: don't use snapshot when reading
+  // Rdb_transaction *tx= get_or_create_tx(table->in_use);
+  // tx->snapshot= nullptr;
+
+  bool save_verify_row_debug_checksums =
+      m_converter->get_verify_row_debug_checksums();
+  m_converter->set_verify_row_debug_checksums(true);
+  /* For each secondary index, check that we can get a PK value from it */
+  // NO_LINT_DEBUG
+  sql_print_information("CHECKTABLE %s: Checking table %s", table_name,
+                        table_name);
+  ha_rows UNINIT_VAR(row_checksums_at_start);  // set/used iff first_index==true
+  ha_rows row_checksums = ha_rows(-1);
+  bool first_index = true;
+
+  for (uint keyno = 0; keyno < table->s->keys; keyno++) {
+    if (keyno != pk) {
+      extra(HA_EXTRA_KEYREAD);
+      ha_index_init(keyno, true);
+      ha_rows rows = 0;
+      ha_rows checksums = 0;
+      if (first_index) {
+        row_checksums_at_start = m_converter->get_row_checksums_checked();
+      }
+      int res;
+      // NO_LINT_DEBUG
+      sql_print_information("CHECKTABLE %s:   Checking index %s", table_name,
+                            table->key_info[keyno].name);
+      while (1) {
+        if (!rows) {
+          res = index_first(table->record[0]);
+        } else {
+          res = index_next(table->record[0]);
+        }
+
+        if (res == HA_ERR_END_OF_FILE) break;
+        if (res) {
+          // error
+          // NO_LINT_DEBUG
+          sql_print_error("CHECKTABLE %s:   .. row %lld: index scan error %d",
+                          table_name, rows, res);
+          goto error;
+        }
+        rocksdb::Slice key = m_scan_it->key();
+        sec_key_copy.copy(key.data(), key.size(), &my_charset_bin);
         rowkey_copy.copy(m_last_rowkey.ptr(), m_last_rowkey.length(),
                          &my_charset_bin);
 
@@ -9603,11 +10605,24 @@ int ha_rocksdb::index_next_with_direction(uchar *const buf, bool move_forward) {
         rc = HA_ERR_QUERY_INTERRUPTED;
         break;
       }
+      if (!m_sk_lookahead.empty()) {
+        if (m_sk_lookahead.forward != move_forward) {
+          sk_lookahead_reposition();
+        } else if (m_sk_lookahead.has_rows()) {
+          rc = sk_lookahead_next(buf);
+          if (!should_skip_invalidated_record(rc)) {
+            break;
+          }
+          continue;
+        } else {
+          m_sk_lookahead.clear();
+        }
+      }
       if (m_skip_scan_it_next_call) {
         m_skip_scan_it_next_call = false;
       } else {
         if (move_forward) {
-          m_scan_it->Next(); /* this call cannot fail */
+          scan_it_next(*m_key_descr_arr[active_index]); /* cannot fail */
         } else {
           m_scan_it->Prev();
         }
@@ -9618,7 +10633,10 @@ int ha_rocksdb::index_next_with_direction(uchar *const buf, bool move_forward) {
         break;
       }
       rc = find_icp_matching_index_rec(move_forward, buf);
-      if (!rc) rc = secondary_index_read(active_index, buf);
+      if (!rc) {
+        rc = sk_lookahead_usable() ? sk_lookahead_fill(buf, move_forward)
+                 : secondary_index_read(active_index, buf);
+      }
       if (!should_skip_invalidated_record(rc)) {
         break;
       }
@@ -10530,7 +11548,8 @@ int ha_rocksdb::bulk_load_key(Rdb_transaction *const tx, const Rdb_key_def &kd,
   if (m_sst_info == nullptr || m_sst_info->is_done()) {
     m_sst_info.reset(new Rdb_sst_info(rdb, m_table_handler->m_table_name,
                                       kd.get_name(), cf, *rocksdb_db_options,
-                                      THDVAR(ha_thd(), trace_sst_api)));
+                                      THDVAR(ha_thd(), trace_sst_api),
+                                      THDVAR(ha_thd(), bulk_load_sst_threads)));
     res = tx->start_bulk_load(this, m_sst_info);
     if (res != HA_EXIT_SUCCESS) {
       DBUG_RETURN(res);
@@ -10770,8 +11789,11 @@ int ha_rocksdb::update_write_sk(const TABLE *const table_arg,
     old_key_slice = rocksdb::Slice(
         reinterpret_cast<const char *>(m_sk_packed_tuple_old), old_packed_size);
 
-    row_info.tx->get_indexed_write_batch()->SingleDelete(kd.get_cf(),
-                                                         old_key_slice);
+    // Leaves a stale entry behind, for testing CHECK TABLE
+    if (!DBUG_EVALUATE_IF("myrocks_skip_sk_delete", true, false)) {
+      row_info.tx->get_indexed_write_batch()->SingleDelete(kd.get_cf(),
+                                                           old_key_slice);
+    }
 
     bytes_written = old_key_slice.size();
   }
@@ -10782,6 +11804,9 @@ int ha_rocksdb::update_write_sk(const TABLE *const table_arg,
       rocksdb::Slice(reinterpret_cast<const char *>(m_sk_tails.ptr()),
                      m_sk_tails.get_current_pos());
 
+  // Leaves the record without an index entry, for testing CHECK TABLE
+  DBUG_EXECUTE_IF("myrocks_skip_sk_put", return HA_EXIT_SUCCESS;);
+
   if (bulk_load_sk && row_info.old_data == nullptr) {
     rc = bulk_load_key(row_info.tx, kd, new_key_slice, new_value_slice, true);
   } else {
@@ -11028,6 +12053,9 @@ void ha_rocksdb::setup_scan_iterator(const Rdb_key_def &kd,
     release_scan_iterator();
   }
 
+  /* The iterator is about to be repositioned, drop any rows read ahead */
+  m_sk_lookahead.reset();
+
   /*
     SQL layer can call rnd_init() multiple times in a row.
     In that case, re-use the iterator, but re-position it at the table start.
@@ -11050,18 +12078,96 @@ void ha_rocksdb::setup_scan_iterator(const Rdb_key_def &kd,
     }
     m_scan_it_skips_bloom = skip_bloom;
   }
+  m_scan_it_next_count = 0;
 }
 
 void ha_rocksdb::release_scan_iterator() {
+  m_sk_lookahead.reset();
+
   delete m_scan_it;
   m_scan_it = nullptr;
 
+  if (m_scan_it_readahead) {
+    m_table_handler->m_readahead_scans.fetch_sub(1, std::memory_order_relaxed);
+    Rdb_transaction *const tx = get_tx_from_thd(ha_thd());
+    if (tx != nullptr && tx->m_readahead_scans > 0) {
+      tx->m_readahead_scans--;
+    }
+    m_scan_it_readahead = false;
+  }
+
   if (m_scan_it_snapshot) {
     rdb->ReleaseSnapshot(m_scan_it_snapshot);
     m_scan_it_snapshot = nullptr;
   }
 }
 
+/*
+  Move m_scan_it to the next record. A scan that has moved forward
+  @@rocksdb_scan_readahead_threshold times on the same iterator is likely to
+  read a lot more, so it is switched to an iterator that reads ahead.
+*/
+void ha_rocksdb::scan_it_next(const Rdb_key_def &kd) {
+  if (++m_scan_it_next_count == THDVAR(ha_thd(), scan_readahead_threshold) &&
+      !m_scan_it_readahead) {
+    enable_scan_readahead(kd);
+  }
+  m_scan_it->Next();
+}
+
+/*
+  Re-create m_scan_it with ReadOptions::readahead_size, so that RocksDB reads
+  @@rocksdb_scan_readahead_size bytes of each SST file at once rather than a
+  block at a time, and position it back on the current record.
+*/
+void ha_rocksdb::enable_scan_readahead(const Rdb_key_def &kd) {
+  /*
+    Iterators that don't use the transaction snapshot can't be re-created at
+    the same point in time. Locking reads may see their own writes through a
+    new iterator.
+  */
+  if (m_scan_it_snapshot != nullptr || m_lock_rows != RDB_LOCK_NONE ||
+      !is_valid_iterator(m_scan_it)) {
+    return;
+  }
+
+  THD *const thd = ha_thd();
+  Rdb_transaction *const tx = get_or_create_tx(thd);
+
+  /*
+    Both the session and the table are limited, so that neither a session
+    scanning many tables or partitions nor many sessions scanning one table
+    can tie up an unbounded amount of readahead buffers.
+  */
+  if (tx->m_readahead_scans >= THDVAR(thd, scan_readahead_session_limit)) {
+    m_io_perf.inc(PC_SCAN_READAHEAD_THROTTLED_COUNT);
+    return;
+  }
+
+  const uint limit = rocksdb_scan_readahead_table_limit;
+  if (m_table_handler->m_readahead_scans.fetch_add(
+          1, std::memory_order_relaxed) >= limit) {
+    m_table_handler->m_readahead_scans.fetch_sub(1, std::memory_order_relaxed);
+    m_io_perf.inc(PC_SCAN_READAHEAD_THROTTLED_COUNT);
+    return;
+  }
+
+  const std::string key = m_scan_it->key().ToString();
+
+  delete m_scan_it;
+  m_scan_it = tx->get_iterator(
+      kd.get_cf(), m_scan_it_skips_bloom, !THDVAR(thd, skip_fill_cache),
+      m_scan_it_lower_bound_slice, m_scan_it_upper_bound_slice,
+      false /* read_current */, true /* create_snapshot */,
+      THDVAR(thd, scan_readahead_size));
+  m_scan_it->Seek(key);
+  DBUG_ASSERT(is_valid_iterator(m_scan_it) && m_scan_it->key() == key);
+
+  m_scan_it_readahead = true;
+  tx->m_readahead_scans++;
+  m_io_perf.inc(PC_SCAN_READAHEAD_COUNT);
+}
+
 void ha_rocksdb::setup_iterator_for_rnd_scan() {
   uint key_size;
 
@@ -11174,7 +12280,7 @@ int ha_rocksdb::rnd_next_with_direction(uchar *const buf, bool move_forward) {
       m_skip_scan_it_next_call = false;
     } else {
       if (move_forward) {
-        m_scan_it->Next(); /* this call cannot fail */
+        scan_it_next(*m_pk_descr); /* this call cannot fail */
       } else {
         m_scan_it->Prev(); /* this call cannot fail */
       }
@@ -12041,6 +13147,20 @@ static bool is_myrocks_index_empty(rocksdb::ColumnFamilyHandle *cfh,
   return index_removed;
 }
 
+/*
+  Approximate size of the SST files data in the given range
+*/
+static uint64_t get_index_file_size(rocksdb::ColumnFamilyHandle *const cfh,
+                                    const rocksdb::Range &range) {
+  uint64_t size = 0;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+  rdb->GetApproximateSizes(cfh, &range, 1, &size,
+                           rocksdb::DB::SizeApproximationFlags::INCLUDE_FILES);
+#pragma GCC diagnostic pop
+  return size;
+}
+
 /*
   Drop index thread's main logic
 */
@@ -12075,6 +13195,20 @@ void Rdb_drop_index_thread::run() {
 
     std::unordered_set<GL_INDEX_ID> indices;
     dict_manager.get_ongoing_drop_indexes(&indices);
+    // Let the compaction filters created from now on, including the ones of
+    // CompactRange() below, see the indexes being dropped.
+    rdb_compact_filter_metadata.set_dropped_indexes(indices);
+    {
+      // Forget the progress of drops finished by other means
+      const std::lock_guard<std::mutex> lock(m_progress_mutex);
+      for (auto it = m_progress.begin(); it != m_progress.end();) {
+        if (indices.find(it->first) == indices.end()) {
+          it = m_progress.erase(it);
+        } else {
+          ++it;
+        }
+      }
+    }
     if (!indices.empty()) {
       std::unordered_set<GL_INDEX_ID> finished;
       rocksdb::ReadOptions read_opts;
@@ -12107,19 +13241,45 @@ void Rdb_drop_index_thread::run() {
         rocksdb::Range range = get_range(d.index_id, buf, is_reverse_cf ? 1 : 0,
                                          is_reverse_cf ? 0 : 1);
 
-        rocksdb::Status status = DeleteFilesInRange(rdb->GetBaseDB(), cfh.get(),
-                                                    &range.start, &range.limit);
-        if (!status.ok()) {
-          if (status.IsIncomplete()) {
-            continue;
-          } else if (status.IsShutdownInProgress()) {
-            break;
+        Rdb_drop_index_progress progress;
+        bool is_new = true;
+        {
+          const std::lock_guard<std::mutex> lock(m_progress_mutex);
+          const auto it = m_progress.find(d);
+          if (it != m_progress.end()) {
+            progress = it->second;
+            is_new = false;
           }
-          rdb_handle_io_error(status, RDB_IO_ERROR_BG_THREAD);
+        }
+        if (is_new) {
+          progress.m_initial_size = get_index_file_size(cfh.get(), range);
+        }
+
+        rocksdb::Status status;
+        if (rocksdb_drop_index_use_delete_range && !progress.m_delete_range) {
+          /*
+            A single range tombstone hides the whole index from readers right
+            away. Regular compactions then drop the covered data, whole files
+            at a time, so no CompactRange() is forced below.
+          */
+          status = rdb->GetBaseDB()->DeleteRange(rocksdb::WriteOptions(),
+                                                 cfh.get(), range.start,
+                                                 range.limit);
+          if (!status.ok()) {
+            if (status.IsShutdownInProgress()) {
+              break;
+            }
+            rdb_handle_io_error(status, RDB_IO_ERROR_BG_THREAD);
+          }
+          progress.m_delete_range = true;
+          global_stats.drop_index_range_deletes.inc();
+
+          const std::lock_guard<std::mutex> lock(m_progress_mutex);
+          m_progress[d] = progress;
         }
 
-        status = rdb->CompactRange(getCompactRangeOptions(), cfh.get(),
-                                   &range.start, &range.limit);
+        status = DeleteFilesInRange(rdb->GetBaseDB(), cfh.get(), &range.start,
+                                    &range.limit);
         if (!status.ok()) {
           if (status.IsIncomplete()) {
             continue;
@@ -12128,8 +13288,49 @@ void Rdb_drop_index_thread::run() {
           }
           rdb_handle_io_error(status, RDB_IO_ERROR_BG_THREAD);
         }
-        if (is_myrocks_index_empty(cfh.get(), is_reverse_cf, read_opts,
-                                   d.index_id)) {
+
+        if (!progress.m_delete_range) {
+          status = rdb->CompactRange(getCompactRangeOptions(), cfh.get(),
+                                     &range.start, &range.limit);
+          if (!status.ok()) {
+            if (status.IsIncomplete()) {
+              continue;
+            } else if (status.IsShutdownInProgress()) {
+              break;
+            }
+            rdb_handle_io_error(status, RDB_IO_ERROR_BG_THREAD);
+          }
+        }
+
+        const uint64_t prev_size = progress.m_passes == 0
+                                       ? progress.m_initial_size
+                                       : progress.m_current_size;
+        const uint64_t current_size = get_index_file_size(cfh.get(), range);
+        if (prev_size > current_size) {
+          global_stats.drop_index_bytes_reclaimed.add(prev_size - current_size);
+        }
+        progress.m_current_size = current_size;
+        progress.m_passes++;
+
+        /*
+          A DeleteRange tombstone empties the index on the first pass, but
+          its files are only reclaimed as compactions reach them. Keep the
+          drop going until the range has no files left so that the space
+          reclaimed later is measured too.
+        */
+        const bool is_done =
+            is_myrocks_index_empty(cfh.get(), is_reverse_cf, read_opts,
+                                   d.index_id) &&
+            (!progress.m_delete_range || current_size == 0);
+        {
+          const std::lock_guard<std::mutex> lock(m_progress_mutex);
+          if (is_done) {
+            m_progress.erase(d);
+          } else {
+            m_progress[d] = progress;
+          }
+        }
+        if (is_done) {
           finished.insert(d);
         }
       }
@@ -12850,12 +14051,21 @@ static void adjust_cardinality(
   }
 }
 
+/*
+  Sets *sketched to true if the cardinality of every index could be taken
+  from distinct prefix sketches, that is if every SST file with entries of
+  these indexes has been written with rocksdb_table_stats_use_sketches on.
+*/
 static int read_stats_from_ssts(
     const std::unordered_map<GL_INDEX_ID, std::shared_ptr<const Rdb_key_def>>
         &to_recalc,
-    std::unordered_map<GL_INDEX_ID, Rdb_index_stats> *stats) {
+    std::unordered_map<GL_INDEX_ID, Rdb_index_stats> *stats,
+    bool *const sketched) {
   DBUG_ENTER_FUNC();
 
+  DBUG_ASSERT(sketched != nullptr);
+  *sketched = false;
+
   init_stats(to_recalc, stats);
 
   // find per column family key ranges which need to be queried
@@ -12883,10 +14093,19 @@ static int read_stats_from_ssts(
     }
   }
 
+  const bool use_sketches = rocksdb_table_stats_use_sketches;
+  std::unordered_map<GL_INDEX_ID, Rdb_index_sketches> sketches;
+  std::unordered_set<GL_INDEX_ID> unsketched;
+
   int num_sst = 0;
   for (const auto &it : props) {
     std::vector<Rdb_index_stats> sst_stats;
     Rdb_tbl_prop_coll::read_stats_from_tbl_props(it.second, &sst_stats);
+    std::vector<Rdb_index_sketches> sst_sketches;
+    if (use_sketches) {
+      Rdb_tbl_prop_coll::read_sketches_from_tbl_props(it.second,
+                                                      &sst_sketches);
+    }
     /*
       sst_stats is a list of index statistics for indexes that have entries
       in the current SST file.
@@ -12912,10 +14131,34 @@ static int read_stats_from_ssts(
 
       (*stats)[it1.m_gl_index_id].merge(
           it1, true, it_index->second->max_storage_fmt_length());
+
+      if (use_sketches) {
+        const auto it2 = std::find_if(
+            sst_sketches.begin(), sst_sketches.end(),
+            [&it1](const Rdb_index_sketches &s) {
+              return s.m_gl_index_id == it1.m_gl_index_id;
+            });
+        if (it2 != sst_sketches.end()) {
+          sketches[it1.m_gl_index_id].merge(*it2);
+        } else {
+          unsketched.insert(it1.m_gl_index_id);
+        }
+      }
     }
     num_sst++;
   }
 
+  if (use_sketches) {
+    // Summing per-file distinct counters counts a key once for every file
+    // holding a version of it, merged sketches count it once.
+    for (const auto &it : sketches) {
+      if (unsketched.find(it.first) == unsketched.end()) {
+        (*stats)[it.first].set_cardinality(it.second);
+      }
+    }
+    *sketched = unsketched.empty();
+  }
+
   DBUG_RETURN(HA_EXIT_SUCCESS);
 }
 
@@ -12927,11 +14170,19 @@ static int calculate_stats(
   DBUG_ENTER_FUNC();
 
   std::unordered_map<GL_INDEX_ID, Rdb_index_stats> stats;
-  int ret = read_stats_from_ssts(to_recalc, &stats);
+  bool sketched = false;
+  int ret = read_stats_from_ssts(to_recalc, &stats, &sketched);
   if (ret != HA_EXIT_SUCCESS) {
     DBUG_RETURN(ret);
   }
 
+  if (scan_type == SCAN_TYPE_FULL_TABLE && sketched) {
+    // The SST files already provide exact enough cardinality, only
+    // the memtables have to be scanned.
+    scan_type = SCAN_TYPE_MEMTABLE_ONLY;
+    global_stats.table_index_stats_from_sketches.inc();
+  }
+
   if (scan_type != SCAN_TYPE_NONE) {
     std::unordered_map<GL_INDEX_ID, Rdb_index_stats> card_stats;
     uint64_t max_num_rows_scanned = rocksdb_table_stats_max_num_rows_scanned;
@@ -13761,6 +15012,18 @@ int ha_rocksdb::inplace_populate_sk(
       THDVAR(ha_thd(), merge_combine_read_size);
   const ulonglong rdb_merge_tmp_file_removal_delay =
       THDVAR(ha_thd(), merge_tmp_file_removal_delay_ms);
+  const uint rdb_merge_threads = THDVAR(ha_thd(), merge_threads);
+
+  /*
+    Non-unique secondary keys are sorted and merged by a pool of threads.
+    The primary key scan stays in this thread as decoding rows goes through
+    the TABLE and its fields, and unique keys keep the serial merge since the
+    duplicate check needs this handler's buffers.
+  */
+  std::unique_ptr<Rdb_index_merge_pool> merge_pool;
+  if (rdb_merge_threads > 1) {
+    merge_pool.reset(new Rdb_index_merge_pool(rdb_merge_threads));
+  }
 
   for (const auto &index : indexes) {
     bool is_unique_index =
@@ -13769,7 +15032,8 @@ int ha_rocksdb::inplace_populate_sk(
     Rdb_index_merge rdb_merge(tx->get_rocksdb_tmpdir(), rdb_merge_buf_size,
                               rdb_merge_combine_read_size,
                               rdb_merge_tmp_file_removal_delay,
-                              index->get_cf());
+                              index->get_cf(),
+                              is_unique_index ? nullptr : merge_pool.get());
 
     if ((res = rdb_merge.init())) {
       DBUG_RETURN(res);
@@ -13831,42 +15095,70 @@ int ha_rocksdb::inplace_populate_sk(
       Perform an n-way merge of n sorted buffers on disk, then writes all
       results to RocksDB via SSTFileWriter API.
     */
-    rocksdb::Slice merge_key;
-    rocksdb::Slice merge_val;
+    if (rdb_merge.is_parallel()) {
+      /*
+        Every range of the key space is merged into its own SST files, which
+        are ingested along with the rest of the bulk load below.
+      */
+      std::vector<std::shared_ptr<Rdb_sst_info>> sst_infos;
+      for (uint i = 0; i < merge_pool->size(); i++) {
+        sst_infos.push_back(std::make_shared<Rdb_sst_info>(
+            rdb, m_table_handler->m_table_name, index->get_name(),
+            index->get_cf(), *rocksdb_db_options,
+            THDVAR(ha_thd(), trace_sst_api)));
+        if ((res = tx->start_bulk_load(this, sst_infos.back()))) {
+          DBUG_RETURN(res);
+        }
+      }
 
-    struct unique_sk_buf_info sk_info;
-    sk_info.dup_sk_buf = m_dup_sk_packed_tuple;
-    sk_info.dup_sk_buf_old = m_dup_sk_packed_tuple_old;
+      const THD *const thd = ha_thd();
+      res = rdb_merge.merge_parallel(
+          [thd, &sst_infos](uint range, const rocksdb::Slice &key,
+                            const rocksdb::Slice &val) {
+            if (thd->killed) {
+              return static_cast<int>(HA_ERR_QUERY_INTERRUPTED);
+            }
+            return sst_infos[range]->put(key, val);
+          });
+    } else {
+      rocksdb::Slice merge_key;
+      rocksdb::Slice merge_val;
 
-    while ((res = rdb_merge.next(&merge_key, &merge_val)) == 0) {
-      /* Perform uniqueness check if needed */
-      if (is_unique_index) {
-        if (check_duplicate_sk(new_table_arg, *index, &merge_key, &sk_info)) {
-          /*
-            Duplicate entry found when trying to create unique secondary key.
-            We need to unpack the record into new_table_arg->record[0] as it
-            is used inside print_keydup_error so that the error message shows
-            the duplicate record.
-          */
-          if (index->unpack_record(
-                  new_table_arg, new_table_arg->record[0], &merge_key,
-                  &merge_val, m_converter->get_verify_row_debug_checksums())) {
-            /* Should never reach here */
-            DBUG_ASSERT(0);
-          }
+      struct unique_sk_buf_info sk_info;
+      sk_info.dup_sk_buf = m_dup_sk_packed_tuple;
+      sk_info.dup_sk_buf_old = m_dup_sk_packed_tuple_old;
+
+      while ((res = rdb_merge.next(&merge_key, &merge_val)) == 0) {
+        /* Perform uniqueness check if needed */
+        if (is_unique_index) {
+          if (check_duplicate_sk(new_table_arg, *index, &merge_key, &sk_info)) {
+            /*
+              Duplicate entry found when trying to create unique secondary
+              key. We need to unpack the record into new_table_arg->record[0]
+              as it is used inside print_keydup_error so that the error
+              message shows the duplicate record.
+            */
+            if (index->unpack_record(
+                    new_table_arg, new_table_arg->record[0], &merge_key,
+                    &merge_val,
+                    m_converter->get_verify_row_debug_checksums())) {
+              /* Should never reach here */
+              DBUG_ASSERT(0);
+            }
 
-          print_keydup_error(new_table_arg,
-                             &new_table_arg->key_info[index->get_keyno()],
-                             MYF(0), ha_thd());
-          DBUG_RETURN(ER_DUP_ENTRY);
+            print_keydup_error(new_table_arg,
+                               &new_table_arg->key_info[index->get_keyno()],
+                               MYF(0), ha_thd());
+            DBUG_RETURN(ER_DUP_ENTRY);
+          }
         }
-      }
 
-      /*
-        Insert key and slice to SST via SSTFileWriter API.
-      */
-      if ((res = bulk_load_key(tx, *index, merge_key, merge_val, false))) {
-        break;
+        /*
+          Insert key and slice to SST via SSTFileWriter API.
+        */
+        if ((res = bulk_load_key(tx, *index, merge_key, merge_val, false))) {
+          break;
+        }
       }
     }
 
@@ -14339,9 +15631,24 @@ static void myrocks_update_status() {
       global_stats.table_index_stats_result[TABLE_INDEX_STATS_FAILURE];
   export_stats.table_index_stats_req_queue_length =
       rdb_is_thread.get_request_queue_size();
+  export_stats.table_index_stats_from_sketches =
+      global_stats.table_index_stats_from_sketches;
 
   export_stats.covered_secondary_key_lookups =
       global_stats.covered_secondary_key_lookups;
+
+  export_stats.sk_lookahead_batches = global_stats.sk_lookahead_batches;
+  export_stats.sk_lookahead_keys = global_stats.sk_lookahead_keys;
+
+  export_stats.mrr_batches = global_stats.mrr_batches;
+  export_stats.mrr_batch_keys = global_stats.mrr_batch_keys;
+  export_stats.mrr_prefetch_waits = global_stats.mrr_prefetch_waits;
+  export_stats.mrr_prefetch_wait_micros =
+      global_stats.mrr_prefetch_wait_micros;
+
+  export_stats.drop_index_range_deletes = global_stats.drop_index_range_deletes;
+  export_stats.drop_index_bytes_reclaimed =
+      global_stats.drop_index_bytes_reclaimed;
 }
 
 static void myrocks_update_memory_status() {
@@ -14394,9 +15701,29 @@ static SHOW_VAR myrocks_status_variables[] = {
     DEF_STATUS_VAR_FUNC("table_index_stats_req_queue_length",
                         &export_stats.table_index_stats_req_queue_length,
                         SHOW_LONGLONG),
+    DEF_STATUS_VAR_FUNC("table_index_stats_from_sketches",
+                        &export_stats.table_index_stats_from_sketches,
+                        SHOW_LONGLONG),
     DEF_STATUS_VAR_FUNC("covered_secondary_key_lookups",
                         &export_stats.covered_secondary_key_lookups,
                         SHOW_LONGLONG),
+    DEF_STATUS_VAR_FUNC("sk_lookahead_batches",
+                        &export_stats.sk_lookahead_batches, SHOW_LONGLONG),
+    DEF_STATUS_VAR_FUNC("sk_lookahead_keys", &export_stats.sk_lookahead_keys,
+                        SHOW_LONGLONG),
+    DEF_STATUS_VAR_FUNC("mrr_batches", &export_stats.mrr_batches,
+                        SHOW_LONGLONG),
+    DEF_STATUS_VAR_FUNC("mrr_batch_keys", &export_stats.mrr_batch_keys,
+                        SHOW_LONGLONG),
+    DEF_STATUS_VAR_FUNC("mrr_prefetch_waits", &export_stats.mrr_prefetch_waits,
+                        SHOW_LONGLONG),
+    DEF_STATUS_VAR_FUNC("mrr_prefetch_wait_micros",
+                        &export_stats.mrr_prefetch_wait_micros, SHOW_LONGLONG),
+    DEF_STATUS_VAR_FUNC("drop_index_range_deletes",
+                        &export_stats.drop_index_range_deletes, SHOW_LONGLONG),
+    DEF_STATUS_VAR_FUNC("drop_index_bytes_reclaimed",
+                        &export_stats.drop_index_bytes_reclaimed,
+                        SHOW_LONGLONG),
 
     {NullS, NullS, SHOW_LONG}};
 
@@ -14618,6 +15945,10 @@ static SHOW_VAR rocksdb_status_vars[] = {
                        &rocksdb_select_bypass_rejected, SHOW_LONGLONG),
     DEF_STATUS_VAR_PTR("select_bypass_failed", &rocksdb_select_bypass_failed,
                        SHOW_LONGLONG),
+    DEF_STATUS_VAR_PTR("bypass_plan_cache_hits",
+                       &rocksdb_bypass_plan_cache_hits, SHOW_LONGLONG),
+    DEF_STATUS_VAR_PTR("bypass_plan_cache_misses",
+                       &rocksdb_bypass_plan_cache_misses, SHOW_LONGLONG),
     // the variables generated by SHOW_FUNC are sorted only by prefix (first
     // arg in the tuple below), so make sure it is unique to make sorting
     // deterministic as quick sort is not stable
@@ -15174,6 +16505,56 @@ bool Rdb_manual_compaction_thread::set_client_done(const int mc_id) {
   return rc;
 }
 
+void Rdb_mrr_prefetch_thread::run() {
+  RDB_MUTEX_LOCK_CHECK(m_signal_mutex);
+  for (;;) {
+    while (m_requests.empty() && !m_killed) {
+      mysql_cond_wait(&m_signal_cond, &m_signal_mutex);
+    }
+
+    // Requests queued before the stop signal are still executed, their
+    // owners are waiting for them.
+    if (m_requests.empty()) {
+      break;
+    }
+
+    Request *const req = m_requests.front();
+    m_requests.pop_front();
+    RDB_MUTEX_UNLOCK_CHECK(m_signal_mutex);
+
+    req->execute();
+
+    RDB_MUTEX_LOCK_CHECK(m_signal_mutex);
+  }
+  RDB_MUTEX_UNLOCK_CHECK(m_signal_mutex);
+}
+
+bool Rdb_mrr_prefetch_thread::add_request(Request *const req) {
+  RDB_MUTEX_LOCK_CHECK(m_signal_mutex);
+  if (m_killed != THD::NOT_KILLED) {
+    RDB_MUTEX_UNLOCK_CHECK(m_signal_mutex);
+    return false;
+  }
+  m_requests.push_back(req);
+  mysql_cond_signal(&m_signal_cond);
+  RDB_MUTEX_UNLOCK_CHECK(m_signal_mutex);
+  return true;
+}
+
+/*
+  Hand a MultiGet request to one of the MRR prefetch threads. If there are no
+  running threads, the request is executed by the calling thread.
+*/
+static void rdb_mrr_prefetch_submit(Rdb_mrr_prefetch_thread::Request *req) {
+  if (!rdb_mrr_prefetch_threads.empty()) {
+    const uint n = rdb_mrr_prefetch_next_thread.fetch_add(
+                       1, std::memory_order_relaxed) %
+                   rdb_mrr_prefetch_threads.size();
+    if (rdb_mrr_prefetch_threads[n]->add_request(req)) return;
+  }
+  req->execute();
+}
+
 /**
  * Locking read + Not Found + Read Committed occurs if we accessed
  * a row by Seek, tried to lock it, failed, released and reacquired the
@@ -15440,6 +16821,10 @@ Rdb_dict_manager *rdb_get_dict_manager(void) { return &dict_manager; }
 
 Rdb_ddl_manager *rdb_get_ddl_manager(void) { return &ddl_manager; }
 
+Rdb_drop_index_thread *rdb_get_drop_index_thread(void) {
+  return &rdb_drop_idx_thread;
+}
+
 Rdb_binlog_manager *rdb_get_binlog_manager(void) { return &binlog_manager; }
 
 void rocksdb_set_compaction_options(
@@ -16182,6 +17567,40 @@ static void rocksdb_select_bypass_rejected_query_history_size_update(
   }
 }
 
+static void rocksdb_select_bypass_query_shapes_size_update(
+    THD *const /* unused */, struct st_mysql_sys_var *const /* unused */,
+    void *const var_ptr, const void *const save) {
+  DBUG_ASSERT(rdb != nullptr);
+
+  uint32_t val = *static_cast<uint32_t *>(var_ptr) =
+      *static_cast<const uint32_t *>(save);
+
+  const std::lock_guard<std::mutex> lock(myrocks::bypass_query_shape_lock);
+  while (myrocks::bypass_query_shapes.size() > val) {
+    myrocks::bypass_query_shapes.erase(myrocks::bypass_query_shapes.begin());
+  }
+}
+
+static void rocksdb_perf_context_trace_size_update(
+    THD *const /* unused */, struct st_mysql_sys_var *const /* unused */,
+    void *const var_ptr, const void *const save) {
+  const uint32_t val = *static_cast<uint32_t *>(var_ptr) =
+      *static_cast<const uint32_t *>(save);
+
+  rdb_query_perf_tracker.resize(val);
+}
+
+static void rocksdb_select_bypass_plan_cache_size_update(
+    THD *const /* unused */, struct st_mysql_sys_var *const /* unused */,
+    void *const var_ptr, const void *const save) {
+  DBUG_ASSERT(rdb != nullptr);
+
+  *static_cast<uint32_t *>(var_ptr) = *static_cast<const uint32_t *>(save);
+
+  // Start over so that no table keeps more plans than the new limit
+  ddl_manager.clear_bypass_plans();
+}
+
 select_bypass_policy_type get_select_bypass_policy() {
   return static_cast<select_bypass_policy_type>(rocksdb_select_bypass_policy);
 }
@@ -16206,6 +17625,14 @@ uint32_t get_select_bypass_rejected_query_history_size() {
   return rocksdb_select_bypass_rejected_query_history_size;
 }
 
+uint32_t get_select_bypass_query_shapes_size() {
+  return rocksdb_select_bypass_query_shapes_size;
+}
+
+uint32_t get_select_bypass_plan_cache_size() {
+  return rocksdb_select_bypass_plan_cache_size;
+}
+
 uint32_t get_select_bypass_debug_row_delay() {
   return rocksdb_select_bypass_debug_row_delay;
 }
@@ -16253,6 +17680,16 @@ void rdb_tx_multi_get(Rdb_transaction *tx,
  * Multi-Range-Read implementation based on RocksDB's MultiGet() call
  ***************************************************************************/
 
+/*
+  Check if the MultiGet calls of an MRR scan may run on a prefetch thread.
+  The prefetch thread uses the transaction of the session while the session
+  keeps reading through it, which is only safe if the statement doesn't write.
+*/
+static bool rdb_mrr_prefetch_enabled(THD *const thd) {
+  return !rdb_mrr_prefetch_threads.empty() && THDVAR(thd, mrr_prefetch) &&
+         my_core::thd_sql_command(thd) == SQLCOM_SELECT;
+}
+
 /*
   Check if MultiGet-MRR can be used to scan given list of ranges.
 
@@ -16294,6 +17731,9 @@ ha_rows ha_rocksdb::multi_range_read_info_const(uint keyno, RANGE_SEQ_IF *seq,
   uint calculated_buf = mrr_get_length_per_rec() * res * 10 + 1;
   // How many buffer required to store maximum number of keys per MRR
   ssize_t elements_limit = THDVAR(thd, mrr_batch_size);
+  // Overlapped MRR keeps two batches in the buffer and may grow them
+  if (rdb_mrr_prefetch_enabled(thd))
+    elements_limit *= 2 * RDB_MRR_PREFETCH_MAX_GROWTH;
   uint mrr_batch_size_buff =
       mrr_get_length_per_rec() * elements_limit * 1.1 + 1;
   // The final bufsz value should be minimum among these three values:
@@ -16480,6 +17920,11 @@ int ha_rocksdb::multi_range_read_init(RANGE_SEQ_IF *seq, void *seq_init_param,
 
   int res;
 
+  // The previous scan may not have been ended with index_end() (BKA starts a
+  // new scan for every refill of the join buffer). A prefetch thread may
+  // still be reading into its buffer.
+  if (mrr_rowid_reader) mrr_free();
+
   if (!current_thd->optimizer_switch_flag(OPTIMIZER_SWITCH_MRR) ||
       (mode & HA_MRR_USE_DEFAULT_IMPL) ||
       (buf->buffer_end - buf->buffer < mrr_get_length_per_rec()) ||
@@ -16493,13 +17938,32 @@ int ha_rocksdb::multi_range_read_init(RANGE_SEQ_IF *seq, void *seq_init_param,
   // Ok, using a non-default MRR implementation, MultiGet-MRR
 
   mrr_uses_default_impl = false;
-  mrr_n_elements = 0;  // nothing to cleanup, yet.
+  mrr_read_index = 0;
   mrr_enabled_keyread = false;
   mrr_rowid_reader = nullptr;
 
   mrr_funcs = *seq;
   mrr_buf = *buf;
 
+  // With overlapped MRR, each of the two batches gets half of the buffer.
+  // Leave some room for alignment in each half.
+  const size_t buf_size = mrr_buf.buffer_end - mrr_buf.buffer;
+  mrr_prefetch = rdb_mrr_prefetch_enabled(table->in_use) &&
+                 buf_size >= 4 * mrr_get_length_per_rec();
+  mrr_batch_limit = THDVAR(table->in_use, mrr_batch_size);
+
+  mrr_cur = &mrr_batches[0];
+  mrr_next = &mrr_batches[1];
+  mrr_cur->buf_start = (char *)mrr_buf.buffer;
+  mrr_next->buf_end = (char *)mrr_buf.buffer_end;
+  if (mrr_prefetch) {
+    char *middle = mrr_cur->buf_start + buf_size / 2;
+    middle -= ((size_t)middle) % alignof(rocksdb::PinnableSlice);
+    mrr_cur->buf_end = mrr_next->buf_start = middle;
+  } else {
+    mrr_cur->buf_end = mrr_next->buf_start = (char *)mrr_buf.buffer_end;
+  }
+
   bool is_mrr_assoc = !MY_TEST(mode & HA_MRR_NO_ASSOCIATION);
   if (is_mrr_assoc)
     status_var_increment(
@@ -16583,12 +18047,13 @@ template <typename T> void align_ptr(char **p) {
   Note that the buffer may be much larger than necessary. For range scans,
   @@rnd_buffer_size=256K is passed, even if there will be only a few lookup
   values.
+
+  With overlapped MRR, the buffer is split in two and each half holds the
+  arrays of one batch (see mrr_batch).
 */
 
-int ha_rocksdb::mrr_fill_buffer() {
-
-  mrr_free_rows();
-  mrr_read_index = 0;
+int ha_rocksdb::mrr_collect_rowids(mrr_batch *const batch) {
+  DBUG_ASSERT(batch->n_elements == 0 && !batch->request);
 
   // This should agree with the code in mrr_get_length_per_rec():
   ssize_t element_size = sizeof(rocksdb::Slice) + sizeof(rocksdb::Status) +
@@ -16597,11 +18062,9 @@ int ha_rocksdb::mrr_fill_buffer() {
                          m_pk_descr->max_storage_fmt_length();
 
   // The buffer has space for this many elements:
-  ssize_t n_elements = (mrr_buf.buffer_end - mrr_buf.buffer) / element_size;
+  ssize_t n_elements = (batch->buf_end - batch->buf_start) / element_size;
 
-  THD *thd = table->in_use;
-  ssize_t elements_limit = THDVAR(thd, mrr_batch_size);
-  n_elements = std::min(n_elements, elements_limit);
+  n_elements = std::min(n_elements, mrr_batch_limit);
 
   if (n_elements < 1) {
     // We shouldn't get here as multi_range_read_init() has logic to fall back
@@ -16610,25 +18073,25 @@ int ha_rocksdb::mrr_fill_buffer() {
     return HA_ERR_INTERNAL_ERROR;
   }
 
-  char *buf = (char *)mrr_buf.buffer;
+  char *buf = batch->buf_start;
 
   align_ptr<rocksdb::Slice>(&buf);
-  mrr_keys = (rocksdb::Slice*)buf;
+  batch->keys = (rocksdb::Slice*)buf;
   buf += sizeof(rocksdb::Slice) * n_elements;
 
   align_ptr<rocksdb::Status>(&buf);
-  mrr_statuses = (rocksdb::Status*)buf;
+  batch->statuses = (rocksdb::Status*)buf;
   buf += sizeof(rocksdb::Status) * n_elements;
 
   align_ptr<rocksdb::PinnableSlice>(&buf);
-  mrr_values = (rocksdb::PinnableSlice*)buf;
+  batch->values = (rocksdb::PinnableSlice*)buf;
   buf += sizeof(rocksdb::PinnableSlice) * n_elements;
 
   align_ptr<char*>(&buf);
-  mrr_range_ptrs = (char **)buf;
+  batch->range_ptrs = (char **)buf;
   buf += sizeof(char *) * n_elements;
 
-  if (buf + m_pk_descr->max_storage_fmt_length() >= (char*)mrr_buf.buffer_end) {
+  if (buf + m_pk_descr->max_storage_fmt_length() >= batch->buf_end) {
     // a VERY unlikely scenario:  we were given a really small buffer,
     // (probably for just one rowid), and also we had to use some bytes for
     // alignment. As a result, there's no buffer space left to hold even one
@@ -16639,7 +18102,7 @@ int ha_rocksdb::mrr_fill_buffer() {
 
   ssize_t elem = 0;
 
-  mrr_n_elements = elem;
+  batch->n_elements = elem;
   int key_size;
   char *range_ptr;
   int err;
@@ -16648,17 +18111,17 @@ int ha_rocksdb::mrr_fill_buffer() {
     DEBUG_SYNC(table->in_use, "rocksdb.mrr_fill_buffer.loop");
     if (table->in_use->killed) return HA_ERR_QUERY_INTERRUPTED;
 
-    new (&mrr_keys[elem]) rocksdb::Slice(buf, key_size);
-    new (&mrr_statuses[elem]) rocksdb::Status;
-    new (&mrr_values[elem]) rocksdb::PinnableSlice;
-    mrr_range_ptrs[elem] = range_ptr;
+    new (&batch->keys[elem]) rocksdb::Slice(buf, key_size);
+    new (&batch->statuses[elem]) rocksdb::Status;
+    new (&batch->values[elem]) rocksdb::PinnableSlice;
+    batch->range_ptrs[elem] = range_ptr;
     buf += key_size;
 
     elem++;
-    mrr_n_elements= elem;
+    batch->n_elements= elem;
 
     if ((elem == n_elements) || (buf + m_pk_descr->max_storage_fmt_length() >=
-                                 (char*)mrr_buf.buffer_end)) {
+                                 batch->buf_end)) {
       // No more buffer space
       break;
     }
@@ -16666,19 +18129,107 @@ int ha_rocksdb::mrr_fill_buffer() {
 
   if (err && err != HA_ERR_END_OF_FILE) return err;
 
-  if (mrr_n_elements == 0) return HA_ERR_END_OF_FILE;  // nothing to scan
-
-  Rdb_transaction *const tx = get_or_create_tx(table->in_use);
+  if (batch->n_elements == 0) return HA_ERR_END_OF_FILE;  // nothing to scan
 
   if (active_index == table->s->primary_key)
-    stats.rows_requested += mrr_n_elements;
+    stats.rows_requested += batch->n_elements;
+
+  global_stats.mrr_batches.inc();
+  global_stats.mrr_batch_keys.add(batch->n_elements);
+
+  return 0;
+}
+
+/*
+  Make the next batch of rows available in mrr_cur.
+
+  Without overlapped MRR, the rowids are collected and looked up with a
+  blocking MultiGet call. With overlapped MRR, the batch has normally been
+  prefetched while the previous one was consumed, and the batch after it is
+  prefetched now.
+*/
+
+int ha_rocksdb::mrr_fill_buffer() {
+  mrr_free_rows(mrr_cur, mrr_read_index);
+  mrr_read_index = 0;
+
+  int res;
+  if (mrr_next->n_elements) {
+    mrr_wait_batch(mrr_next);
+    std::swap(mrr_cur, mrr_next);
+  } else {
+    if ((res = mrr_collect_rowids(mrr_cur))) return res;
+
+    Rdb_transaction *const tx = get_or_create_tx(table->in_use);
+    tx->multi_get(m_pk_descr->get_cf(), mrr_cur->n_elements, mrr_cur->keys,
+                  mrr_cur->values, mrr_cur->statuses, mrr_sorted_mode);
+  }
+
+  if (mrr_prefetch && !mrr_rowid_reader->eof()) {
+    res = mrr_prefetch_next_batch();
+    if (res && res != HA_ERR_END_OF_FILE) return res;
+  }
 
-  tx->multi_get(m_pk_descr->get_cf(), mrr_n_elements, mrr_keys, mrr_values,
-                mrr_statuses, mrr_sorted_mode);
+  return 0;
+}
+
+/*
+  Collect the rowids of the batch that follows mrr_cur and hand its MultiGet
+  call to a prefetch thread.
+
+  The MultiGet call uses the transaction of this thread, so the snapshot is
+  taken here rather than on the prefetch thread. Note that RocksDB perf
+  context counters of the call are accounted to the prefetch thread.
+*/
+
+int ha_rocksdb::mrr_prefetch_next_batch() {
+  mrr_batch *const batch = mrr_next;
+
+  const int res = mrr_collect_rowids(batch);
+  if (res) {
+    // A partially collected batch has no rows, don't return it
+    mrr_free_rows(batch, batch->n_elements);
+    return res;
+  }
+
+  Rdb_transaction *const tx = get_or_create_tx(table->in_use);
+  tx->acquire_snapshot(true);
+
+  rocksdb::ColumnFamilyHandle *const cf = m_pk_descr->get_cf();
+  const bool sorted_input = mrr_sorted_mode;
+  batch->request.reset(new Rdb_mrr_prefetch_thread::Request(
+      [tx, cf, batch, sorted_input]() {
+        tx->multi_get(cf, batch->n_elements, batch->keys, batch->values,
+                      batch->statuses, sorted_input);
+      }));
+  rdb_mrr_prefetch_submit(batch->request.get());
 
   return 0;
 }
 
+/*
+  Wait until MultiGet of a prefetched batch is done. Having to wait means
+  that consuming a batch takes less time than reading one, so let the next
+  batches grow (up to RDB_MRR_PREFETCH_MAX_GROWTH times @@mrr_batch_size) to
+  hide more of the read latency.
+*/
+
+void ha_rocksdb::mrr_wait_batch(mrr_batch *const batch) {
+  if (!batch->request) return;
+
+  if (!batch->request->is_done()) {
+    const ulonglong start = my_micro_time();
+    batch->request->wait();
+    global_stats.mrr_prefetch_waits.inc();
+    global_stats.mrr_prefetch_wait_micros.add(my_micro_time() - start);
+
+    const ssize_t max_limit = THDVAR(table->in_use, mrr_batch_size) *
+                              RDB_MRR_PREFETCH_MAX_GROWTH;
+    mrr_batch_limit = std::min(mrr_batch_limit * 2, max_limit);
+  }
+  batch->request.reset();
+}
+
 void ha_rocksdb::mrr_free() {
   // Free everything
   if (mrr_enabled_keyread) {
@@ -16690,11 +18241,18 @@ void ha_rocksdb::mrr_free() {
   mrr_rowid_reader = nullptr;
 }
 
-void ha_rocksdb::mrr_free_rows() {
-  for (ssize_t i = 0; i < mrr_n_elements; i++) {
-    mrr_values[i].~PinnableSlice();
-    mrr_statuses[i].~Status();
-    // no need to free mrr_keys
+void ha_rocksdb::mrr_free_rows(mrr_batch *const batch,
+                               const ssize_t n_consumed) {
+  // A prefetch thread may still be reading into the batch
+  if (batch->request) {
+    batch->request->wait();
+    batch->request.reset();
+  }
+
+  for (ssize_t i = 0; i < batch->n_elements; i++) {
+    batch->values[i].~PinnableSlice();
+    batch->statuses[i].~Status();
+    // no need to free the keys
   }
 
   // There could be rows that MultiGet has returned but MyRocks hasn't
@@ -16702,13 +18260,18 @@ void ha_rocksdb::mrr_free_rows() {
   // Count them in in "rows_read" anyway. (This is only necessary when using
   // clustered PK. When using a secondary key, the index-only part of the scan
   // that collects the rowids has caused all counters to be incremented)
-  if (mrr_used_cpk && mrr_n_elements) {
-    stats.rows_read += mrr_n_elements - mrr_read_index;
+  if (mrr_used_cpk && batch->n_elements) {
+    stats.rows_read += batch->n_elements - n_consumed;
   }
 
-  mrr_n_elements = 0;
+  batch->n_elements = 0;
   // We can't rely on the data from HANDLER_BUFFER once the scan is over, so:
-  mrr_values = nullptr;
+  batch->values = nullptr;
+}
+
+void ha_rocksdb::mrr_free_rows() {
+  mrr_free_rows(mrr_cur, mrr_read_index);
+  mrr_free_rows(mrr_next, 0);
 }
 
 int ha_rocksdb::multi_range_read_next(char **range_info) {
@@ -16725,8 +18288,9 @@ int ha_rocksdb::multi_range_read_next(char **range_info) {
     while (1) {
       if (table->in_use->killed) return HA_ERR_QUERY_INTERRUPTED;
 
-      if (mrr_read_index >= mrr_n_elements) {
-        if (mrr_rowid_reader->eof() || !mrr_n_elements) {
+      if (mrr_read_index >= mrr_cur->n_elements) {
+        if ((mrr_rowid_reader->eof() && !mrr_next->n_elements) ||
+            !mrr_cur->n_elements) {
           table->status = STATUS_NOT_FOUND;  // not sure if this is necessary?
           mrr_free_rows();
           return HA_ERR_END_OF_FILE;
@@ -16738,20 +18302,20 @@ int ha_rocksdb::multi_range_read_next(char **range_info) {
         }
       }
       // If we found a status that has a row, leave the loop
-      if (mrr_statuses[mrr_read_index].ok()) break;
+      if (mrr_cur->statuses[mrr_read_index].ok()) break;
 
       // Skip the NotFound errors, return any other error to the SQL layer
-      if (!mrr_statuses[mrr_read_index].IsNotFound())
-        return rdb_error_to_mysql(mrr_statuses[mrr_read_index]);
+      if (!mrr_cur->statuses[mrr_read_index].IsNotFound())
+        return rdb_error_to_mysql(mrr_cur->statuses[mrr_read_index]);
 
       mrr_read_index++;
     }
     size_t cur_key = mrr_read_index++;
 
-    const rocksdb::Slice &rowkey = mrr_keys[cur_key];
+    const rocksdb::Slice &rowkey = mrr_cur->keys[cur_key];
 
     if (mrr_funcs.skip_record &&
-        mrr_funcs.skip_record(mrr_iter, mrr_range_ptrs[cur_key],
+        mrr_funcs.skip_record(mrr_iter, mrr_cur->range_ptrs[cur_key],
                               (uchar*)rowkey.data())) {
       rc = HA_ERR_END_OF_FILE;
       continue;
@@ -16760,10 +18324,11 @@ int ha_rocksdb::multi_range_read_next(char **range_info) {
     m_last_rowkey.copy((const char *)rowkey.data(), rowkey.size(),
                        &my_charset_bin);
 
-    *range_info = mrr_range_ptrs[cur_key];
+    *range_info = mrr_cur->range_ptrs[cur_key];
 
     m_retrieved_record.Reset();
-    m_retrieved_record.PinSlice(mrr_values[cur_key], &mrr_values[cur_key]);
+    m_retrieved_record.PinSlice(mrr_cur->values[cur_key],
+                                &mrr_cur->values[cur_key]);
 
     /* If we found the record, but it's expired, pretend we didn't find it.  */
     if (m_pk_descr->has_ttl() &&
@@ -16814,10 +18379,14 @@ mysql_declare_plugin(rocksdb_se){
 },
     myrocks::rdb_i_s_cfstats, myrocks::rdb_i_s_dbstats,
     myrocks::rdb_i_s_perf_context, myrocks::rdb_i_s_perf_context_global,
+    myrocks::rdb_i_s_perf_context_queries,
     myrocks::rdb_i_s_cfoptions, myrocks::rdb_i_s_compact_stats,
+    myrocks::rdb_i_s_compaction_filter_stats,
+    myrocks::rdb_i_s_drop_index_progress,
     myrocks::rdb_i_s_global_info, myrocks::rdb_i_s_ddl,
     myrocks::rdb_i_s_sst_props, myrocks::rdb_i_s_index_file_map,
     myrocks::rdb_i_s_lock_info, myrocks::rdb_i_s_trx_info,
     myrocks::rdb_i_s_deadlock_info,
     myrocks::rdb_i_s_bypass_rejected_query_history,
+    myrocks::rdb_i_s_bypass_query_shapes,
     myrocks::rdb_i_s_live_files_metadata mysql_declare_plugin_end;
@@ -50,6 +50,7 @@
 #include "./rdb_io_watchdog.h"
 #include "./rdb_perf_context.h"
 #include "./rdb_sst_info.h"
+#include "./rdb_threads.h"
 #include "./rdb_utils.h"
 
 /**
@@ -104,6 +105,9 @@ struct Rdb_table_handler {
   my_io_perf_atomic_t m_io_perf_write;
   Rdb_atomic_perf_counters m_table_perf_context;
 
+  /* Number of open scans that read ahead, see rocksdb_scan_readahead_* */
+  std::atomic_uint m_readahead_scans;
+
   /* Stores cached memtable estimate statistics */
   std::atomic_uint m_mtcache_lock;
   uint64_t m_mtcache_count;
@@ -152,6 +156,13 @@ class ha_rocksdb : public my_core::handler {
 
   const rocksdb::Snapshot *m_scan_it_snapshot;
 
+  /*
+    Number of times m_scan_it was moved forward since it was positioned, and
+    whether it has been re-created to read ahead. See scan_it_next().
+  */
+  ulonglong m_scan_it_next_count;
+  bool m_scan_it_readahead;
+
   /* Buffers used for upper/lower bounds for m_scan_it. */
   uchar *m_scan_it_lower_bound;
   uchar *m_scan_it_upper_bound;
@@ -327,6 +338,8 @@ class ha_rocksdb : public my_core::handler {
                            const bool use_all_keys, const uint eq_cond_len)
       MY_ATTRIBUTE((__nonnull__));
   void release_scan_iterator(void);
+  void scan_it_next(const Rdb_key_def &kd);
+  void enable_scan_readahead(const Rdb_key_def &kd);
 
   rocksdb::Status get_for_update(Rdb_transaction *const tx,
                                  const Rdb_key_def &kd,
@@ -688,24 +701,114 @@ class ha_rocksdb : public my_core::handler {
   friend class Mrr_pk_scan_rowid_source;
   friend class Mrr_sec_key_rowid_source;
 
-  // MRR parameters and output values
-  rocksdb::Slice *mrr_keys;
-  rocksdb::Status *mrr_statuses;
-  char **mrr_range_ptrs;
-  rocksdb::PinnableSlice *mrr_values;
+  // MRR parameters and output values of one MultiGet call
+  struct mrr_batch {
+    // Part of mrr_buf that holds the arrays below
+    char *buf_start = nullptr;
+    char *buf_end = nullptr;
+
+    rocksdb::Slice *keys = nullptr;
+    rocksdb::Status *statuses = nullptr;
+    char **range_ptrs = nullptr;
+    rocksdb::PinnableSlice *values = nullptr;
+
+    ssize_t n_elements = 0;  // Number of elements in the above arrays
+
+    // Set while MultiGet for this batch may be running on a prefetch thread
+    std::unique_ptr<Rdb_mrr_prefetch_thread::Request> request;
+  };
+
+  /*
+    With overlapped MRR, mrr_buf is split in two halves. The rows of mrr_cur
+    are returned to the SQL layer while MultiGet for mrr_next runs on a
+    prefetch thread. Otherwise, mrr_cur uses the whole buffer and mrr_next
+    stays empty.
+  */
+  mrr_batch mrr_batches[2];
+  mrr_batch *mrr_cur;
+  mrr_batch *mrr_next;
 
-  ssize_t mrr_n_elements;  // Number of elements in the above arrays
-  ssize_t mrr_read_index;  // Number of the element we will return next
+  ssize_t mrr_read_index;  // Number of the element in mrr_cur we return next
+
+  bool mrr_prefetch;       // true <=> overlapped MRR is used for this scan
+  ssize_t mrr_batch_limit; // Current max number of keys in a batch
 
   // if true, MRR code has enabled keyread (and should disable it back)
   bool mrr_enabled_keyread;
   bool mrr_used_cpk;
 
   int mrr_fill_buffer();
+  int mrr_collect_rowids(mrr_batch *const batch);
+  int mrr_prefetch_next_batch();
+  void mrr_wait_batch(mrr_batch *const batch);
+  void mrr_free_rows(mrr_batch *const batch, const ssize_t n_consumed);
   void mrr_free_rows();
   void mrr_free();
   uint mrr_get_length_per_rec();
 
+  /*
+    Order-preserving lookahead for secondary index scans that are not served
+    by MRR (ORDER BY ... LIMIT, ICP scans, etc). Rowids of the next few index
+    records are resolved with one MultiGet call and the rows are returned to
+    the SQL layer one by one, in index order.
+  */
+  struct sk_lookahead_info {
+    struct entry {
+      size_t sk_offset;
+      size_t pk_offset;
+      uint sk_len;
+      uint pk_len;
+    };
+
+    // Secondary keys and rowids of the buffered records, back to back
+    std::string sk_buf;
+    std::string pk_buf;
+    std::vector<entry> entries;
+
+    // MultiGet parameters and output values
+    std::vector<rocksdb::Slice> keys;
+    std::vector<rocksdb::Status> statuses;
+    std::unique_ptr<rocksdb::PinnableSlice[]> values;
+    uint values_size = 0;
+
+    uint read_index = 0;  // Number of the element we will return next
+    uint next_batch = 1;  // Size of the next batch, doubled on every refill
+    bool forward = true;  // Direction the batch was collected in
+
+    bool empty() const { return entries.empty(); }
+    bool has_rows() const { return read_index < entries.size(); }
+
+    rocksdb::Slice sk(const uint i) const {
+      return rocksdb::Slice(sk_buf.data() + entries[i].sk_offset,
+                            entries[i].sk_len);
+    }
+
+    void clear() {
+      for (uint i = 0; i < std::min<size_t>(entries.size(), values_size); i++)
+        values[i].Reset();
+      sk_buf.clear();
+      pk_buf.clear();
+      entries.clear();
+      keys.clear();
+      statuses.clear();
+      read_index = 0;
+    }
+
+    void reset() {
+      clear();
+      next_batch = 1;
+    }
+  };
+
+  sk_lookahead_info m_sk_lookahead;
+
+  bool sk_lookahead_usable() const MY_ATTRIBUTE((__warn_unused_result__));
+  int sk_lookahead_fill(uchar *const buf, const bool move_forward)
+      MY_ATTRIBUTE((__nonnull__, __warn_unused_result__));
+  int sk_lookahead_next(uchar *const buf)
+      MY_ATTRIBUTE((__nonnull__, __warn_unused_result__));
+  void sk_lookahead_reposition();
+
   struct key_def_cf_info {
     std::shared_ptr<rocksdb::ColumnFamilyHandle> cf_handle;
     bool is_reverse_cf;
@@ -1128,6 +1231,10 @@ bool should_allow_filters_select_bypass();
 
 uint32_t get_select_bypass_rejected_query_history_size();
 
+uint32_t get_select_bypass_query_shapes_size();
+
+uint32_t get_select_bypass_plan_cache_size();
+
 uint32_t get_select_bypass_debug_row_delay();
 
 unsigned long long  // NOLINT(runtime/int)
@@ -1183,5 +1290,7 @@ bool rdb_tx_started(Rdb_transaction *tx);
 extern std::atomic<uint64_t> rocksdb_select_bypass_executed;
 extern std::atomic<uint64_t> rocksdb_select_bypass_rejected;
 extern std::atomic<uint64_t> rocksdb_select_bypass_failed;
+extern std::atomic<uint64_t> rocksdb_bypass_plan_cache_hits;
+extern std::atomic<uint64_t> rocksdb_bypass_plan_cache_misses;
 
 }  // namespace myrocks
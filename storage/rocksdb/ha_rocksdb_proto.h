@@ -112,4 +112,11 @@ Rdb_ddl_manager *rdb_get_ddl_manager(void)
 class Rdb_binlog_manager;
 Rdb_binlog_manager *rdb_get_binlog_manager(void)
     MY_ATTRIBUTE((__warn_unused_result__));
+
+class Rdb_key_def;
+rocksdb::Range get_range(const Rdb_key_def &kd, uchar buf[]);
+
+struct Rdb_drop_index_thread;
+Rdb_drop_index_thread *rdb_get_drop_index_thread(void)
+    MY_ATTRIBUTE((__warn_unused_result__));
 }  // namespace myrocks
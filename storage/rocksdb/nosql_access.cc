@@ -54,6 +54,10 @@ static const size_t MAX_SIZE = std::numeric_limits<size_t>::max();
 // for stack allocation
 static const size_t KEY_WRITER_DEFAULT_SIZE = 16;
 
+// Max number of secondary index rows whose PK lookups are batched into a
+// single MultiGet
+static const size_t SK_MULTIGET_BATCH_SIZE = 128;
+
 namespace myrocks {
 
 /* We only support simple equal / comparison functions */
@@ -69,6 +73,24 @@ bool inline is_supported_item_func(Item_func::Functype type) {
   return true;
 }
 
+/*
+  The part of a SELECT bypass query that only depends on its shape, which is
+  resolved once per statement digest and table and reused by later queries
+  that only differ in literal values. See Rdb_tbl_def::find_bypass_plan
+ */
+struct select_bypass_plan {
+  uint index;
+  bool is_order_desc;
+  // field_index of each SELECT item
+  std::vector<uint> item_fields;
+  // field_index of each WHERE expression, in the order of AND
+  std::vector<uint> cond_fields;
+  bool keyread_only;
+  MY_BITMAP lookup_bitmap = {nullptr, 0, 0, nullptr, nullptr};
+
+  ~select_bypass_plan() { bitmap_free(&lookup_bitmap); }
+};
+
 namespace {
 
 /*
@@ -138,6 +160,16 @@ class select_parser {
       return true;
     }
 
+    find_plan();
+
+    if (m_plan != nullptr) {
+      // Index and ORDER BY are already validated for this shape, fields
+      // still need to be bound to the items and literals to be checked
+      m_index = m_plan->index;
+      m_is_order_desc = m_plan->is_order_desc;
+      return parse_items() || parse_where() || parse_limit();
+    }
+
     // @TODO - PROCEDURE
     // NOTE: These have side effects and their orders are important
     if (parse_index() || parse_items() || parse_order_by() || parse_where() ||
@@ -145,6 +177,17 @@ class select_parser {
       return true;
     }
 
+    if (!m_plan_key.empty()) {
+      m_new_plan = std::make_shared<select_bypass_plan>();
+      m_new_plan->index = m_index;
+      m_new_plan->is_order_desc = m_is_order_desc;
+      m_new_plan->item_fields.reserve(m_field_list.size());
+      for (const auto field : m_field_list) {
+        m_new_plan->item_fields.push_back(field->field_index);
+      }
+      m_new_plan->cond_fields = std::move(m_cond_fields);
+    }
+
     return false;
   }
 
@@ -256,6 +299,20 @@ class select_parser {
   uint64_t get_select_limit() const { return m_select_limit; }
   uint64_t get_offset_limit() const { return m_offset_limit; }
   const char *get_error_msg() const { return m_error_msg; }
+  Rdb_tbl_def *get_tbl_def() const { return m_tbl_def; }
+  const select_bypass_plan *get_plan() const { return m_plan.get(); }
+
+  /*
+    Plan built by this query, to be completed by select_exec and then
+    published to the table with publish_plan
+   */
+  select_bypass_plan *get_new_plan() const { return m_new_plan.get(); }
+
+  void publish_plan() const {
+    DBUG_ASSERT(m_new_plan != nullptr);
+    m_tbl_def->add_bypass_plan(m_plan_key, m_new_plan,
+                               get_select_bypass_plan_cache_size());
+  }
 
  private:
   THD *m_thd;
@@ -263,6 +320,15 @@ class select_parser {
   TABLE_LIST *m_table_list;
   st_select_lex *m_select_lex;
 
+  // Only set if the plan cache is in use for this query
+  Rdb_tbl_def *m_tbl_def = nullptr;
+  std::string m_plan_key;
+  std::shared_ptr<const select_bypass_plan> m_plan;
+  std::shared_ptr<select_bypass_plan> m_new_plan;
+
+  // field_index of each WHERE expression, kept for m_new_plan
+  std::vector<uint> m_cond_fields;
+
   uint m_index;
   bool m_is_order_desc;
   std::vector<Field *> m_field_list;
@@ -276,6 +342,40 @@ class select_parser {
   char m_error_msg_buf[FN_REFLEN];
 
  private:
+  /*
+    Look up the cached plan of this query's digest. The digest is only
+    computed if performance_schema or sql_stats need it, and a truncated one
+    may be shared by different queries
+   */
+  void find_plan() {
+    if (get_select_bypass_plan_cache_size() == 0 ||
+        m_thd->m_digest == nullptr ||
+        m_thd->m_digest->m_digest_storage.is_empty() ||
+        m_thd->m_digest->m_digest_storage.m_full) {
+      return;
+    }
+
+    std::string db_table;
+    db_table.append(m_table->s->db.str);
+    db_table.append(".");
+    db_table.append(m_table->s->table_name.str);
+    m_tbl_def = rdb_get_ddl_manager()->find(db_table);
+    if (m_tbl_def == nullptr) {
+      return;
+    }
+
+    unsigned char md5[MD5_HASH_SIZE];
+    compute_digest_md5(&m_thd->m_digest->m_digest_storage, md5);
+    m_plan_key.assign(reinterpret_cast<char *>(md5), MD5_HASH_SIZE);
+
+    m_plan = m_tbl_def->find_bypass_plan(m_plan_key);
+    if (m_plan != nullptr) {
+      rocksdb_bypass_plan_cache_hits++;
+    } else {
+      rocksdb_bypass_plan_cache_misses++;
+    }
+  }
+
   bool parse_index() {
     if (m_table_list->index_hints != nullptr) {
       if (m_table_list->index_hints->elements == 1) {
@@ -325,6 +425,12 @@ class select_parser {
 
       Item_field *field_item = static_cast<Item_field *>(item);
       auto name = field_item->field_name;
+      if (m_plan != nullptr &&
+          m_field_list.size() < m_plan->item_fields.size()) {
+        // Only a hint, find_field_in_table still checks the name
+        field_item->cached_field_index =
+            m_plan->item_fields[m_field_list.size()];
+      }
 
       // At this point we only know field name and need to resolve the
       // field ourselves (under normal circumstances MySQL does it for us)
@@ -339,7 +445,7 @@ class select_parser {
       }
 
       auto field_type = field->real_type();
-      if (field_type == MYSQL_TYPE_VARCHAR &&
+      if (m_plan == nullptr && field_type == MYSQL_TYPE_VARCHAR &&
           field->charset() != &my_charset_bin &&
           field->charset() != &my_charset_utf8_bin &&
           field->charset() != &my_charset_latin1_bin) {
@@ -474,6 +580,11 @@ class select_parser {
 
     // Locate the field
     auto field_name = field_arg->field_name;
+    if (m_plan != nullptr && m_where_pos < m_plan->cond_fields.size()) {
+      // Only a hint, find_field_in_table still checks the name
+      field_arg->cached_field_index = m_plan->cond_fields[m_where_pos];
+    }
+    m_where_pos++;
     Field *found =
         find_field_in_table(m_thd, m_table, field_name, strlen(field_name),
                             false, &field_arg->cached_field_index);
@@ -489,6 +600,10 @@ class select_parser {
       return true;
     }
 
+    if (!m_plan_key.empty() && m_plan == nullptr) {
+      m_cond_fields.push_back(found->field_index);
+    }
+
     // TAO-specific optimizations to remove redundant time >= 0 and time <=
     // UINT32_MAX. Once TAO removes those unnecessary WHERE we can take
     // these out
@@ -531,6 +646,9 @@ class select_parser {
       "Unsupported WHERE: should be expr [(AND expr)*] where expr only "
       "contains >, >=, <, <=, =, IN";
 
+  // Position of the WHERE expression being parsed
+  uint m_where_pos = 0;
+
   bool parse_where() {
     if (m_select_lex->where == nullptr) {
       m_error_msg = where_err_msg;
@@ -637,6 +755,7 @@ class select_exec {
     m_error_msg = "UNKNOWN";
 
     m_lookup_bitmap = {nullptr, 0, 0, nullptr, nullptr};
+    m_lookup_map = &m_lookup_bitmap;
   }
 
   ~select_exec() { bitmap_free(&m_lookup_bitmap); }
@@ -734,6 +853,9 @@ class select_exec {
   bool unpack_for_pk(const rocksdb::Slice &rkey, const rocksdb::Slice &rvalue);
   bool eval_cond();
   int eval_and_send();
+  int batch_sk_row(txn_wrapper *txn, const rocksdb::Slice &rkey,
+                   const rocksdb::Slice &rvalue);
+  int flush_sk_batch(txn_wrapper *txn);
   bool run_pk_point_query(txn_wrapper *txn);
   bool run_sk_point_query(txn_wrapper *txn);
   bool pack_index_tuple(uint key_part_no, Rdb_string_writer *writer,
@@ -827,6 +949,24 @@ class select_exec {
   // Temporary buffer for storing value
   rocksdb::PinnableSlice m_pk_value;
 
+  // A secondary index row pending its PK lookup in m_sk_batch
+  struct sk_batch_entry {
+    std::string sk_key;
+    // Only set if the SK covers the lookup
+    std::string sk_value;
+    // Only set if we need to look up the PK
+    std::string pk_key;
+  };
+
+  // Use MultiGet for PK lookups of SK rows. Enabled for IN lists with more
+  // items than rocksdb_select_bypass_multiget_min
+  bool m_sk_multiget = false;
+
+  // Pending SK rows in index order, only the first m_sk_batch_count are valid
+  // so that the strings can be reused across batches
+  std::vector<sk_batch_entry> m_sk_batch;
+  size_t m_sk_batch_count = 0;
+
   // Artificial delays for kill testing
   uint32_t m_debug_row_delay;
 
@@ -854,6 +994,9 @@ class select_exec {
   // Lookup bitmap for covering check
   MY_BITMAP m_lookup_bitmap;
 
+  // Either m_lookup_bitmap or the one of the cached plan
+  const MY_BITMAP *m_lookup_map;
+
   // Upper and lower bounds for iterators
   std::vector<uchar> m_lower_bound_buf;
   std::vector<uchar> m_upper_bound_buf;
@@ -955,6 +1098,19 @@ bool inline select_exec::pack_cond(uint key_part_no, const sql_cond &cond,
   return false;
 }
 
+/*
+  Whether both operators bound a range from the same side, such as > and >=
+ */
+static bool is_same_bound(Item_func::Functype op1, Item_func::Functype op2) {
+  auto is_start = [](Item_func::Functype op) {
+    return op == Item_func::GT_FUNC || op == Item_func::GE_FUNC;
+  };
+  auto is_end = [](Item_func::Functype op) {
+    return op == Item_func::LT_FUNC || op == Item_func::LE_FUNC;
+  };
+  return (is_start(op1) && is_start(op2)) || (is_end(op1) && is_end(op2));
+}
+
 /*
   Scan the entire WHERE clause using the given index, and create a
   query plan. The goal is to break the WHERE clause into prefix and
@@ -979,17 +1135,19 @@ bool INLINE_ATTR select_exec::scan_where() {
     std::pair<int, int> &index_pair = m_field_index_to_where[field_index];
     if (index_pair.first == -1) {
       index_pair.first = i;
-    } else {
+    } else if (index_pair.second == -1) {
       // We have multiple sql_cond for the same field
-      if (index_pair.second != -1) {
-        // We've already seen 2 of conditions already - fail
-        m_unsupported = true;
-        m_error_msg = "Unsupported range query pattern";
-        return true;
-      }
-
+      index_pair.second = i;
+    } else if (is_same_bound(where_list[index_pair.first].op_type,
+                             where_list[index_pair.second].op_type) &&
+               !is_same_bound(where_list[index_pair.first].op_type,
+                              where_list[i].op_type)) {
+      // Prefer a (start, end) pair over 2 bounds of the same side, so that
+      // A > 1 AND A > 2 AND A < 5 scans (1, 5) and filters on A > 2
       index_pair.second = i;
     }
+    // Conditions on the same field that are not in index_pair are never
+    // packed into the key and stay as filters
   }
 
   // We start with just one KeyIndexTuple to pack
@@ -1121,11 +1279,9 @@ bool INLINE_ATTR select_exec::scan_where() {
         auto &second_cond = where_list[index_pair.second];
         if (second_cond.op_type == Item_func::GT_FUNC ||
             second_cond.op_type == Item_func::GE_FUNC) {
-          if (start_id != -1) {
-            m_unsupported = true;
-            m_error_msg = "Unsupported range query pattern";
-            return true;
-          } else {
+          // For a redundant bound such as A > 1 AND A > 2 the first one
+          // becomes the start of the range and the second one a filter
+          if (start_id == -1) {
             start_id = index_pair.second;
             if (second_cond.op_type == Item_func::GE_FUNC) {
               start_inclusive = true;
@@ -1133,11 +1289,9 @@ bool INLINE_ATTR select_exec::scan_where() {
           }
         } else if (second_cond.op_type == Item_func::LE_FUNC ||
                    second_cond.op_type == Item_func::LT_FUNC) {
-          if (end_id != -1) {
-            m_unsupported = true;
-            m_error_msg = "Unsupported range query pattern";
-            return true;
-          } else {
+          // Same as above - A < 1 AND A < 2 ends the range at the first
+          // bound and evaluates the second one as a filter
+          if (end_id == -1) {
             end_id = index_pair.second;
             if (second_cond.op_type == Item_func::LE_FUNC) {
               end_inclusive = true;
@@ -1291,6 +1445,15 @@ void INLINE_ATTR select_exec::scan_value() {
   }
 #endif
 
+  const select_bypass_plan *plan = m_parser.get_plan();
+  if (plan != nullptr) {
+    m_keyread_only = plan->keyread_only;
+    m_lookup_map = &plan->lookup_bitmap;
+    m_converter->setup_field_decoders(m_table->read_set, m_index,
+                                      false /* keyread_only */);
+    return;
+  }
+
   std::vector<bool> index_cover_bitmap(m_table_share->fields, false);
   for (uint i = 0; i < m_index_info->actual_key_parts; ++i) {
     if (m_key_def->get_pack_info(i)->m_covered) {
@@ -1310,6 +1473,15 @@ void INLINE_ATTR select_exec::scan_value() {
     m_key_def->get_lookup_bitmap(m_table, &m_lookup_bitmap);
   }
 
+  select_bypass_plan *new_plan = m_parser.get_new_plan();
+  if (new_plan != nullptr) {
+    // The plan takes over the lookup bitmap
+    new_plan->keyread_only = m_keyread_only;
+    new_plan->lookup_bitmap = m_lookup_bitmap;
+    m_lookup_bitmap = {nullptr, 0, 0, nullptr, nullptr};
+    m_lookup_map = &new_plan->lookup_bitmap;
+  }
+
   m_converter->setup_field_decoders(m_table->read_set, m_index,
                                     false /* keyread_only */);
 }
@@ -1332,12 +1504,15 @@ bool INLINE_ATTR select_exec::run() {
     }
   }
 
-  // Look for the table metadata
-  std::string db_table;
-  db_table.append(m_table_share->db.str);
-  db_table.append(".");
-  db_table.append(m_table_share->table_name.str);
-  m_tbl_def = m_ddl_manager->find(db_table);
+  // Look for the table metadata, unless the parser already did
+  m_tbl_def = m_parser.get_tbl_def();
+  if (m_tbl_def == nullptr) {
+    std::string db_table;
+    db_table.append(m_table_share->db.str);
+    db_table.append(".");
+    db_table.append(m_table_share->table_name.str);
+    m_tbl_def = m_ddl_manager->find(db_table);
+  }
   if (m_tbl_def == nullptr) {
     m_handler->print_error(HA_ERR_ROCKSDB_INVALID_TABLE, 0);
     return true;
@@ -1355,6 +1530,11 @@ bool INLINE_ATTR select_exec::run() {
   // Scan the value and devise a strategy to unpack the values
   scan_value();
 
+  if (m_parser.get_new_plan() != nullptr) {
+    // Later queries of the same shape can skip resolving the plan
+    m_parser.publish_plan();
+  }
+
   // Prepare to send
   if (m_protocol->send_result_set_metadata(
           &m_parser.get_select_lex()->item_list,
@@ -1416,6 +1596,12 @@ bool INLINE_ATTR select_exec::run_query() {
   } else {
     m_pk_tuple_buf.resize(m_pk_def->max_storage_fmt_length());
 
+    // An IN list on SK that doesn't cover the query can look up the PKs
+    // of several rows with one MultiGet
+    m_sk_multiget =
+        !m_index_is_pk && !m_keyread_only &&
+        m_key_index_tuples.size() > get_select_bypass_multiget_min();
+
     if (m_is_point_query) {
       // The index is fully covered including both SK+PK
       ret = run_sk_point_query(&txn);
@@ -1558,11 +1744,16 @@ bool INLINE_ATTR select_exec::run_sk_point_query(txn_wrapper *txn) {
       continue;
     }
 
-    if (unpack_for_sk(txn, rkey_slice, m_scan_it->value())) {
-      return true;
+    int ret;
+    if (m_sk_multiget) {
+      ret = batch_sk_row(txn, rkey_slice, m_scan_it->value());
+    } else {
+      if (unpack_for_sk(txn, rkey_slice, m_scan_it->value())) {
+        return true;
+      }
+      ret = eval_and_send();
     }
 
-    int ret = eval_and_send();
     if (ret > 0) {
       return true;
     } else if (ret < 0) {
@@ -1571,6 +1762,10 @@ bool INLINE_ATTR select_exec::run_sk_point_query(txn_wrapper *txn) {
     }
   }
 
+  if (m_sk_multiget && flush_sk_batch(txn) > 0) {
+    return true;
+  }
+
   return false;
 }
 
@@ -1610,7 +1805,7 @@ bool INLINE_ATTR select_exec::unpack_for_sk(txn_wrapper *txn,
                                             const rocksdb::Slice &rkey,
                                             const rocksdb::Slice &rvalue) {
   bool covers_lookup =
-      m_keyread_only || m_key_def->covers_lookup(&rvalue, &m_lookup_bitmap);
+      m_keyread_only || m_key_def->covers_lookup(&rvalue, m_lookup_map);
 
   // SECONDARY KEY - there are a few cases to take care of:
   // 1. Secondary index covers the entire look up
@@ -1658,6 +1853,112 @@ bool INLINE_ATTR select_exec::unpack_for_sk(txn_wrapper *txn,
   return false;
 }
 
+/*
+  Queue a secondary index row and defer its PK lookup, so that the lookups
+  of a whole batch can be issued with a single MultiGet. Rows are sent in
+  the same order they are queued. Returns the same as eval_and_send
+ */
+int INLINE_ATTR select_exec::batch_sk_row(txn_wrapper *txn,
+                                          const rocksdb::Slice &rkey,
+                                          const rocksdb::Slice &rvalue) {
+  if (m_sk_batch_count == m_sk_batch.size()) {
+    m_sk_batch.emplace_back();
+  }
+  sk_batch_entry &entry = m_sk_batch[m_sk_batch_count++];
+  entry.sk_key.assign(rkey.data(), rkey.size());
+
+  if (m_key_def->covers_lookup(&rvalue, m_lookup_map)) {
+    entry.sk_value.assign(rvalue.data(), rvalue.size());
+    entry.pk_key.clear();
+  } else {
+    uint pk_tuple_size = m_key_def->get_primary_key_tuple(
+        m_table, *m_pk_def, &rkey, m_pk_tuple_buf.data());
+    if (pk_tuple_size == RDB_INVALID_KEY_LEN) {
+      m_handler->print_error(HA_ERR_ROCKSDB_CORRUPT_DATA, 0);
+      return 1;
+    }
+    entry.pk_key.assign(reinterpret_cast<const char *>(m_pk_tuple_buf.data()),
+                        pk_tuple_size);
+    entry.sk_value.clear();
+  }
+
+  // Don't look up more rows than LIMIT could possibly send
+  DBUG_ASSERT(m_row_count < m_select_limit);
+  if (m_sk_batch_count >= SK_MULTIGET_BATCH_SIZE ||
+      m_sk_batch_count >= m_select_limit - m_row_count) {
+    return flush_sk_batch(txn);
+  }
+
+  return 0;
+}
+
+/*
+  Look up the PK of all rows in m_sk_batch with MultiGet, then unpack and
+  send them in index order. Returns the same as eval_and_send
+ */
+int INLINE_ATTR select_exec::flush_sk_batch(txn_wrapper *txn) {
+  size_t batch_count = m_sk_batch_count;
+  m_sk_batch_count = 0;
+
+  std::vector<rocksdb::Slice> key_slices;
+  key_slices.reserve(batch_count);
+  for (size_t i = 0; i < batch_count; ++i) {
+    if (!m_sk_batch[i].pk_key.empty()) {
+      key_slices.emplace_back(m_sk_batch[i].pk_key);
+    }
+  }
+
+  size_t size = key_slices.size();
+  std::vector<rocksdb::PinnableSlice> value_slices(size);
+  std::vector<rocksdb::Status> statuses(size);
+  if (size > 0) {
+    // PKs come in SK order, which is not sorted
+    txn->multi_get(m_pk_def->get_cf(), size, false /* sorted_input */,
+                   key_slices.data(), value_slices.data(), statuses.data());
+  }
+
+  size_t key_no = 0;
+  for (size_t i = 0; i < batch_count; ++i) {
+    if (unlikely(handle_killed())) {
+      return 1;
+    }
+
+    const sk_batch_entry &entry = m_sk_batch[i];
+    int rc = 0;
+    if (entry.pk_key.empty()) {
+      // SK covers the entire lookup
+      rocksdb::Slice rkey(entry.sk_key);
+      rocksdb::Slice rvalue(entry.sk_value);
+      rc = m_key_def->unpack_record(
+          m_table, m_table->record[0], &rkey, &rvalue,
+          m_converter->get_verify_row_debug_checksums());
+      if (!rc) {
+        ha_rocksdb::inc_covered_sk_lookup();
+      }
+    } else {
+      if (!statuses[key_no].ok()) {
+        txn->report_error(statuses[key_no]);
+        return 1;
+      }
+      rc = m_converter->decode(m_pk_def, m_table->record[0],
+                               &key_slices[key_no], &value_slices[key_no]);
+      key_no++;
+    }
+
+    if (rc) {
+      m_handler->print_error(rc, 0);
+      return 1;
+    }
+
+    int ret = eval_and_send();
+    if (ret != 0) {
+      return ret;
+    }
+  }
+
+  return 0;
+}
+
 int INLINE_ATTR select_exec::eval_and_send() {
   m_examined_rows++;
   if (eval_cond()) {
@@ -1840,17 +2141,21 @@ bool INLINE_ATTR select_exec::run_range_query(txn_wrapper *txn) {
       // skipping the first N items in LIMIT, but this is low priority
       // for now
       const rocksdb::Slice rvalue = m_scan_it->value();
+      int ret;
       if (m_index_is_pk) {
         if (unlikely(unpack_for_pk(rkey, rvalue))) {
           return true;
         }
+        ret = eval_and_send();
+      } else if (m_sk_multiget) {
+        ret = batch_sk_row(txn, rkey, rvalue);
       } else {
         if (unlikely(unpack_for_sk(txn, rkey, rvalue))) {
           return true;
         }
+        ret = eval_and_send();
       }
 
-      int ret = eval_and_send();
       if (unlikely(ret > 0)) {
         // failure
         return true;
@@ -1863,6 +2168,10 @@ bool INLINE_ATTR select_exec::run_range_query(txn_wrapper *txn) {
     }  // while (true)
   }    // for m_key_index_tuples
 
+  if (m_sk_multiget && flush_sk_batch(txn) > 0) {
+    return true;
+  }
+
   return false;
 }
 
@@ -1886,10 +2195,50 @@ bool inline is_bypass_on(st_select_lex *select_lex) {
   return (select_lex->select_bypass_hint == SELECT_LEX::SELECT_BYPASS_HINT_ON);
 }
 
+std::unordered_map<std::string, BYPASS_SHAPE_ITEM> bypass_query_shapes;
+std::mutex bypass_query_shape_lock;
+
+/*
+  Account the bypass outcome of the current query against its digest, which
+  is reported in information_schema.ROCKSDB_BYPASS_QUERY_SHAPES
+ */
+static void update_bypass_query_shape(THD *thd,
+                                      uint64_t BYPASS_SHAPE_ITEM::*counter) {
+  uint32_t max_shapes = get_select_bypass_query_shapes_size();
+  if (max_shapes == 0 || thd->m_digest == nullptr ||
+      thd->m_digest->m_digest_storage.is_empty()) {
+    // Digest is only computed if performance_schema or sql_stats need it
+    return;
+  }
+
+  unsigned char md5[MD5_HASH_SIZE];
+  compute_digest_md5(&thd->m_digest->m_digest_storage, md5);
+  std::string digest(reinterpret_cast<char *>(md5), MD5_HASH_SIZE);
+
+  const std::lock_guard<std::mutex> lock(bypass_query_shape_lock);
+  auto it = bypass_query_shapes.find(digest);
+  if (it == bypass_query_shapes.end()) {
+    if (bypass_query_shapes.size() >= max_shapes) {
+      // Keep the shapes we already track rather than evicting them
+      return;
+    }
+
+    BYPASS_SHAPE_ITEM shape = {};
+    String normalized_query_text;
+    compute_digest_text(&thd->m_digest->m_digest_storage,
+                        &normalized_query_text);
+    shape.query = normalized_query_text.c_ptr_safe();
+    it = bypass_query_shapes.emplace(digest, shape).first;
+  }
+
+  it->second.*counter += 1;
+}
+
 std::deque<REJECTED_ITEM> rejected_bypass_queries;
 std::mutex rejected_bypass_query_lock;
 bool handle_unsupported_bypass(THD *thd, const char *error_msg) {
   rocksdb_select_bypass_rejected++;
+  update_bypass_query_shape(thd, &BYPASS_SHAPE_ITEM::rejected);
 
   if (should_log_rejected_select_bypass()) {
     // Record the rejected query into the error log if rejected query history
@@ -1967,9 +2316,11 @@ bool rocksdb_handle_single_table_select(THD *thd, SELECT_LEX *select_lex) {
                             thd->query(), thd->get_stmt_da()->message());
     }
     rocksdb_select_bypass_failed++;
+    update_bypass_query_shape(thd, &BYPASS_SHAPE_ITEM::failed);
   } else {
     my_eof(thd);
     rocksdb_select_bypass_executed++;
+    update_bypass_query_shape(thd, &BYPASS_SHAPE_ITEM::executed);
   }
 
   return true;
@@ -20,6 +20,7 @@
 #include <deque>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 /* C standard header files */
@@ -40,6 +41,17 @@ struct REJECTED_ITEM {
   std::string error_msg;
 };
 
+struct BYPASS_SHAPE_ITEM {
+  // Normalized text of the first query seen with this digest
+  std::string query;
+  // Number of queries executed by bypass
+  uint64_t executed;
+  // Number of queries rejected by bypass
+  uint64_t rejected;
+  // Number of queries failed in bypass
+  uint64_t failed;
+};
+
 namespace myrocks {
 
 bool rocksdb_handle_single_table_select(THD *thd, st_select_lex *select_lex);
@@ -47,4 +59,8 @@ bool rocksdb_handle_single_table_select(THD *thd, st_select_lex *select_lex);
 extern std::deque<REJECTED_ITEM> rejected_bypass_queries;
 extern std::mutex rejected_bypass_query_lock;
 
+// Bypass outcome per query shape, keyed by statement digest
+extern std::unordered_map<std::string, BYPASS_SHAPE_ITEM> bypass_query_shapes;
+extern std::mutex bypass_query_shape_lock;
+
 }  // namespace myrocks
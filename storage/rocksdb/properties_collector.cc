@@ -19,6 +19,8 @@
 
 /* Standard C++ header files */
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <map>
 #include <string>
 #include <vector>
@@ -41,6 +43,7 @@ std::atomic<uint64_t> rocksdb_num_sst_entry_merge(0);
 std::atomic<uint64_t> rocksdb_num_sst_entry_other(0);
 std::atomic<uint64_t> rocksdb_additional_compaction_triggers(0);
 my_bool rocksdb_compaction_sequential_deletes_count_sd = false;
+my_bool rocksdb_table_stats_use_sketches = false;
 
 Rdb_tbl_prop_coll::Rdb_tbl_prop_coll(Rdb_ddl_manager *const ddl_manager,
                                      const Rdb_compact_params &params,
@@ -49,6 +52,8 @@ Rdb_tbl_prop_coll::Rdb_tbl_prop_coll(Rdb_ddl_manager *const ddl_manager,
     : m_cf_id(cf_id),
       m_ddl_manager(ddl_manager),
       m_last_stats(nullptr),
+      m_collect_sketches(rocksdb_table_stats_use_sketches),
+      m_last_sketches(nullptr),
       m_window_pos(0l),
       m_deleted_rows(0l),
       m_max_deleted_rows(0l),
@@ -120,6 +125,7 @@ Rdb_index_stats *Rdb_tbl_prop_coll::AccessStats(const rocksdb::Slice &key) {
 
   if (m_last_stats == nullptr || m_last_stats->m_gl_index_id != gl_index_id) {
     m_keydef = nullptr;
+    m_last_sketches = nullptr;
 
     // starting a new table
     // add the new element into m_stats
@@ -141,9 +147,15 @@ Rdb_index_stats *Rdb_tbl_prop_coll::AccessStats(const rocksdb::Slice &key) {
         m_last_stats->m_distinct_keys_per_prefix.resize(
             m_keydef->get_key_parts());
         m_last_stats->m_name = m_keydef->get_name();
+
+        if (m_collect_sketches) {
+          m_sketches.emplace_back(gl_index_id, m_keydef->get_key_parts());
+          m_last_sketches = &m_sketches.back();
+        }
       }
     }
     m_cardinality_collector.Reset();
+    m_last_sketch_key.clear();
   }
 
   return m_last_stats;
@@ -189,10 +201,65 @@ void Rdb_tbl_prop_coll::CollectStatsForRow(const rocksdb::Slice &key,
 
   if (m_keydef != nullptr && type == rocksdb::kEntryPut) {
     m_cardinality_collector.ProcessKey(key, m_keydef.get(), stats);
+
+    if (m_last_sketches != nullptr) {
+      AddKeyToSketches(key);
+    }
   }
 }
 
+/*
+  Adds every key prefix which differs from the previous key to the sketches
+  of the current index. Sketches are not sampled: keys arrive sorted, so the
+  work is proportional to the number of distinct prefixes.
+*/
+void Rdb_tbl_prop_coll::AddKeyToSketches(const rocksdb::Slice &key) {
+  if (m_keydef->get_key_part_ends(&key, &m_sketch_key_parts)) {
+    return;
+  }
+
+  const size_t key_parts = m_sketch_key_parts.size();
+  DBUG_ASSERT(key_parts == m_last_sketches->m_prefixes.size());
+
+  // find the first key part which differs from the previous key
+  size_t column = 0;
+  if (!m_last_sketch_key.empty()) {
+    size_t start = Rdb_key_def::INDEX_NUMBER_SIZE;
+    for (; column < key_parts; column++) {
+      const size_t end = m_sketch_key_parts[column];
+      if (end != m_last_sketch_key_parts[column] ||
+          memcmp(key.data() + start, m_last_sketch_key.data() + start,
+                 end - start) != 0) {
+        break;
+      }
+      start = end;
+    }
+  }
+
+  if (column == key_parts) {
+    return;  // same key as the previous one
+  }
+
+  // FNV-1a over the key, finished at the end of every key part
+  const uint64_t FNV_PRIME = 0x100000001b3ULL;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  const uchar *const data = reinterpret_cast<const uchar *>(key.data());
+  size_t pos = 0;
+  for (size_t i = 0; i < key_parts; i++) {
+    for (; pos < m_sketch_key_parts[i]; pos++) {
+      hash = (hash ^ data[pos]) * FNV_PRIME;
+    }
+    if (i >= column) {
+      m_last_sketches->m_prefixes[i].add(Rdb_hll::mix(hash));
+    }
+  }
+
+  m_last_sketch_key.assign(key.data(), key.size());
+  m_last_sketch_key_parts.swap(m_sketch_key_parts);
+}
+
 const char *Rdb_tbl_prop_coll::INDEXSTATS_KEY = "__indexstats__";
+const char *Rdb_tbl_prop_coll::INDEXSKETCHES_KEY = "__indexsketches__";
 
 /*
   This function is called by RocksDB to compute properties to store in sst file
@@ -258,6 +325,10 @@ rocksdb::Status Rdb_tbl_prop_coll::Finish(
     m_recorded = true;
   }
   properties->insert({INDEXSTATS_KEY, Rdb_index_stats::materialize(m_stats)});
+  if (!m_sketches.empty()) {
+    properties->insert(
+        {INDEXSKETCHES_KEY, Rdb_index_sketches::materialize(m_sketches)});
+  }
   return rocksdb::Status::OK();
 }
 
@@ -360,6 +431,24 @@ void Rdb_tbl_prop_coll::read_stats_from_tbl_props(
   }
 }
 
+/*
+  Given the properties of an SST file, reads the distinct key prefix sketches
+  from it. Files written while sketches were disabled have none.
+*/
+void Rdb_tbl_prop_coll::read_sketches_from_tbl_props(
+    const std::shared_ptr<const rocksdb::TableProperties> &table_props,
+    std::vector<Rdb_index_sketches> *const out_sketches_vector) {
+  DBUG_ASSERT(out_sketches_vector != nullptr);
+  const auto &user_properties = table_props->user_collected_properties;
+  const auto it = user_properties.find(std::string(INDEXSKETCHES_KEY));
+  if (it != user_properties.end() &&
+      Rdb_index_sketches::unmaterialize(it->second, out_sketches_vector)) {
+    // an unreadable property only means the cardinality falls back to
+    // the per-file distinct counters
+    out_sketches_vector->clear();
+  }
+}
+
 /*
   Serializes an array of Rdb_index_stats into a network string.
 */
@@ -510,6 +599,25 @@ void Rdb_index_stats::merge(const Rdb_index_stats &s, const bool increment,
   }
 }
 
+/*
+  Replaces the distinct prefix counters, which were summed over SST files,
+  with the estimates of sketches merged from the same files.
+*/
+void Rdb_index_stats::set_cardinality(const Rdb_index_sketches &sketches) {
+  if (m_distinct_keys_per_prefix.size() < sketches.m_prefixes.size()) {
+    m_distinct_keys_per_prefix.resize(sketches.m_prefixes.size());
+  }
+
+  int64_t prev = 0;
+  for (size_t i = 0; i < sketches.m_prefixes.size(); i++) {
+    int64_t num_keys = sketches.m_prefixes[i].estimate();
+    num_keys = std::min(num_keys, m_rows);
+    // a longer prefix can't have fewer distinct values
+    num_keys = std::max(num_keys, prev);
+    m_distinct_keys_per_prefix[i] = prev = num_keys;
+  }
+}
+
 void Rdb_index_stats::adjust_cardinality(double adjustment_factor) {
   for (int64_t &num_keys : m_distinct_keys_per_prefix) {
     num_keys = MY_MAX(1, num_keys * adjustment_factor);
@@ -590,4 +698,187 @@ void Rdb_tbl_card_coll::SetCardinality(Rdb_index_stats *stats) {
   }
 }
 
+uint64_t Rdb_hll::mix(uint64_t hash) {
+  // finalizer of splitmix64
+  hash ^= hash >> 30;
+  hash *= 0xbf58476d1ce4e5b9ULL;
+  hash ^= hash >> 27;
+  hash *= 0x94d049bb133111ebULL;
+  hash ^= hash >> 31;
+  return hash;
+}
+
+void Rdb_hll::add(const uint64_t hash) {
+  const uint index = hash >> (64 - PRECISION);
+  const uint64_t rest = hash << PRECISION;
+  // position of the leftmost 1 bit in the remaining bits
+  const uint8_t rank =
+      rest == 0 ? 64 - PRECISION + 1 : __builtin_clzll(rest) + 1;
+  if (rank > m_registers[index]) {
+    m_registers[index] = rank;
+  }
+}
+
+void Rdb_hll::merge(const Rdb_hll &other) {
+  for (size_t i = 0; i < m_registers.size(); i++) {
+    m_registers[i] = std::max(m_registers[i], other.m_registers[i]);
+  }
+}
+
+uint64_t Rdb_hll::estimate() const {
+  const double m = NUM_REGISTERS;
+  double sum = 0;
+  uint zeros = 0;
+  for (const uint8_t reg : m_registers) {
+    sum += std::ldexp(1.0, -reg);
+    if (reg == 0) {
+      zeros++;
+    }
+  }
+
+  const double alpha = 0.7213 / (1 + 1.079 / m);
+  double estimate = alpha * m * m / sum;
+  if (estimate <= 2.5 * m && zeros > 0) {
+    // small range correction (linear counting)
+    estimate = m * std::log(m / zeros);
+  }
+  return static_cast<uint64_t>(estimate + 0.5);
+}
+
+/*
+  Registers are stored either as a dense array, or as (index, value) pairs
+  of the non-zero registers when few of them are set, which is the common
+  case for small indexes.
+*/
+void Rdb_hll::materialize(my_core::String *const out) const {
+  enum { DENSE = 0, SPARSE = 1 };
+  uint16_t non_zero = 0;
+  for (const uint8_t reg : m_registers) {
+    non_zero += (reg != 0);
+  }
+
+  out->append(static_cast<char>(PRECISION));
+  if (non_zero * 3 < NUM_REGISTERS) {
+    out->append(static_cast<char>(SPARSE));
+    rdb_netstr_append_uint16(out, non_zero);
+    for (uint16_t i = 0; i < m_registers.size(); i++) {
+      if (m_registers[i] != 0) {
+        rdb_netstr_append_uint16(out, i);
+        out->append(static_cast<char>(m_registers[i]));
+      }
+    }
+  } else {
+    out->append(static_cast<char>(DENSE));
+    out->append(reinterpret_cast<const char *>(m_registers.data()),
+                m_registers.size());
+  }
+}
+
+/*
+  @return true if the sketch could not be read
+*/
+bool Rdb_hll::unmaterialize(const uchar **ptr, const uchar *const end) {
+  enum { DENSE = 0, SPARSE = 1 };
+  const uchar *p = *ptr;
+  if (p + 2 > end || p[0] != PRECISION) {
+    return true;
+  }
+  const uchar format = p[1];
+  p += 2;
+
+  std::fill(m_registers.begin(), m_registers.end(), 0);
+  if (format == SPARSE) {
+    if (p + 2 > end) {
+      return true;
+    }
+    const uint16_t non_zero = rdb_netbuf_read_uint16(&p);
+    if (p + non_zero * 3 > end) {
+      return true;
+    }
+    for (uint16_t i = 0; i < non_zero; i++) {
+      const uint16_t index = rdb_netbuf_read_uint16(&p);
+      if (index >= NUM_REGISTERS) {
+        return true;
+      }
+      m_registers[index] = *p++;
+    }
+  } else if (format == DENSE) {
+    if (p + NUM_REGISTERS > end) {
+      return true;
+    }
+    memcpy(m_registers.data(), p, NUM_REGISTERS);
+    p += NUM_REGISTERS;
+  } else {
+    return true;
+  }
+
+  *ptr = p;
+  return false;
+}
+
+void Rdb_index_sketches::merge(const Rdb_index_sketches &s) {
+  m_gl_index_id = s.m_gl_index_id;
+  if (m_prefixes.size() < s.m_prefixes.size()) {
+    m_prefixes.resize(s.m_prefixes.size());
+  }
+  for (size_t i = 0; i < s.m_prefixes.size(); i++) {
+    m_prefixes[i].merge(s.m_prefixes[i]);
+  }
+}
+
+/*
+  Serializes an array of Rdb_index_sketches into a network string.
+*/
+std::string Rdb_index_sketches::materialize(
+    const std::vector<Rdb_index_sketches> &sketches) {
+  String ret;
+  rdb_netstr_append_uint16(&ret, INDEX_SKETCHES_VERSION_INITIAL);
+  for (const auto &i : sketches) {
+    rdb_netstr_append_uint32(&ret, i.m_gl_index_id.cf_id);
+    rdb_netstr_append_uint32(&ret, i.m_gl_index_id.index_id);
+    rdb_netstr_append_uint16(&ret, i.m_prefixes.size());
+    for (const auto &hll : i.m_prefixes) {
+      hll.materialize(&ret);
+    }
+  }
+
+  return std::string((char *)ret.ptr(), ret.length());
+}
+
+/**
+  @brief
+  Reads an array of Rdb_index_sketches from a string.
+  @return HA_EXIT_FAILURE if it detects any inconsistency in the input
+  @return HA_EXIT_SUCCESS if completes successfully
+*/
+int Rdb_index_sketches::unmaterialize(
+    const std::string &s, std::vector<Rdb_index_sketches> *const ret) {
+  const uchar *p = rdb_std_str_to_uchar_ptr(s);
+  const uchar *const p2 = p + s.size();
+
+  DBUG_ASSERT(ret != nullptr);
+
+  if (p + 2 > p2 ||
+      rdb_netbuf_read_uint16(&p) != INDEX_SKETCHES_VERSION_INITIAL) {
+    return HA_EXIT_FAILURE;
+  }
+
+  const size_t needed = sizeof(uint32) * 2 + sizeof(uint16);
+  while (p < p2) {
+    if (p + needed > p2) {
+      return HA_EXIT_FAILURE;
+    }
+    Rdb_index_sketches sketches;
+    rdb_netbuf_read_gl_index(&p, &sketches.m_gl_index_id);
+    sketches.m_prefixes.resize(rdb_netbuf_read_uint16(&p));
+    for (auto &hll : sketches.m_prefixes) {
+      if (hll.unmaterialize(&p, p2)) {
+        return HA_EXIT_FAILURE;
+      }
+    }
+    ret->push_back(std::move(sketches));
+  }
+  return HA_EXIT_SUCCESS;
+}
+
 }  // namespace myrocks
@@ -40,6 +40,7 @@ extern std::atomic<uint64_t> rocksdb_num_sst_entry_merge;
 extern std::atomic<uint64_t> rocksdb_num_sst_entry_other;
 extern std::atomic<uint64_t> rocksdb_additional_compaction_triggers;
 extern my_bool rocksdb_compaction_sequential_deletes_count_sd;
+extern my_bool rocksdb_table_stats_use_sketches;
 
 struct Rdb_compact_params {
   uint64_t m_deletes, m_window, m_file_size;
@@ -78,6 +79,8 @@ struct Rdb_index_stats {
   void adjust_cardinality(double adjustment_factor);
 
   void reset_cardinality();
+
+  void set_cardinality(const Rdb_index_sketches &sketches);
 };
 
 struct Rdb_table_stats {
@@ -103,6 +106,60 @@ struct Rdb_table_stats {
   }
 };
 
+/*
+  A HyperLogLog sketch estimating the number of distinct values added to it.
+  Unlike plain distinct counters, sketches built for different SST files can
+  be merged, so a key which is present in several files is counted once.
+*/
+class Rdb_hll {
+ public:
+  enum {
+    // 2^10 one-byte registers give a standard error of about 3.25%
+    PRECISION = 10,
+    NUM_REGISTERS = 1 << PRECISION,
+  };
+
+  Rdb_hll() : m_registers(NUM_REGISTERS, 0) {}
+
+  // Spread the bits of a (weak) hash value before it is added to a sketch
+  static uint64_t mix(uint64_t hash);
+
+  void add(const uint64_t hash);
+  void merge(const Rdb_hll &other);
+  uint64_t estimate() const;
+
+  void materialize(my_core::String *const out) const;
+  bool unmaterialize(const uchar **ptr, const uchar *const end);
+
+ private:
+  std::vector<uint8_t> m_registers;
+};
+
+/*
+  Distinct key prefix sketches of an index: m_prefixes[i] holds the sketch
+  of the prefixes made of the first i+1 key parts. They are kept in SST
+  properties next to Rdb_index_stats, but are not persisted in the data
+  dictionary.
+*/
+struct Rdb_index_sketches {
+  enum {
+    INDEX_SKETCHES_VERSION_INITIAL = 1,
+  };
+  GL_INDEX_ID m_gl_index_id;
+  std::vector<Rdb_hll> m_prefixes;
+
+  Rdb_index_sketches() : Rdb_index_sketches({0, 0}, 0) {}
+  Rdb_index_sketches(GL_INDEX_ID gl_index_id, const size_t key_parts)
+      : m_gl_index_id(gl_index_id), m_prefixes(key_parts) {}
+
+  void merge(const Rdb_index_sketches &s);
+
+  static std::string materialize(
+      const std::vector<Rdb_index_sketches> &sketches);
+  static int unmaterialize(const std::string &s,
+                           std::vector<Rdb_index_sketches> *const ret);
+};
+
 // The helper class to calculate index cardinality
 class Rdb_tbl_card_coll {
  public:
@@ -170,6 +227,10 @@ class Rdb_tbl_prop_coll : public rocksdb::TablePropertiesCollector {
       const std::shared_ptr<const rocksdb::TableProperties> &table_props,
       std::vector<Rdb_index_stats> *out_stats_vector);
 
+  static void read_sketches_from_tbl_props(
+      const std::shared_ptr<const rocksdb::TableProperties> &table_props,
+      std::vector<Rdb_index_sketches> *out_sketches_vector);
+
  private:
   static std::string GetReadableStats(const Rdb_index_stats &it);
   bool FilledWithDeletions() const;
@@ -180,6 +241,7 @@ class Rdb_tbl_prop_coll : public rocksdb::TablePropertiesCollector {
                           const uint64_t file_size);
   Rdb_index_stats *AccessStats(const rocksdb::Slice &key);
   void AdjustDeletedRows(rocksdb::EntryType type);
+  void AddKeyToSketches(const rocksdb::Slice &key);
 
  private:
   uint32_t m_cf_id;
@@ -189,6 +251,18 @@ class Rdb_tbl_prop_coll : public rocksdb::TablePropertiesCollector {
   Rdb_index_stats *m_last_stats;
   static const char *INDEXSTATS_KEY;
 
+  // distinct key prefix sketches, only built if enabled when the SST
+  // file was started
+  bool m_collect_sketches;
+  std::vector<Rdb_index_sketches> m_sketches;
+  Rdb_index_sketches *m_last_sketches;
+  static const char *INDEXSKETCHES_KEY;
+
+  // last key added to the sketches and where its key parts end
+  std::string m_last_sketch_key;
+  std::vector<size_t> m_last_sketch_key_parts;
+  std::vector<size_t> m_sketch_key_parts;
+
   // last added key
   std::string m_last_key;
 
@@ -0,0 +1,147 @@
+/*
+   Copyright (c) 2016-Present, Facebook, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA */
+
+/* This C++ file's header file */
+#include "./rdb_compact_filter.h"
+
+/* C++ system header files */
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace myrocks {
+
+Rdb_compact_filter_metadata rdb_compact_filter_metadata;
+
+std::shared_ptr<const Rdb_cf_index_metadata> Rdb_compact_filter_metadata::get(
+    const uint32_t cf_id) {
+  const Rdb_ddl_manager *const ddl_manager = rdb_get_ddl_manager();
+  const std::shared_ptr<const Rdb_ddl_snapshot> ddl_snapshot =
+      ddl_manager != nullptr ? ddl_manager->get_snapshot() : nullptr;
+  const uint64_t drop_version = m_drop_version.load(std::memory_order_acquire);
+
+  std::shared_ptr<const Rdb_version> version = std::atomic_load(&m_version);
+  if (!version || version->m_ddl_snapshot != ddl_snapshot ||
+      version->m_drop_version != drop_version) {
+    version = build_version(ddl_snapshot, drop_version);
+  }
+
+  const auto it = version->m_cfs.find(cf_id);
+  if (it == version->m_cfs.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+std::shared_ptr<const Rdb_compact_filter_metadata::Rdb_version>
+Rdb_compact_filter_metadata::build_version(
+    const std::shared_ptr<const Rdb_ddl_snapshot> &ddl_snapshot,
+    const uint64_t drop_version) {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+
+  // Another compaction may have rebuilt it while we were waiting
+  std::shared_ptr<const Rdb_version> version = std::atomic_load(&m_version);
+  if (version && version->m_ddl_snapshot == ddl_snapshot &&
+      version->m_drop_version == drop_version) {
+    return version;
+  }
+
+  if (!m_dropped_indexes_loaded) {
+    const Rdb_dict_manager *const dict_manager = rdb_get_dict_manager();
+    if (dict_manager != nullptr) {
+      dict_manager->get_ongoing_drop_indexes(&m_dropped_indexes);
+      m_dropped_indexes_loaded = true;
+    }
+  }
+
+  std::unordered_map<uint32_t, std::shared_ptr<Rdb_cf_index_metadata>> cfs;
+
+  if (ddl_snapshot) {
+    for (const auto &it : ddl_snapshot->m_keydefs) {
+      const Rdb_key_def &kd = *it.second;
+      auto &cf = cfs[it.first.cf_id];
+      if (!cf) {
+        cf = std::make_shared<Rdb_cf_index_metadata>();
+      }
+
+      Rdb_index_filter_info &info = cf->m_indexes[it.first.index_id];
+      info.m_index_type = kd.m_index_type;
+      info.m_ttl_duration = kd.m_ttl_duration;
+      info.m_ttl_offset = Rdb_key_def::has_index_flag(kd.m_index_flags_bitmap,
+                                                      Rdb_key_def::TTL_FLAG)
+                              ? kd.m_ttl_rec_offset
+                              : 0;
+    }
+  }
+
+  for (const auto &gl_index_id : m_dropped_indexes) {
+    auto &cf = cfs[gl_index_id.cf_id];
+    if (!cf) {
+      cf = std::make_shared<Rdb_cf_index_metadata>();
+    }
+    cf->m_indexes[gl_index_id.index_id].m_is_dropped = true;
+  }
+
+  const auto new_version = std::make_shared<Rdb_version>();
+  new_version->m_ddl_snapshot = ddl_snapshot;
+  new_version->m_drop_version = drop_version;
+  for (auto &it : cfs) {
+    new_version->m_cfs.emplace(it.first, std::move(it.second));
+  }
+
+  version = new_version;
+  std::atomic_store(&m_version, version);
+  return version;
+}
+
+void Rdb_compact_filter_metadata::set_dropped_indexes(
+    const std::unordered_set<GL_INDEX_ID> &gl_index_ids) {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_dropped_indexes_loaded && m_dropped_indexes == gl_index_ids) {
+    return;
+  }
+
+  m_dropped_indexes = gl_index_ids;
+  m_dropped_indexes_loaded = true;
+  m_drop_version.fetch_add(1, std::memory_order_release);
+}
+
+void Rdb_compact_filter_metadata::add_stats(
+    const std::unordered_map<GL_INDEX_ID, Rdb_compact_filter_index_stats>
+        &stats) {
+  const std::lock_guard<std::mutex> lock(m_stats_mutex);
+
+  for (const auto &it : stats) {
+    auto &dst = m_stats[it.first];
+    dst.m_rows_dropped += it.second.m_rows_dropped;
+    dst.m_rows_expired += it.second.m_rows_expired;
+  }
+}
+
+std::map<GL_INDEX_ID, Rdb_compact_filter_index_stats>
+Rdb_compact_filter_metadata::get_stats() {
+  const std::lock_guard<std::mutex> lock(m_stats_mutex);
+  return m_stats;
+}
+
+void Rdb_compact_filter_metadata::reset_stats() {
+  const std::lock_guard<std::mutex> lock(m_stats_mutex);
+  m_stats.clear();
+}
+
+}  // namespace myrocks
@@ -22,7 +22,13 @@
 
 /* C++ system header files */
 #include <time.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 /* RocksDB includes */
 #include "rocksdb/compaction_filter.h"
@@ -33,15 +39,102 @@
 
 namespace myrocks {
 
+/*
+  What the compaction filter needs to know about an index: whether it is
+  being dropped and, if it has TTL, where and for how long.
+*/
+struct Rdb_index_filter_info {
+  bool m_is_dropped = false;
+  uchar m_index_type = 0;
+  uint64 m_ttl_duration = 0;
+  uint32 m_ttl_offset = 0;
+};
+
+/* Immutable index metadata of one column family, keyed by index id */
+struct Rdb_cf_index_metadata {
+  std::unordered_map<uint32_t, Rdb_index_filter_info> m_indexes;
+};
+
+/* Rows removed by compaction filters for one index */
+struct Rdb_compact_filter_index_stats {
+  uint64 m_rows_dropped = 0;
+  uint64 m_rows_expired = 0;
+};
+
+/*
+  Versioned, immutable per column family index metadata handed to every
+  compaction filter at creation, so that Filter() does not look up the data
+  dictionary (and take its mutexes) from compaction threads.
+
+  A version is derived from the data dictionary snapshot of Rdb_ddl_manager
+  and from the set of indexes being dropped, which the drop index thread
+  reports through set_dropped_indexes(). It is rebuilt lazily when a filter
+  is created after either one changed. Indexes that are not in the current
+  version are looked up in the dictionary by the filter, as before.
+
+  Also accumulates the number of rows dropped and expired per index for
+  information_schema.ROCKSDB_COMPACTION_FILTER_STATS. The counters of an
+  index outlive it in the data dictionary, so that the rows removed after
+  a DROP TABLE stay visible, until rocksdb_reset_stats clears them.
+*/
+class Rdb_compact_filter_metadata {
+ public:
+  Rdb_compact_filter_metadata(const Rdb_compact_filter_metadata &) = delete;
+  Rdb_compact_filter_metadata &operator=(const Rdb_compact_filter_metadata &) =
+      delete;
+  Rdb_compact_filter_metadata() = default;
+
+  std::shared_ptr<const Rdb_cf_index_metadata> get(const uint32_t cf_id);
+
+  void set_dropped_indexes(const std::unordered_set<GL_INDEX_ID> &gl_index_ids);
+
+  void add_stats(
+      const std::unordered_map<GL_INDEX_ID, Rdb_compact_filter_index_stats>
+          &stats);
+  std::map<GL_INDEX_ID, Rdb_compact_filter_index_stats> get_stats();
+  void reset_stats();
+
+ private:
+  struct Rdb_version {
+    std::shared_ptr<const Rdb_ddl_snapshot> m_ddl_snapshot;
+    uint64_t m_drop_version = 0;
+    std::unordered_map<uint32_t, std::shared_ptr<const Rdb_cf_index_metadata>>
+        m_cfs;
+  };
+
+  std::shared_ptr<const Rdb_version> build_version(
+      const std::shared_ptr<const Rdb_ddl_snapshot> &ddl_snapshot,
+      const uint64_t drop_version);
+
+  // Current version, accessed with std::atomic_load/std::atomic_store
+  std::shared_ptr<const Rdb_version> m_version;
+
+  // Protects m_dropped_indexes and serializes rebuilding m_version
+  std::mutex m_mutex;
+  std::unordered_set<GL_INDEX_ID> m_dropped_indexes;
+  bool m_dropped_indexes_loaded = false;
+  std::atomic<uint64_t> m_drop_version{0};
+
+  std::mutex m_stats_mutex;
+  std::map<GL_INDEX_ID, Rdb_compact_filter_index_stats> m_stats;
+};
+
+extern Rdb_compact_filter_metadata rdb_compact_filter_metadata;
+
 class Rdb_compact_filter : public rocksdb::CompactionFilter {
  public:
   Rdb_compact_filter(const Rdb_compact_filter &) = delete;
   Rdb_compact_filter &operator=(const Rdb_compact_filter &) = delete;
 
-  explicit Rdb_compact_filter(uint32_t _cf_id) : m_cf_id(_cf_id) {}
+  Rdb_compact_filter(uint32_t _cf_id,
+                     std::shared_ptr<const Rdb_cf_index_metadata> metadata)
+      : m_cf_id(_cf_id), m_metadata(std::move(metadata)) {}
   ~Rdb_compact_filter() {
     // Increment stats by num expired at the end of compaction
     rdb_update_global_stats(ROWS_EXPIRED, m_num_expired);
+    if (!m_index_stats.empty()) {
+      rdb_compact_filter_metadata.add_stats(m_index_stats);
+    }
   }
 
   // keys are passed in sorted order within the same sst.
@@ -60,12 +153,24 @@ class Rdb_compact_filter : public rocksdb::CompactionFilter {
     DBUG_ASSERT(gl_index_id.index_id >= 1);
 
     if (gl_index_id != m_prev_index) {
-      m_should_delete =
-          rdb_get_dict_manager()->is_drop_index_ongoing(gl_index_id);
+      m_cur_stats = nullptr;
+
+      const Rdb_index_filter_info *const info =
+          find_index_info(gl_index_id.index_id);
+      if (info != nullptr) {
+        m_should_delete = info->m_is_dropped;
+      } else {
+        m_should_delete =
+            rdb_get_dict_manager()->is_drop_index_ongoing(gl_index_id);
+      }
 
       if (!m_should_delete) {
-        get_ttl_duration_and_offset(gl_index_id, &m_ttl_duration,
-                                    &m_ttl_offset);
+        if (info != nullptr) {
+          get_ttl_duration_and_offset(*info, &m_ttl_duration, &m_ttl_offset);
+        } else {
+          get_ttl_duration_and_offset(gl_index_id, &m_ttl_duration,
+                                      &m_ttl_offset);
+        }
 
         if (m_ttl_duration != 0 && m_snapshot_timestamp == 0) {
           /*
@@ -94,10 +199,12 @@ class Rdb_compact_filter : public rocksdb::CompactionFilter {
 
     if (m_should_delete) {
       m_num_deleted++;
+      get_cur_stats()->m_rows_dropped++;
       return true;
     } else if (m_ttl_duration > 0 &&
                should_filter_ttl_rec(key, existing_value)) {
       m_num_expired++;
+      get_cur_stats()->m_rows_expired++;
       return true;
     }
 
@@ -108,6 +215,36 @@ class Rdb_compact_filter : public rocksdb::CompactionFilter {
 
   virtual const char *Name() const override { return "Rdb_compact_filter"; }
 
+  const Rdb_index_filter_info *find_index_info(const uint32_t index_id) const {
+    if (!m_metadata) {
+      return nullptr;
+    }
+
+    const auto it = m_metadata->m_indexes.find(index_id);
+    return it != m_metadata->m_indexes.end() ? &it->second : nullptr;
+  }
+
+  void get_ttl_duration_and_offset(const Rdb_index_filter_info &info,
+                                   uint64 *ttl_duration,
+                                   uint32 *ttl_offset) const {
+    DBUG_ASSERT(ttl_duration != nullptr);
+    if (!rdb_is_ttl_enabled()) {
+      *ttl_duration = 0;
+      return;
+    }
+
+#ifndef DBUG_OFF
+    if (rdb_dbug_set_ttl_ignore_pk() &&
+        info.m_index_type == Rdb_key_def::INDEX_TYPE_PRIMARY) {
+      *ttl_duration = 0;
+      return;
+    }
+#endif
+
+    *ttl_duration = info.m_ttl_duration;
+    *ttl_offset = info.m_ttl_offset;
+  }
+
   void get_ttl_duration_and_offset(const GL_INDEX_ID &gl_index_id,
                                    uint64 *ttl_duration,
                                    uint32 *ttl_offset) const {
@@ -155,6 +292,13 @@ class Rdb_compact_filter : public rocksdb::CompactionFilter {
     }
   }
 
+  Rdb_compact_filter_index_stats *get_cur_stats() const {
+    if (m_cur_stats == nullptr) {
+      m_cur_stats = &m_index_stats[m_prev_index];
+    }
+    return m_cur_stats;
+  }
+
   bool should_filter_ttl_rec(const rocksdb::Slice &key,
                              const rocksdb::Slice &existing_value) const {
     uint64 ttl_timestamp;
@@ -182,6 +326,8 @@ class Rdb_compact_filter : public rocksdb::CompactionFilter {
  private:
   // Column family for this compaction filter
   const uint32_t m_cf_id;
+  // Index metadata of the column family when the filter was created
+  const std::shared_ptr<const Rdb_cf_index_metadata> m_metadata;
   // Index id of the previous record
   mutable GL_INDEX_ID m_prev_index = {0, 0};
   // Number of rows deleted for the same index id
@@ -196,6 +342,12 @@ class Rdb_compact_filter : public rocksdb::CompactionFilter {
   mutable uint32 m_ttl_offset = 0;
   // Oldest snapshot timestamp at the time a TTL index is discovered
   mutable uint64_t m_snapshot_timestamp = 0;
+  // Rows dropped and expired per index, merged into
+  // rdb_compact_filter_metadata at the end of compaction
+  mutable std::unordered_map<GL_INDEX_ID, Rdb_compact_filter_index_stats>
+      m_index_stats;
+  // Entry of m_index_stats for the current index id, set on first use
+  mutable Rdb_compact_filter_index_stats *m_cur_stats = nullptr;
 };
 
 class Rdb_compact_filter_factory : public rocksdb::CompactionFilterFactory {
@@ -211,8 +363,9 @@ class Rdb_compact_filter_factory : public rocksdb::CompactionFilterFactory {
 
   std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
       const rocksdb::CompactionFilter::Context &context) override {
-    return std::unique_ptr<rocksdb::CompactionFilter>(
-        new Rdb_compact_filter(context.column_family_id));
+    return std::unique_ptr<rocksdb::CompactionFilter>(new Rdb_compact_filter(
+        context.column_family_id,
+        rdb_compact_filter_metadata.get(context.column_family_id)));
   }
 };
 
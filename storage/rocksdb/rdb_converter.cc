@@ -305,6 +305,8 @@ Rdb_converter::Rdb_converter(const THD *thd, const Rdb_tbl_def *tbl_def,
   m_maybe_unpack_info = false;
   m_row_checksums_checked = 0;
   m_null_bytes = nullptr;
+  m_fixed_fields = false;
+  m_fixed_fields_length = 0;
   setup_field_encoders();
   m_lookup_bitmap = {nullptr, 0, 0, nullptr, nullptr};
 }
@@ -399,12 +401,57 @@ void Rdb_converter::setup_field_decoders(const MY_BITMAP *field_map,
   m_decoders_vect.erase(m_decoders_vect.begin() + last_useful,
                         m_decoders_vect.end());
 
+  setup_fixed_field_runs();
+
   if (!keyread_only && active_index != m_table->s->primary_key) {
     m_tbl_def->m_key_descr_arr[active_index]->get_lookup_bitmap(
         m_table, &m_lookup_bitmap);
   }
 }
 
+/*
+  Flatten m_decoders_vect into runs of memcpy if the requested fields, and
+  all the fields before them in the value slice, are fixed-width and NOT
+  NULL. This is the common case for scans of tables with numeric columns,
+  and saves the per-field dispatch in Rdb_value_field_iterator.
+*/
+void Rdb_converter::setup_fixed_field_runs() {
+  m_fixed_fields = false;
+  m_fixed_field_runs.clear();
+  m_fixed_fields_length = 0;
+
+  uint value_offset = 0;
+  for (const auto &decoder : m_decoders_vect) {
+    const Rdb_field_encoder *const field_enc = decoder.m_field_enc;
+    if (field_enc->uses_variable_len_encoding() || field_enc->maybe_null()) {
+      // The position of the fields after this one varies by row
+      m_fixed_field_runs.clear();
+      return;
+    }
+
+    value_offset += decoder.m_skip;
+    const uint length = field_enc->m_field_pack_length;
+    if (decoder.m_decode) {
+      const uint record_offset = static_cast<uint>(field_enc->m_field_offset);
+      if (!m_fixed_field_runs.empty()) {
+        READ_FIELD_RUN &last = m_fixed_field_runs.back();
+        if (last.m_value_offset + last.m_length == value_offset &&
+            last.m_record_offset + last.m_length == record_offset) {
+          // Adjacent in both the value slice and the record
+          last.m_length += length;
+          value_offset += length;
+          continue;
+        }
+      }
+      m_fixed_field_runs.push_back({value_offset, record_offset, length});
+    }
+    value_offset += length;
+  }
+
+  m_fixed_fields = true;
+  m_fixed_fields_length = value_offset;
+}
+
 void Rdb_converter::setup_field_encoders() {
   uint null_bytes_length = 0;
   uchar cur_null_mask = 0x1;
@@ -620,16 +667,23 @@ int Rdb_converter::convert_record_from_storage_format(
     return HA_EXIT_SUCCESS;
   }
 
-  Rdb_value_field_iterator<Rdb_convert_to_record_value_decoder, uchar *>
-      value_field_iterator(m_table, &value_slice_reader, this, dst);
-
-  // Decode value slices
-  while (!value_field_iterator.end_of_fields()) {
-    err = value_field_iterator.next();
-
+  if (m_fixed_fields) {
+    err = decode_fixed_field_runs(&value_slice_reader, dst);
     if (err != HA_EXIT_SUCCESS) {
       return err;
     }
+  } else {
+    Rdb_value_field_iterator<Rdb_convert_to_record_value_decoder, uchar *>
+        value_field_iterator(m_table, &value_slice_reader, this, dst);
+
+    // Decode value slices
+    while (!value_field_iterator.end_of_fields()) {
+      err = value_field_iterator.next();
+
+      if (err != HA_EXIT_SUCCESS) {
+        return err;
+      }
+    }
   }
 
   if (m_verify_row_debug_checksums) {
@@ -639,6 +693,32 @@ int Rdb_converter::convert_record_from_storage_format(
   return HA_EXIT_SUCCESS;
 }
 
+/*
+  Decode the value slice fields described by m_fixed_field_runs
+  @param      reader   IN     RocksDB value slice reader, positioned at the
+                              first field
+  @param      dst      OUT    MySql format address
+  @return
+    0      OK
+    other  HA_ERR error code (can be SE-specific)
+*/
+int Rdb_converter::decode_fixed_field_runs(Rdb_string_reader *reader,
+                                           uchar *const dst) {
+  DBUG_ASSERT(m_fixed_fields);
+
+  const char *fields;
+  if (!(fields = reader->read(m_fixed_fields_length))) {
+    return HA_ERR_ROCKSDB_CORRUPT_DATA;
+  }
+
+  for (const auto &run : m_fixed_field_runs) {
+    memcpy(dst + run.m_record_offset, fields + run.m_value_offset,
+           run.m_length);
+  }
+
+  return HA_EXIT_SUCCESS;
+}
+
 /*
   Verify checksum for row
   @param      pk_def   IN     key def
@@ -47,6 +47,18 @@ struct READ_FIELD {
   int m_skip;
 };
 
+/**
+  Describes a run of adjacent fixed-width fields that are copied from the
+  value slice into the record with a single memcpy
+*/
+struct READ_FIELD_RUN {
+  // Offset of the run from the first field in the value slice
+  uint m_value_offset;
+  // Offset of the run in the record
+  uint m_record_offset;
+  uint m_length;
+};
+
 /**
  Class to convert rocksdb value slice from storage format to mysql record
  format.
@@ -185,6 +197,10 @@ class Rdb_converter {
 
   void get_storage_type(Rdb_field_encoder *const encoder, const uint kp);
 
+  void setup_fixed_field_runs();
+
+  int decode_fixed_field_runs(Rdb_string_reader *reader, uchar *const dst);
+
   int convert_record_from_storage_format(
       const std::shared_ptr<Rdb_key_def> &pk_def,
       const rocksdb::Slice *const key, const rocksdb::Slice *const value,
@@ -238,6 +254,15 @@ class Rdb_converter {
     Array of request fields telling how to decode data in RocksDB format
   */
   std::vector<READ_FIELD> m_decoders_vect;
+  /*
+    TRUE <=> every field in m_decoders_vect is fixed-width and NOT NULL, so
+    the fields sit at the same offsets of every value slice. They are then
+    decoded by copying m_fixed_field_runs out of the first
+    m_fixed_fields_length bytes, rather than field by field.
+  */
+  bool m_fixed_fields;
+  std::vector<READ_FIELD_RUN> m_fixed_field_runs;
+  uint m_fixed_fields_length;
   /*
     A counter of how many row checksums were checked for this table. Note that
     this does not include checksums for secondary index entries.
@@ -278,6 +278,7 @@ Rdb_key_def::Rdb_key_def(
       m_partial_index_keyparts(0),
       m_partial_index_threshold(0),
       m_prefix_extractor(nullptr),
+      m_integer_key(false),
       m_maxlength(0)  // means 'not intialized'
 {
   mysql_mutex_init(0, &m_mutex, MY_MUTEX_INIT_FAST);
@@ -313,6 +314,7 @@ Rdb_key_def::Rdb_key_def(const Rdb_key_def &k)
       m_partial_index_keyparts(k.m_partial_index_keyparts),
       m_partial_index_threshold(k.m_partial_index_threshold),
       m_prefix_extractor(k.m_prefix_extractor),
+      m_integer_key(k.m_integer_key),
       m_maxlength(k.m_maxlength) {
   mysql_mutex_init(0, &m_mutex, MY_MUTEX_INIT_FAST);
   rdb_netbuf_store_index(m_index_number_storage_form, m_index_number);
@@ -531,6 +533,14 @@ void Rdb_key_def::setup(const TABLE *const tbl,
 
     m_key_parts = dst_i;
 
+#if !defined(WORDS_BIGENDIAN)
+    m_integer_key = !hidden_pk_exists;
+    for (uint i = 0; i < m_key_parts && m_integer_key; i++) {
+      m_integer_key = m_pack_info[i].is_integer() &&
+                      !m_pack_info[i].m_field_maybe_null;
+    }
+#endif
+
     /* Initialize the memory needed by the stats structure */
     m_stats.m_distinct_keys_per_prefix.resize(get_key_parts());
 
@@ -1386,6 +1396,13 @@ uint Rdb_key_def::pack_record(const TABLE *const tbl, uchar *const pack_buffer,
       break;
     }
 
+    if (m_integer_key) {
+      // Integers are never NULL here, need no unpack_info and are always
+      // covered
+      m_pack_info[i].pack_integer_from(record, &tuple);
+      continue;
+    }
+
     Field *const field = m_pack_info[i].get_field_in_table(tbl);
     DBUG_ASSERT(field != nullptr);
 
@@ -1515,6 +1532,77 @@ void Rdb_key_def::pack_with_make_sort_key(
   *dst += max_len;
 }
 
+/*
+  Mem-comparable form of an integer stored in little-endian in the record:
+  big-endian with the sign bit flipped, the same as Field_*::make_sort_key
+*/
+template <int length>
+static inline void rdb_pack_integer(const uchar *const from, uchar *const to,
+                                    const bool unsigned_flag) {
+  if (unsigned_flag) {
+    to[0] = from[length - 1];
+  } else {
+    to[0] = static_cast<uchar>(from[length - 1] ^ 128);  // Reverse sign bit
+  }
+
+  /* Parameterized length should enable loop unrolling */
+  for (int i = 1, j = length - 2; i < length; ++i, --j) to[i] = from[j];
+}
+
+/*
+  Function of type rdb_index_field_pack_t
+*/
+template <int length>
+void Rdb_key_def::pack_integer(
+    Rdb_field_packing *const fpi, Field *const field,
+    uchar *const buf MY_ATTRIBUTE((__unused__)), uchar **dst,
+    Rdb_pack_field_context *const pack_ctx MY_ATTRIBUTE((__unused__))) {
+  DBUG_ASSERT(fpi != nullptr);
+  DBUG_ASSERT(field != nullptr);
+  DBUG_ASSERT(dst != nullptr);
+  DBUG_ASSERT(*dst != nullptr);
+  DBUG_ASSERT(length == fpi->m_max_image_len);
+
+#ifdef WORDS_BIGENDIAN
+  field->make_sort_key(*dst, length);
+#else
+  rdb_pack_integer<length>(field->ptr, *dst, fpi->m_field_unsigned_flag);
+#endif
+  *dst += length;
+}
+
+/*
+  Pack this integer key part of the given record, see
+  Rdb_key_def::m_integer_key
+*/
+void Rdb_field_packing::pack_integer_from(const uchar *const record,
+                                          uchar **dst) const {
+  DBUG_ASSERT(is_integer());
+  DBUG_ASSERT(!m_field_maybe_null);
+
+  const uchar *const from = record + m_field_offset;
+  switch (m_max_image_len) {
+    case 8:
+      rdb_pack_integer<8>(from, *dst, m_field_unsigned_flag);
+      break;
+    case 4:
+      rdb_pack_integer<4>(from, *dst, m_field_unsigned_flag);
+      break;
+    case 3:
+      rdb_pack_integer<3>(from, *dst, m_field_unsigned_flag);
+      break;
+    case 2:
+      rdb_pack_integer<2>(from, *dst, m_field_unsigned_flag);
+      break;
+    case 1:
+      rdb_pack_integer<1>(from, *dst, m_field_unsigned_flag);
+      break;
+    default:
+      DBUG_ASSERT(0);
+  }
+  *dst += m_max_image_len;
+}
+
 /*
   Compares two keys without unpacking
 
@@ -1595,6 +1683,51 @@ int Rdb_key_def::compare_keys(const rocksdb::Slice *key1,
   return HA_EXIT_SUCCESS;
 }
 
+/*
+  @brief
+    Find where each key part of a mem-comparable key ends
+
+  @param key   Key, starting with the index number
+  @param ends  OUT (*ends)[i] is the length of the key prefix which holds
+               the index number and the first i+1 key parts
+
+  @return
+    HA_EXIT_SUCCESS, or HA_EXIT_FAILURE if the key could not be parsed
+*/
+int Rdb_key_def::get_key_part_ends(const rocksdb::Slice *key,
+                                   std::vector<std::size_t> *const ends) const {
+  DBUG_ASSERT(key != nullptr);
+  DBUG_ASSERT(ends != nullptr);
+
+  ends->clear();
+  Rdb_string_reader reader(key);
+
+  // Skip the index number
+  if (!reader.read(INDEX_NUMBER_SIZE)) return HA_EXIT_FAILURE;
+
+  for (uint i = 0; i < m_key_parts; i++) {
+    const Rdb_field_packing *const fpi = &m_pack_info[i];
+    bool is_null = false;
+    if (fpi->m_field_maybe_null) {
+      const auto nullp = reader.read(1);
+      if (nullp == nullptr) {
+        return HA_EXIT_FAILURE;
+      }
+      is_null = (*nullp == 0);
+    }
+
+    if (!is_null) {
+      DBUG_ASSERT(fpi->m_skip_func);
+      if ((fpi->m_skip_func)(fpi, &reader)) {
+        return HA_EXIT_FAILURE;
+      }
+    }
+    ends->push_back(reader.get_current_ptr() - key->data());
+  }
+
+  return HA_EXIT_SUCCESS;
+}
+
 /*
   @brief
     Given a zero-padded key, determine its real key length
@@ -3267,6 +3400,7 @@ bool Rdb_field_packing::setup(const Rdb_key_def *const key_descr,
     case MYSQL_TYPE_LONGLONG:
       m_field_unsigned_flag =
           field ? static_cast<const Field_num *>(field)->unsigned_flag : false;
+      m_pack_func = Rdb_key_def::pack_integer<8>;
       m_unpack_func = Rdb_key_def::unpack_integer<8>;
       m_covered = true;
       return true;
@@ -3274,6 +3408,7 @@ bool Rdb_field_packing::setup(const Rdb_key_def *const key_descr,
     case MYSQL_TYPE_LONG:
       m_field_unsigned_flag =
           field ? static_cast<const Field_num *>(field)->unsigned_flag : false;
+      m_pack_func = Rdb_key_def::pack_integer<4>;
       m_unpack_func = Rdb_key_def::unpack_integer<4>;
       m_covered = true;
       return true;
@@ -3281,6 +3416,7 @@ bool Rdb_field_packing::setup(const Rdb_key_def *const key_descr,
     case MYSQL_TYPE_INT24:
       m_field_unsigned_flag =
           field ? static_cast<const Field_num *>(field)->unsigned_flag : false;
+      m_pack_func = Rdb_key_def::pack_integer<3>;
       m_unpack_func = Rdb_key_def::unpack_integer<3>;
       m_covered = true;
       return true;
@@ -3288,6 +3424,7 @@ bool Rdb_field_packing::setup(const Rdb_key_def *const key_descr,
     case MYSQL_TYPE_SHORT:
       m_field_unsigned_flag =
           field ? static_cast<const Field_num *>(field)->unsigned_flag : false;
+      m_pack_func = Rdb_key_def::pack_integer<2>;
       m_unpack_func = Rdb_key_def::unpack_integer<2>;
       m_covered = true;
       return true;
@@ -3295,6 +3432,7 @@ bool Rdb_field_packing::setup(const Rdb_key_def *const key_descr,
     case MYSQL_TYPE_TINY:
       m_field_unsigned_flag =
           field ? static_cast<const Field_num *>(field)->unsigned_flag : false;
+      m_pack_func = Rdb_key_def::pack_integer<1>;
       m_unpack_func = Rdb_key_def::unpack_integer<1>;
       m_covered = true;
       return true;
@@ -3577,6 +3715,33 @@ Rdb_tbl_def::~Rdb_tbl_def() {
   }
 }
 
+std::shared_ptr<const select_bypass_plan> Rdb_tbl_def::find_bypass_plan(
+    const std::string &digest) {
+  const std::lock_guard<std::mutex> lock(m_bypass_plans_mutex);
+  const auto it = m_bypass_plans.find(digest);
+  if (it == m_bypass_plans.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void Rdb_tbl_def::add_bypass_plan(
+    const std::string &digest,
+    const std::shared_ptr<const select_bypass_plan> &plan,
+    const size_t max_plans) {
+  const std::lock_guard<std::mutex> lock(m_bypass_plans_mutex);
+  if (m_bypass_plans.size() >= max_plans) {
+    // Keep the plans we already have rather than evicting them
+    return;
+  }
+  m_bypass_plans.emplace(digest, plan);
+}
+
+void Rdb_tbl_def::clear_bypass_plans() {
+  const std::lock_guard<std::mutex> lock(m_bypass_plans_mutex);
+  m_bypass_plans.clear();
+}
+
 /*
   Put table definition DDL entry. Actual write is done at
   Rdb_dict_manager::commit.
@@ -3763,6 +3928,7 @@ void Rdb_ddl_manager::add_uncommitted_keydefs(
   for (const auto &index : indexes) {
     m_index_num_to_uncommitted_keydef[index->get_gl_index_id()] = index;
   }
+  publish_snapshot();
   mysql_rwlock_unlock(&m_rwlock);
 }
 
@@ -3772,6 +3938,7 @@ void Rdb_ddl_manager::remove_uncommitted_keydefs(
   for (const auto &index : indexes) {
     m_index_num_to_uncommitted_keydef.erase(index->get_gl_index_id());
   }
+  publish_snapshot();
   mysql_rwlock_unlock(&m_rwlock);
 }
 
@@ -4084,6 +4251,7 @@ bool Rdb_ddl_manager::init(Rdb_dict_manager *const dict_arg,
   m_dict = dict_arg;
   m_cf_manager = cf_manager;
   mysql_rwlock_init(0, &m_rwlock);
+  mysql_mutex_init(0, &m_stats_mutex, MY_MUTEX_INIT_FAST);
 
   /* Read the data dictionary and populate the hash */
   uchar ddl_entry[Rdb_key_def::INDEX_NUMBER_SIZE];
@@ -4213,10 +4381,14 @@ bool Rdb_ddl_manager::init(Rdb_dict_manager *const dict_arg,
         tdef->m_key_count > 0 ? tdef->m_key_descr_arr[0]->m_stats.m_rows : 0, 0,
         0);
 
-    put(tdef);
+    // No readers exist yet; the snapshot is published once all tables are
+    // loaded.
+    put(tdef, false);
     i++;
   }
 
+  publish_snapshot();
+
   /*
     If validate_tables is greater than 0 run the validation.  Only fail the
     initialzation if the setting is 1.  If the setting is 2 we continue.
@@ -4258,10 +4430,21 @@ bool Rdb_ddl_manager::init(Rdb_dict_manager *const dict_arg,
   return false;
 }
 
+/*
+  With lock=true the lookup goes to the published snapshot and does not
+  touch m_rwlock. Callers already holding m_rwlock pass lock=false and see
+  the live map, including changes not yet published.
+*/
 Rdb_tbl_def *Rdb_ddl_manager::find(const std::string &table_name,
                                    const bool lock) {
   if (lock) {
-    mysql_rwlock_rdlock(&m_rwlock);
+    const auto snapshot = get_snapshot();
+    if (!snapshot) {
+      return nullptr;
+    }
+
+    const auto it = snapshot->m_tables.find(table_name);
+    return it != snapshot->m_tables.end() ? it->second : nullptr;
   }
 
   Rdb_tbl_def *rec = nullptr;
@@ -4270,10 +4453,6 @@ Rdb_tbl_def *Rdb_ddl_manager::find(const std::string &table_name,
     rec = it->second;
   }
 
-  if (lock) {
-    mysql_rwlock_unlock(&m_rwlock);
-  }
-
   return rec;
 }
 
@@ -4323,63 +4502,60 @@ int Rdb_ddl_manager::find_table_stats(const std::string &table_name,
   return HA_EXIT_SUCCESS;
 }
 
-// this is a safe version of the find() function below.  It acquires a read
-// lock on m_rwlock to make sure the Rdb_key_def is not discarded while we
-// are finding it.  Copying it into 'ret' increments the count making sure
-// that the object will not be discarded until we are finished with it.
+// this finds a key definition by index id.  It searches the
+// published snapshot, which holds a reference to every Rdb_key_def it maps,
+// so the Rdb_key_def cannot be discarded while we are finding it.  Copying
+// it into 'ret' increments the count making sure that the object will not be
+// discarded until we are finished with it.  No lock on m_rwlock is taken, so
+// compaction and flush threads never wait behind DDL.
 std::shared_ptr<const Rdb_key_def> Rdb_ddl_manager::safe_find(
     GL_INDEX_ID gl_index_id) {
   std::shared_ptr<const Rdb_key_def> ret(nullptr);
 
-  mysql_rwlock_rdlock(&m_rwlock);
+  const auto snapshot = get_snapshot();
+  if (!snapshot) {
+    return ret;
+  }
 
-  const auto it = m_index_num_to_keydef.find(gl_index_id);
-  if (it != m_index_num_to_keydef.end()) {
-    const auto table_def = find(it->second.first, false);
-    if (table_def && it->second.second < table_def->m_key_count) {
-      const auto &kd = table_def->m_key_descr_arr[it->second.second];
-      if (kd->max_storage_fmt_length() != 0) {
-        ret = kd;
-      }
-    }
-  } else {
-    const auto uncommitted_it =
-        m_index_num_to_uncommitted_keydef.find(gl_index_id);
-    if (uncommitted_it != m_index_num_to_uncommitted_keydef.end()) {
-      const auto &kd = uncommitted_it->second;
-      if (kd->max_storage_fmt_length() != 0) {
-        ret = kd;
-      }
+  const auto it = snapshot->m_keydefs.find(gl_index_id);
+  if (it != snapshot->m_keydefs.end()) {
+    const auto &kd = it->second;
+    if (kd->max_storage_fmt_length() != 0) {
+      ret = kd;
     }
   }
 
-  mysql_rwlock_unlock(&m_rwlock);
-
   return ret;
 }
 
-// this method assumes at least read-only lock on m_rwlock
-const std::shared_ptr<Rdb_key_def> &Rdb_ddl_manager::find(
-    GL_INDEX_ID gl_index_id) {
-  const auto it = m_index_num_to_keydef.find(gl_index_id);
-  if (it != m_index_num_to_keydef.end()) {
-    const auto table_def = find(it->second.first, false);
-    if (table_def) {
-      if (it->second.second < table_def->m_key_count) {
-        return table_def->m_key_descr_arr[it->second.second];
+// this method builds a new snapshot from m_ddl_map, m_index_num_to_keydef and
+// m_index_num_to_uncommitted_keydef and makes it visible to readers. It
+// gives committed key definitions precedence over uncommitted ones.
+void Rdb_ddl_manager::publish_snapshot() {
+  const auto snapshot = std::make_shared<Rdb_ddl_snapshot>();
+
+  snapshot->m_tables = m_ddl_map;
+  snapshot->m_keydefs.reserve(m_index_num_to_keydef.size() +
+                              m_index_num_to_uncommitted_keydef.size());
+
+  for (const auto &it : m_index_num_to_keydef) {
+    const auto table_def = find(it.second.first, false);
+    if (table_def && it.second.second < table_def->m_key_count) {
+      const auto &kd = table_def->m_key_descr_arr[it.second.second];
+      if (kd) {
+        snapshot->m_keydefs.emplace(it.first, kd);
       }
     }
-  } else {
-    const auto uncommitted_it =
-        m_index_num_to_uncommitted_keydef.find(gl_index_id);
-    if (uncommitted_it != m_index_num_to_uncommitted_keydef.end()) {
-      return uncommitted_it->second;
-    }
   }
 
-  static std::shared_ptr<Rdb_key_def> empty = nullptr;
+  for (const auto &it : m_index_num_to_uncommitted_keydef) {
+    if (m_index_num_to_keydef.find(it.first) == m_index_num_to_keydef.end()) {
+      snapshot->m_keydefs.emplace(it.first, it.second);
+    }
+  }
 
-  return empty;
+  std::atomic_store(&m_snapshot,
+                    std::shared_ptr<const Rdb_ddl_snapshot>(snapshot));
 }
 
 // this method returns the name of the table based on an index id. It acquires
@@ -4398,26 +4574,38 @@ const std::string Rdb_ddl_manager::safe_get_table_name(
 
 void Rdb_ddl_manager::set_stats(
     const std::unordered_map<GL_INDEX_ID, Rdb_index_stats> &stats) {
-  mysql_rwlock_wrlock(&m_rwlock);
+  const auto snapshot = get_snapshot();
+  if (!snapshot) {
+    return;
+  }
+
+  RDB_MUTEX_LOCK_CHECK(m_stats_mutex);
   for (const auto &src : stats) {
-    const auto &keydef = find(src.second.m_gl_index_id);
-    if (keydef) {
+    const auto it = snapshot->m_keydefs.find(src.second.m_gl_index_id);
+    if (it != snapshot->m_keydefs.end()) {
+      const auto &keydef = it->second;
       keydef->m_stats = src.second;
       m_stats2store[keydef->m_stats.m_gl_index_id] = keydef->m_stats;
     }
   }
-  mysql_rwlock_unlock(&m_rwlock);
+  RDB_MUTEX_UNLOCK_CHECK(m_stats_mutex);
 }
 
 void Rdb_ddl_manager::adjust_stats(
     const std::vector<Rdb_index_stats> &new_data,
     const std::vector<Rdb_index_stats> &deleted_data) {
-  mysql_rwlock_wrlock(&m_rwlock);
+  const auto snapshot = get_snapshot();
+  if (!snapshot) {
+    return;
+  }
+
+  RDB_MUTEX_LOCK_CHECK(m_stats_mutex);
   int i = 0;
   for (const auto &data : {new_data, deleted_data}) {
     for (const auto &src : data) {
-      const auto &keydef = find(src.m_gl_index_id);
-      if (keydef) {
+      const auto it = snapshot->m_keydefs.find(src.m_gl_index_id);
+      if (it != snapshot->m_keydefs.end()) {
+        const auto &keydef = it->second;
         keydef->m_stats.m_distinct_keys_per_prefix.resize(
             keydef->get_key_parts());
         keydef->m_stats.merge(src, i == 0, keydef->max_storage_fmt_length());
@@ -4427,7 +4615,7 @@ void Rdb_ddl_manager::adjust_stats(
     i++;
   }
   const bool should_save_stats = !m_stats2store.empty();
-  mysql_rwlock_unlock(&m_rwlock);
+  RDB_MUTEX_UNLOCK_CHECK(m_stats_mutex);
   if (should_save_stats) {
     // Queue an async persist_stats(false) call to the background thread.
     rdb_queue_save_stats_request();
@@ -4435,10 +4623,10 @@ void Rdb_ddl_manager::adjust_stats(
 }
 
 void Rdb_ddl_manager::persist_stats(const bool sync) {
-  mysql_rwlock_wrlock(&m_rwlock);
+  RDB_MUTEX_LOCK_CHECK(m_stats_mutex);
   const auto local_stats2store = std::move(m_stats2store);
   m_stats2store.clear();
-  mysql_rwlock_unlock(&m_rwlock);
+  RDB_MUTEX_UNLOCK_CHECK(m_stats_mutex);
 
   // Persist stats
   const std::unique_ptr<rocksdb::WriteBatch> wb = m_dict->begin();
@@ -4462,10 +4650,12 @@ void Rdb_ddl_manager::set_table_stats(const std::string &tbl_name) {
     DBUG_ASSERT(tbl_def->m_key_count > 0);
     // Take the number of rows of the first index as the number of rows of
     // the table. This is an estimated value.
-    tbl_def->m_tbl_stats.set(tbl_def->m_key_count > 0
-                                 ? tbl_def->m_key_descr_arr[0]->m_stats.m_rows
-                                 : 0,
-                             0, ts.tv_sec);
+    RDB_MUTEX_LOCK_CHECK(m_stats_mutex);
+    const int64_t rows = tbl_def->m_key_count > 0
+                             ? tbl_def->m_key_descr_arr[0]->m_stats.m_rows
+                             : 0;
+    RDB_MUTEX_UNLOCK_CHECK(m_stats_mutex);
+    tbl_def->m_tbl_stats.set(rows, 0, ts.tv_sec);
   }
   mysql_rwlock_unlock(&m_rwlock);
 }
@@ -4524,7 +4714,10 @@ int Rdb_ddl_manager::put(Rdb_tbl_def *const tbl, const bool lock) {
   }
   tbl->check_and_set_read_free_rpl_table();
 
-  if (lock) mysql_rwlock_unlock(&m_rwlock);
+  if (lock) {
+    publish_snapshot();
+    mysql_rwlock_unlock(&m_rwlock);
+  }
   return 0;
 }
 
@@ -4548,7 +4741,10 @@ void Rdb_ddl_manager::remove(Rdb_tbl_def *const tbl,
     m_ddl_map.erase(it);
   }
 
-  if (lock) mysql_rwlock_unlock(&m_rwlock);
+  if (lock) {
+    publish_snapshot();
+    mysql_rwlock_unlock(&m_rwlock);
+  }
 }
 
 bool Rdb_ddl_manager::rename(const std::string &from, const std::string &to,
@@ -4590,6 +4786,7 @@ bool Rdb_ddl_manager::rename(const std::string &from, const std::string &to,
                          new_buf_writer.to_slice())) {
     remove(rec, batch, false);
     put(new_rec, false);
+    publish_snapshot();
     res = false;  // ok
   }
 
@@ -4597,13 +4794,23 @@ bool Rdb_ddl_manager::rename(const std::string &from, const std::string &to,
   return res;
 }
 
+void Rdb_ddl_manager::clear_bypass_plans() {
+  mysql_rwlock_rdlock(&m_rwlock);
+  for (const auto &kv : m_ddl_map) {
+    kv.second->clear_bypass_plans();
+  }
+  mysql_rwlock_unlock(&m_rwlock);
+}
+
 void Rdb_ddl_manager::cleanup() {
   for (const auto &kv : m_ddl_map) {
     delete kv.second;
   }
   m_ddl_map.clear();
+  std::atomic_store(&m_snapshot, std::shared_ptr<const Rdb_ddl_snapshot>());
 
   mysql_rwlock_destroy(&m_rwlock);
+  mysql_mutex_destroy(&m_stats_mutex);
   m_sequence.cleanup();
 }
 
@@ -20,6 +20,7 @@
 #include <atomic>
 #include <boost/optional.hpp>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
@@ -266,6 +267,8 @@ class Rdb_key_def {
   static bool unpack_info_has_checksum(const rocksdb::Slice &unpack_info);
   int compare_keys(const rocksdb::Slice *key1, const rocksdb::Slice *key2,
                    std::size_t *const column_index) const;
+  int get_key_part_ends(const rocksdb::Slice *key,
+                        std::vector<std::size_t> *const ends) const;
 
   size_t key_length(const TABLE *const table, const rocksdb::Slice &key) const;
 
@@ -639,6 +642,12 @@ class Rdb_key_def {
       uchar *buf MY_ATTRIBUTE((__unused__)), uchar **dst,
       Rdb_pack_field_context *const pack_ctx MY_ATTRIBUTE((__unused__)));
 
+  template <int length>
+  static void pack_integer(
+      Rdb_field_packing *const fpi, Field *const field,
+      uchar *buf MY_ATTRIBUTE((__unused__)), uchar **dst,
+      Rdb_pack_field_context *const pack_ctx MY_ATTRIBUTE((__unused__)));
+
   static void pack_with_varchar_encoding(
       Rdb_field_packing *const fpi, Field *const field, uchar *buf, uchar **dst,
       Rdb_pack_field_context *const pack_ctx MY_ATTRIBUTE((__unused__)));
@@ -850,6 +859,12 @@ class Rdb_key_def {
   /* Prefix extractor for the column family of the key definiton */
   std::shared_ptr<const rocksdb::SliceTransform> m_prefix_extractor;
 
+  /*
+    TRUE <=> every key part is a NOT NULL integer column. pack_record() then
+    packs them straight out of the record, without going through Field.
+  */
+  bool m_integer_key;
+
   /* Maximum length of the mem-comparable form. */
   uint m_maxlength;
 
@@ -949,6 +964,18 @@ class Rdb_field_packing {
   */
   bool uses_unpack_info() const { return (m_make_unpack_info_func != nullptr); }
 
+  /* TRUE means this is an integer column of a real (not hidden) key */
+  bool is_integer() const {
+    return m_field_offset != -1 &&
+           (m_field_real_type == MYSQL_TYPE_LONGLONG ||
+            m_field_real_type == MYSQL_TYPE_LONG ||
+            m_field_real_type == MYSQL_TYPE_INT24 ||
+            m_field_real_type == MYSQL_TYPE_SHORT ||
+            m_field_real_type == MYSQL_TYPE_TINY);
+  }
+
+  void pack_integer_from(const uchar *const record, uchar **dst) const;
+
   /* TRUE means unpack_info stores the original field value */
   bool m_unpack_info_stores_value;
 
@@ -1067,6 +1094,8 @@ inline bool Rdb_key_def::has_unpack_info(const uint kp) const {
   return m_pack_info[kp].uses_unpack_info();
 }
 
+struct select_bypass_plan;
+
 /*
   A table definition. This is an entry in the mapping
 
@@ -1175,11 +1204,28 @@ class Rdb_tbl_def {
 
   time_t get_create_time();
   std::atomic<time_t> m_update_time;  // in-memory only value
+
+  /*
+    SELECT bypass plans of this table, keyed by statement digest. They are
+    dropped together with this object when Rdb_ddl_manager replaces or
+    removes it on DDL
+  */
+  std::shared_ptr<const select_bypass_plan> find_bypass_plan(
+      const std::string &digest);
+  void add_bypass_plan(const std::string &digest,
+                       const std::shared_ptr<const select_bypass_plan> &plan,
+                       const size_t max_plans);
+  void clear_bypass_plans();
+
  private:
   const time_t CREATE_TIME_UNKNOWN = 1;
   // CREATE_TIME_UNKNOWN means "didn't try to read, yet"
   // 0 means "no data available"
   std::atomic<time_t> m_create_time;
+
+  std::mutex m_bypass_plans_mutex;
+  std::unordered_map<std::string, std::shared_ptr<const select_bypass_plan>>
+      m_bypass_plans;
 };
 
 /*
@@ -1211,6 +1257,19 @@ interface Rdb_tables_scanner {
   virtual int add_table(Rdb_tbl_def * tdef) = 0;
 };
 
+/*
+  An immutable copy of the lookup maps of Rdb_ddl_manager. Readers take a
+  reference to the current snapshot and search it without acquiring
+  Rdb_ddl_manager::m_rwlock; writers build a new snapshot while holding the
+  write lock and publish it atomically. Key definitions are referenced by
+  shared_ptr so they stay alive for as long as any reader holds the snapshot.
+*/
+
+struct Rdb_ddl_snapshot {
+  std::unordered_map<std::string, Rdb_tbl_def *> m_tables;
+  std::unordered_map<GL_INDEX_ID, std::shared_ptr<Rdb_key_def>> m_keydefs;
+};
+
 /*
   This contains a mapping of
 
@@ -1235,13 +1294,20 @@ class Rdb_ddl_manager {
       m_index_num_to_uncommitted_keydef;
   mysql_rwlock_t m_rwlock;
 
+  // Read-only copy of the maps above, rebuilt by publish_snapshot() after
+  // every change. Must be accessed with std::atomic_load/std::atomic_store.
+  std::shared_ptr<const Rdb_ddl_snapshot> m_snapshot;
+
   Rdb_seq_generator m_sequence;
   // A queue of table stats to write into data dictionary
   // It is produced by event listener (ie compaction and flush threads)
-  // and consumed by the rocksdb background thread
+  // and consumed by the rocksdb background thread. Protected by
+  // m_stats_mutex, which also serializes updates of Rdb_key_def::m_stats.
   std::map<GL_INDEX_ID, Rdb_index_stats> m_stats2store;
+  mysql_mutex_t m_stats_mutex;
 
-  const std::shared_ptr<Rdb_key_def> &find(GL_INDEX_ID gl_index_id);
+  // this method assumes write lock on m_rwlock
+  void publish_snapshot();
 
  public:
   Rdb_ddl_manager(const Rdb_ddl_manager &) = delete;
@@ -1292,6 +1358,18 @@ class Rdb_ddl_manager {
       const std::unordered_set<std::shared_ptr<Rdb_key_def>> &indexes);
   int find_in_uncommitted_keydef(const uint32_t &cf_id);
 
+  /* Drop the cached SELECT bypass plans of all tables */
+  void clear_bypass_plans();
+
+  /*
+    The currently published dictionary snapshot. A new object is returned
+    after every change, so callers may cache data derived from it and compare
+    pointers to detect staleness.
+  */
+  std::shared_ptr<const Rdb_ddl_snapshot> get_snapshot() const {
+    return std::atomic_load(&m_snapshot);
+  }
+
  private:
   /* Put the data into in-memory table (only) */
   int put(Rdb_tbl_def *const key_descr, const bool lock = true);
@@ -126,6 +126,11 @@ const char *const INDEX_STATS_THREAD_NAME = "myrocks-is";
 */
 const char *const MANUAL_COMPACTION_THREAD_NAME = "myrocks-mc";
 
+/*
+  Name prefix for the MRR prefetch threads.
+*/
+const char *const MRR_PREFETCH_THREAD_NAME = "myrocks-mrr";
+
 /*
   Separator between partition name and the qualifier. Sample usage:
 
@@ -400,8 +405,20 @@ struct st_global_stats {
 
   ib_counter_t<ulonglong, 64, RDB_INDEXER>
       table_index_stats_result[TABLE_INDEX_STATS_RESULT_MAX];
+  ib_counter_t<ulonglong, 64, RDB_INDEXER> table_index_stats_from_sketches;
 
   ib_counter_t<ulonglong, 64, RDB_INDEXER> covered_secondary_key_lookups;
+
+  ib_counter_t<ulonglong, 64, RDB_INDEXER> sk_lookahead_batches;
+  ib_counter_t<ulonglong, 64, RDB_INDEXER> sk_lookahead_keys;
+
+  ib_counter_t<ulonglong, 64, RDB_INDEXER> mrr_batches;
+  ib_counter_t<ulonglong, 64, RDB_INDEXER> mrr_batch_keys;
+  ib_counter_t<ulonglong, 64, RDB_INDEXER> mrr_prefetch_waits;
+  ib_counter_t<ulonglong, 64, RDB_INDEXER> mrr_prefetch_wait_micros;
+
+  ib_counter_t<ulonglong, 64, RDB_INDEXER> drop_index_range_deletes;
+  ib_counter_t<ulonglong, 64, RDB_INDEXER> drop_index_bytes_reclaimed;
 };
 
 /* Struct used for exporting status to MySQL */
@@ -426,8 +443,20 @@ struct st_export_stats {
   ulonglong table_index_stats_success;
   ulonglong table_index_stats_failure;
   ulonglong table_index_stats_req_queue_length;
+  ulonglong table_index_stats_from_sketches;
 
   ulonglong covered_secondary_key_lookups;
+
+  ulonglong sk_lookahead_batches;
+  ulonglong sk_lookahead_keys;
+
+  ulonglong mrr_batches;
+  ulonglong mrr_batch_keys;
+  ulonglong mrr_prefetch_waits;
+  ulonglong mrr_prefetch_wait_micros;
+
+  ulonglong drop_index_range_deletes;
+  ulonglong drop_index_bytes_reclaimed;
 };
 
 /* Struct used for exporting RocksDB memory status */
@@ -40,7 +40,9 @@
 #include "./ha_rocksdb_proto.h"
 #include "./nosql_access.h"
 #include "./rdb_cf_manager.h"
+#include "./rdb_compact_filter.h"
 #include "./rdb_datadic.h"
+#include "./rdb_threads.h"
 #include "./rdb_utils.h"
 
 namespace myrocks {
@@ -431,6 +433,236 @@ static int rdb_i_s_perf_context_global_init(void *const p) {
   DBUG_RETURN(0);
 }
 
+/*
+  Support for INFORMATION_SCHEMA.ROCKSDB_PERF_CONTEXT_QUERIES dynamic table
+ */
+namespace RDB_PERF_CONTEXT_QUERIES_FIELD {
+enum { QUERY_ID = 0, THREAD_ID, QUERY, STAT_TYPE, VALUE };
+}  // namespace RDB_PERF_CONTEXT_QUERIES_FIELD
+
+static ST_FIELD_INFO rdb_i_s_perf_context_queries_fields_info[] = {
+    ROCKSDB_FIELD_INFO("QUERY_ID", sizeof(uint64_t), MYSQL_TYPE_LONGLONG, 0),
+    ROCKSDB_FIELD_INFO("THREAD_ID", sizeof(uint64_t), MYSQL_TYPE_LONGLONG, 0),
+    ROCKSDB_FIELD_INFO("QUERY", Rdb_query_perf_context::MAX_QUERY_LENGTH,
+                       MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("STAT_TYPE", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("VALUE", sizeof(uint64_t), MYSQL_TYPE_LONGLONG, 0),
+    ROCKSDB_FIELD_INFO_END};
+
+static int rdb_i_s_perf_context_queries_fill_table(
+    my_core::THD *const thd, my_core::TABLE_LIST *const tables,
+    my_core::Item *const cond MY_ATTRIBUTE((__unused__))) {
+  DBUG_ENTER_FUNC();
+
+  DBUG_ASSERT(thd != nullptr);
+  DBUG_ASSERT(tables != nullptr);
+  DBUG_ASSERT(tables->table != nullptr);
+
+  int ret = 0;
+  Field **field = tables->table->field;
+  DBUG_ASSERT(field != nullptr);
+
+  // Most expensive statements first
+  const std::vector<Rdb_query_perf_context> queries =
+      rdb_query_perf_tracker.get_queries();
+
+  for (const auto &query : queries) {
+    field[RDB_PERF_CONTEXT_QUERIES_FIELD::QUERY_ID]->store(query.m_query_id,
+                                                           true);
+    field[RDB_PERF_CONTEXT_QUERIES_FIELD::THREAD_ID]->store(query.m_thread_id,
+                                                            true);
+    field[RDB_PERF_CONTEXT_QUERIES_FIELD::QUERY]->store(
+        query.m_query.c_str(), query.m_query.size(), system_charset_info);
+
+    for (int i = 0; i < PC_MAX_IDX; i++) {
+      field[RDB_PERF_CONTEXT_QUERIES_FIELD::STAT_TYPE]->store(
+          rdb_pc_stat_types[i].c_str(), rdb_pc_stat_types[i].size(),
+          system_charset_info);
+      field[RDB_PERF_CONTEXT_QUERIES_FIELD::VALUE]->store(query.m_value[i],
+                                                          true);
+
+      ret = static_cast<int>(
+          my_core::schema_table_store_record(thd, tables->table));
+
+      if (ret) {
+        DBUG_RETURN(ret);
+      }
+    }
+  }
+
+  DBUG_RETURN(0);
+}
+
+static int rdb_i_s_perf_context_queries_init(void *const p) {
+  DBUG_ENTER_FUNC();
+
+  DBUG_ASSERT(p != nullptr);
+
+  my_core::ST_SCHEMA_TABLE *schema;
+
+  schema = (my_core::ST_SCHEMA_TABLE *)p;
+
+  schema->fields_info = rdb_i_s_perf_context_queries_fields_info;
+  schema->fill_table = rdb_i_s_perf_context_queries_fill_table;
+
+  DBUG_RETURN(0);
+}
+
+/*
+  Support for INFORMATION_SCHEMA.ROCKSDB_COMPACTION_FILTER_STATS dynamic table
+ */
+namespace RDB_COMPACTION_FILTER_STATS_FIELD {
+enum { COLUMN_FAMILY = 0, INDEX_NUMBER, ROWS_DROPPED, ROWS_EXPIRED };
+}  // namespace RDB_COMPACTION_FILTER_STATS_FIELD
+
+static ST_FIELD_INFO rdb_i_s_compaction_filter_stats_fields_info[] = {
+    ROCKSDB_FIELD_INFO("COLUMN_FAMILY", sizeof(uint32_t), MYSQL_TYPE_LONG, 0),
+    ROCKSDB_FIELD_INFO("INDEX_NUMBER", sizeof(uint32_t), MYSQL_TYPE_LONG, 0),
+    ROCKSDB_FIELD_INFO("ROWS_DROPPED", sizeof(uint64_t), MYSQL_TYPE_LONGLONG,
+                       0),
+    ROCKSDB_FIELD_INFO("ROWS_EXPIRED", sizeof(uint64_t), MYSQL_TYPE_LONGLONG,
+                       0),
+    ROCKSDB_FIELD_INFO_END};
+
+static int rdb_i_s_compaction_filter_stats_fill_table(
+    my_core::THD *const thd, my_core::TABLE_LIST *const tables,
+    my_core::Item *const cond MY_ATTRIBUTE((__unused__))) {
+  DBUG_ENTER_FUNC();
+
+  DBUG_ASSERT(thd != nullptr);
+  DBUG_ASSERT(tables != nullptr);
+  DBUG_ASSERT(tables->table != nullptr);
+
+  Field **field = tables->table->field;
+  DBUG_ASSERT(field != nullptr);
+
+  const auto stats = rdb_compact_filter_metadata.get_stats();
+
+  for (const auto &it : stats) {
+    field[RDB_COMPACTION_FILTER_STATS_FIELD::COLUMN_FAMILY]->store(
+        it.first.cf_id, true);
+    field[RDB_COMPACTION_FILTER_STATS_FIELD::INDEX_NUMBER]->store(
+        it.first.index_id, true);
+    field[RDB_COMPACTION_FILTER_STATS_FIELD::ROWS_DROPPED]->store(
+        it.second.m_rows_dropped, true);
+    field[RDB_COMPACTION_FILTER_STATS_FIELD::ROWS_EXPIRED]->store(
+        it.second.m_rows_expired, true);
+
+    const int ret = static_cast<int>(
+        my_core::schema_table_store_record(thd, tables->table));
+
+    if (ret) {
+      DBUG_RETURN(ret);
+    }
+  }
+
+  DBUG_RETURN(0);
+}
+
+static int rdb_i_s_compaction_filter_stats_init(void *const p) {
+  DBUG_ENTER_FUNC();
+
+  DBUG_ASSERT(p != nullptr);
+
+  my_core::ST_SCHEMA_TABLE *schema;
+
+  schema = (my_core::ST_SCHEMA_TABLE *)p;
+
+  schema->fields_info = rdb_i_s_compaction_filter_stats_fields_info;
+  schema->fill_table = rdb_i_s_compaction_filter_stats_fill_table;
+
+  DBUG_RETURN(0);
+}
+
+/*
+  Support for INFORMATION_SCHEMA.ROCKSDB_DROP_INDEX_PROGRESS dynamic table
+ */
+namespace RDB_DROP_INDEX_PROGRESS_FIELD {
+enum {
+  COLUMN_FAMILY = 0,
+  INDEX_NUMBER,
+  METHOD,
+  PASSES,
+  INITIAL_SIZE,
+  CURRENT_SIZE,
+  BYTES_RECLAIMED
+};
+}  // namespace RDB_DROP_INDEX_PROGRESS_FIELD
+
+static ST_FIELD_INFO rdb_i_s_drop_index_progress_fields_info[] = {
+    ROCKSDB_FIELD_INFO("COLUMN_FAMILY", sizeof(uint32_t), MYSQL_TYPE_LONG, 0),
+    ROCKSDB_FIELD_INFO("INDEX_NUMBER", sizeof(uint32_t), MYSQL_TYPE_LONG, 0),
+    ROCKSDB_FIELD_INFO("METHOD", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("PASSES", sizeof(uint64_t), MYSQL_TYPE_LONGLONG, 0),
+    ROCKSDB_FIELD_INFO("INITIAL_SIZE", sizeof(uint64_t), MYSQL_TYPE_LONGLONG,
+                       0),
+    ROCKSDB_FIELD_INFO("CURRENT_SIZE", sizeof(uint64_t), MYSQL_TYPE_LONGLONG,
+                       0),
+    ROCKSDB_FIELD_INFO("BYTES_RECLAIMED", sizeof(uint64_t),
+                       MYSQL_TYPE_LONGLONG, 0),
+    ROCKSDB_FIELD_INFO_END};
+
+static int rdb_i_s_drop_index_progress_fill_table(
+    my_core::THD *const thd, my_core::TABLE_LIST *const tables,
+    my_core::Item *const cond MY_ATTRIBUTE((__unused__))) {
+  DBUG_ENTER_FUNC();
+
+  DBUG_ASSERT(thd != nullptr);
+  DBUG_ASSERT(tables != nullptr);
+  DBUG_ASSERT(tables->table != nullptr);
+
+  Field **field = tables->table->field;
+  DBUG_ASSERT(field != nullptr);
+
+  const auto progress = rdb_get_drop_index_thread()->get_progress();
+
+  for (const auto &it : progress) {
+    const Rdb_drop_index_progress &p = it.second;
+    const std::string method = p.m_delete_range ? "DELETE_RANGE" : "COMPACTION";
+
+    field[RDB_DROP_INDEX_PROGRESS_FIELD::COLUMN_FAMILY]->store(it.first.cf_id,
+                                                              true);
+    field[RDB_DROP_INDEX_PROGRESS_FIELD::INDEX_NUMBER]->store(
+        it.first.index_id, true);
+    field[RDB_DROP_INDEX_PROGRESS_FIELD::METHOD]->store(
+        method.c_str(), method.size(), system_charset_info);
+    field[RDB_DROP_INDEX_PROGRESS_FIELD::PASSES]->store(p.m_passes, true);
+    field[RDB_DROP_INDEX_PROGRESS_FIELD::INITIAL_SIZE]->store(p.m_initial_size,
+                                                             true);
+    field[RDB_DROP_INDEX_PROGRESS_FIELD::CURRENT_SIZE]->store(p.m_current_size,
+                                                             true);
+    field[RDB_DROP_INDEX_PROGRESS_FIELD::BYTES_RECLAIMED]->store(
+        p.m_initial_size > p.m_current_size
+            ? p.m_initial_size - p.m_current_size
+            : 0,
+        true);
+
+    const int ret = static_cast<int>(
+        my_core::schema_table_store_record(thd, tables->table));
+
+    if (ret) {
+      DBUG_RETURN(ret);
+    }
+  }
+
+  DBUG_RETURN(0);
+}
+
+static int rdb_i_s_drop_index_progress_init(void *const p) {
+  DBUG_ENTER_FUNC();
+
+  DBUG_ASSERT(p != nullptr);
+
+  my_core::ST_SCHEMA_TABLE *schema;
+
+  schema = (my_core::ST_SCHEMA_TABLE *)p;
+
+  schema->fields_info = rdb_i_s_drop_index_progress_fields_info;
+  schema->fill_table = rdb_i_s_drop_index_progress_fill_table;
+
+  DBUG_RETURN(0);
+}
+
 /*
   Support for INFORMATION_SCHEMA.ROCKSDB_CFOPTIONS dynamic table
  */
@@ -1154,6 +1386,41 @@ static int rdb_i_s_bypass_rejected_query_history_fill_table(
   DBUG_RETURN(ret);
 }
 
+/*
+  Support for INFORMATION_SCHEMA.ROCKSDB_BYPASS_QUERY_SHAPES dynamic table
+ */
+static int rdb_i_s_bypass_query_shapes_fill_table(
+    my_core::THD *thd, my_core::TABLE_LIST *tables,
+    my_core::Item *cond MY_ATTRIBUTE((__unused__))) {
+  DBUG_ASSERT(thd != nullptr);
+  DBUG_ASSERT(tables != nullptr);
+
+  DBUG_ENTER_FUNC();
+
+  int ret = 0;
+  const std::lock_guard<std::mutex> lock(myrocks::bypass_query_shape_lock);
+  for (const auto &it : myrocks::bypass_query_shapes) {
+    const BYPASS_SHAPE_ITEM &entry = it.second;
+    Field **field = tables->table->field;
+    DBUG_ASSERT(field != nullptr);
+
+    // Normalized query
+    field[0]->store(entry.query.c_str(), entry.query.size(),
+                    system_charset_info);
+    // Executed / rejected / failed count
+    field[1]->store(entry.executed, true);
+    field[2]->store(entry.rejected, true);
+    field[3]->store(entry.failed, true);
+
+    ret = static_cast<int>(
+        my_core::schema_table_store_record(thd, tables->table));
+    if (ret != 0) {
+      break;
+    }
+  }
+  DBUG_RETURN(ret);
+}
+
 static ST_FIELD_INFO rdb_i_s_compact_stats_fields_info[] = {
     ROCKSDB_FIELD_INFO("CF_NAME", NAME_LEN + 1, MYSQL_TYPE_STRING, 0),
     ROCKSDB_FIELD_INFO("LEVEL", FN_REFLEN + 1, MYSQL_TYPE_STRING, 0),
@@ -1167,6 +1434,13 @@ static ST_FIELD_INFO rdb_i_s_bypass_rejected_query_history_fields_info[] = {
     ROCKSDB_FIELD_INFO("ERROR_MSG", 100, MYSQL_TYPE_STRING, 0),
     ROCKSDB_FIELD_INFO_END};
 
+static ST_FIELD_INFO rdb_i_s_bypass_query_shapes_fields_info[] = {
+    ROCKSDB_FIELD_INFO("QUERY", FN_REFLEN + 1, MYSQL_TYPE_STRING, 0),
+    ROCKSDB_FIELD_INFO("EXECUTED", sizeof(uint64_t), MYSQL_TYPE_LONGLONG, 0),
+    ROCKSDB_FIELD_INFO("REJECTED", sizeof(uint64_t), MYSQL_TYPE_LONGLONG, 0),
+    ROCKSDB_FIELD_INFO("FAILED", sizeof(uint64_t), MYSQL_TYPE_LONGLONG, 0),
+    ROCKSDB_FIELD_INFO_END};
+
 namespace  // anonymous namespace = not visible outside this source file
 {
 struct Rdb_ddl_scanner : public Rdb_tables_scanner {
@@ -1391,6 +1665,20 @@ static int rdb_i_s_bypass_rejected_query_history_init(void *p) {
   DBUG_RETURN(0);
 }
 
+static int rdb_i_s_bypass_query_shapes_init(void *p) {
+  my_core::ST_SCHEMA_TABLE *schema;
+
+  DBUG_ENTER_FUNC();
+  DBUG_ASSERT(p != nullptr);
+
+  schema = reinterpret_cast<my_core::ST_SCHEMA_TABLE *>(p);
+
+  schema->fields_info = rdb_i_s_bypass_query_shapes_fields_info;
+  schema->fill_table = rdb_i_s_bypass_query_shapes_fill_table;
+
+  DBUG_RETURN(0);
+}
+
 /* Given a path to a file return just the filename portion. */
 static std::string rdb_filename_without_path(const std::string &path) {
   /* Find last slash in path */
@@ -2146,6 +2434,22 @@ struct st_mysql_plugin rdb_i_s_perf_context_global = {
     0,       /* flags */
 };
 
+struct st_mysql_plugin rdb_i_s_perf_context_queries = {
+    MYSQL_INFORMATION_SCHEMA_PLUGIN,
+    &rdb_i_s_info,
+    "ROCKSDB_PERF_CONTEXT_QUERIES",
+    "Facebook",
+    "RocksDB perf context stats (per statement)",
+    PLUGIN_LICENSE_GPL,
+    rdb_i_s_perf_context_queries_init,
+    rdb_i_s_deinit,
+    0x0001,  /* version number (0.1) */
+    nullptr, /* status variables */
+    nullptr, /* system variables */
+    nullptr, /* config options */
+    0,       /* flags */
+};
+
 struct st_mysql_plugin rdb_i_s_cfoptions = {
     MYSQL_INFORMATION_SCHEMA_PLUGIN,
     &rdb_i_s_info,
@@ -2194,6 +2498,38 @@ struct st_mysql_plugin rdb_i_s_compact_stats = {
     0,       /* flags */
 };
 
+struct st_mysql_plugin rdb_i_s_drop_index_progress = {
+    MYSQL_INFORMATION_SCHEMA_PLUGIN,
+    &rdb_i_s_info,
+    "ROCKSDB_DROP_INDEX_PROGRESS",
+    "Facebook",
+    "RocksDB space reclamation of dropped indexes",
+    PLUGIN_LICENSE_GPL,
+    rdb_i_s_drop_index_progress_init,
+    rdb_i_s_deinit,
+    0x0001,  /* version number (0.1) */
+    nullptr, /* status variables */
+    nullptr, /* system variables */
+    nullptr, /* config options */
+    0,       /* flags */
+};
+
+struct st_mysql_plugin rdb_i_s_compaction_filter_stats = {
+    MYSQL_INFORMATION_SCHEMA_PLUGIN,
+    &rdb_i_s_info,
+    "ROCKSDB_COMPACTION_FILTER_STATS",
+    "Facebook",
+    "RocksDB rows dropped and expired by compaction filters (per index)",
+    PLUGIN_LICENSE_GPL,
+    rdb_i_s_compaction_filter_stats_init,
+    rdb_i_s_deinit,
+    0x0001,  /* version number (0.1) */
+    nullptr, /* status variables */
+    nullptr, /* system variables */
+    nullptr, /* config options */
+    0,       /* flags */
+};
+
 struct st_mysql_plugin rdb_i_s_live_files_metadata = {
     MYSQL_INFORMATION_SCHEMA_PLUGIN,
     &rdb_i_s_info,
@@ -2321,4 +2657,20 @@ struct st_mysql_plugin rdb_i_s_bypass_rejected_query_history = {
     nullptr, /* config options */
     0,       /* flags */
 };
+
+struct st_mysql_plugin rdb_i_s_bypass_query_shapes = {
+    MYSQL_INFORMATION_SCHEMA_PLUGIN,
+    &rdb_i_s_info,
+    "ROCKSDB_BYPASS_QUERY_SHAPES",
+    "Facebook",
+    "RocksDB bypass SELECT outcome per query shape",
+    PLUGIN_LICENSE_GPL,
+    rdb_i_s_bypass_query_shapes_init,
+    rdb_i_s_deinit,
+    0x0001,  /* version number (0.1) */
+    nullptr, /* status variables */
+    nullptr, /* system variables */
+    nullptr, /* config options */
+    0,       /* flags */
+};
 }  // namespace myrocks
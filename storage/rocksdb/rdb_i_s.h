@@ -25,8 +25,11 @@ extern struct st_mysql_plugin rdb_i_s_cfstats;
 extern struct st_mysql_plugin rdb_i_s_dbstats;
 extern struct st_mysql_plugin rdb_i_s_perf_context;
 extern struct st_mysql_plugin rdb_i_s_perf_context_global;
+extern struct st_mysql_plugin rdb_i_s_perf_context_queries;
 extern struct st_mysql_plugin rdb_i_s_cfoptions;
 extern struct st_mysql_plugin rdb_i_s_compact_stats;
+extern struct st_mysql_plugin rdb_i_s_compaction_filter_stats;
+extern struct st_mysql_plugin rdb_i_s_drop_index_progress;
 extern struct st_mysql_plugin rdb_i_s_global_info;
 extern struct st_mysql_plugin rdb_i_s_ddl;
 extern struct st_mysql_plugin rdb_i_s_sst_props;
@@ -35,5 +38,6 @@ extern struct st_mysql_plugin rdb_i_s_lock_info;
 extern struct st_mysql_plugin rdb_i_s_trx_info;
 extern struct st_mysql_plugin rdb_i_s_deadlock_info;
 extern struct st_mysql_plugin rdb_i_s_bypass_rejected_query_history;
+extern struct st_mysql_plugin rdb_i_s_bypass_query_shapes;
 extern struct st_mysql_plugin rdb_i_s_live_files_metadata;
 }  // namespace myrocks
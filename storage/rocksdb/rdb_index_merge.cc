@@ -17,29 +17,103 @@
 /* This C++ file's header file */
 #include "./rdb_index_merge.h"
 
+/* C++ standard header files */
+#include <algorithm>
+
 /* MySQL header files */
 #include "../sql/sql_class.h"
 
 /* MyRocks header files */
 #include "./ha_rocksdb.h"
 #include "./rdb_datadic.h"
+#include "./rdb_psi.h"
 
 namespace myrocks {
 
+Rdb_index_merge_pool::Rdb_index_merge_pool(const uint n_threads) {
+  for (uint i = 0; i < n_threads; i++) {
+    pthread_t handle;
+    if (mysql_thread_create(rdb_index_merge_psi_thread_key, &handle, nullptr,
+                            thread_func, this)) {
+      // NO_LINT_DEBUG
+      sql_print_warning("RocksDB: Failed to start index merge thread %u.", i);
+      break;
+    }
+    m_threads.push_back(handle);
+  }
+}
+
+Rdb_index_merge_pool::~Rdb_index_merge_pool() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+    m_cond.notify_all();
+  }
+
+  for (const auto &handle : m_threads) {
+    pthread_join(handle, nullptr);
+  }
+}
+
+void *Rdb_index_merge_pool::thread_func(void *const pool_ptr) {
+  DBUG_ASSERT(pool_ptr != nullptr);
+  my_thread_init();
+  static_cast<Rdb_index_merge_pool *>(pool_ptr)->run();
+  my_thread_end();
+  return nullptr;
+}
+
+void Rdb_index_merge_pool::run() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  for (;;) {
+    m_cond.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+    if (m_jobs.empty()) {
+      break;
+    }
+
+    std::function<void()> job = std::move(m_jobs.front());
+    m_jobs.pop();
+    /* Wake up a producer waiting for room in the queue */
+    m_cond.notify_all();
+
+    lock.unlock();
+    job();
+    lock.lock();
+  }
+}
+
+void Rdb_index_merge_pool::submit(std::function<void()> &&job) {
+  DBUG_ASSERT(!m_threads.empty());
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cond.wait(lock, [this] { return m_jobs.size() < m_threads.size(); });
+  m_jobs.push(std::move(job));
+  m_cond.notify_all();
+}
+
 Rdb_index_merge::Rdb_index_merge(const char *const tmpfile_path,
                                  const ulonglong merge_buf_size,
                                  const ulonglong merge_combine_read_size,
                                  const ulonglong merge_tmp_file_removal_delay,
-                                 rocksdb::ColumnFamilyHandle *cf)
+                                 rocksdb::ColumnFamilyHandle *cf,
+                                 Rdb_index_merge_pool *const pool)
     : m_tmpfile_path(tmpfile_path),
       m_merge_buf_size(merge_buf_size),
       m_merge_combine_read_size(merge_combine_read_size),
       m_merge_tmp_file_removal_delay(merge_tmp_file_removal_delay),
       m_cf_handle(cf),
       m_rec_buf_unsorted(nullptr),
-      m_output_buf(nullptr) {}
+      m_output_buf(nullptr),
+      m_pool(pool != nullptr && pool->size() > 0 ? pool : nullptr),
+      m_pending_jobs(0),
+      m_jobs_error(HA_EXIT_SUCCESS) {}
 
 Rdb_index_merge::~Rdb_index_merge() {
+  /* Pool threads may still be writing runs if the scan failed */
+  if (m_pool != nullptr) {
+    merge_jobs_wait();
+  }
+
   /*
     If merge_tmp_file_removal_delay is set, sleep between calls to chsize.
 
@@ -148,7 +222,7 @@ int Rdb_index_merge::add(const rocksdb::Slice &key, const rocksdb::Slice &val) {
       If the offset tree is empty here, that means that the proposed key to
       add is too large for the buffer.
     */
-    if (m_offset_tree.empty()) {
+    if (m_offset_tree.empty() && m_sort_recs.empty()) {
       // NO_LINT_DEBUG
       sql_print_error(
           "Sort buffer size is too small to process merge. "
@@ -171,6 +245,16 @@ int Rdb_index_merge::add(const rocksdb::Slice &key, const rocksdb::Slice &val) {
   */
   m_rec_buf_unsorted->store_key_value(key, val);
 
+  /*
+    The records are sorted by a pool thread once the buffer is full. Only
+    non-unique secondary keys are built this way and those contain the
+    primary key, so there are no duplicates to report here.
+  */
+  if (m_pool != nullptr) {
+    m_sort_recs.push_back(m_rec_buf_unsorted->m_block.get() + rec_offset);
+    return HA_EXIT_SUCCESS;
+  }
+
   /* Find sort order of the new record */
   auto res =
       m_offset_tree.emplace(m_rec_buf_unsorted->m_block.get() + rec_offset,
@@ -192,6 +276,11 @@ int Rdb_index_merge::merge_buf_write() {
   DBUG_ASSERT(m_merge_file.m_fd != -1);
   DBUG_ASSERT(m_rec_buf_unsorted != nullptr);
   DBUG_ASSERT(m_output_buf != nullptr);
+
+  if (m_pool != nullptr) {
+    return merge_buf_submit();
+  }
+
   DBUG_ASSERT(!m_offset_tree.empty());
 
   /* Write actual chunk size to first 8 bytes of the merge buffer */
@@ -217,38 +306,302 @@ int Rdb_index_merge::merge_buf_write() {
 
   DBUG_ASSERT(m_output_buf->m_curr_offset <= m_output_buf->m_total_size);
 
-  /*
-    Write output buffer to disk.
-
-    Need to position cursor to the chunk it needs to be at on filesystem
-    then write into the respective merge buffer.
-  */
-  if (my_seek(m_merge_file.m_fd,
-              m_merge_file.m_num_sort_buffers * m_merge_buf_size, SEEK_SET,
-              MYF(0)) == MY_FILEPOS_ERROR) {
-    // NO_LINT_DEBUG
-    sql_print_error("Error seeking to location in merge file on disk.");
+  /* Write output buffer to disk */
+  if (merge_buf_write_out(m_merge_file.m_num_sort_buffers, *m_output_buf)) {
     return HA_ERR_ROCKSDB_MERGE_FILE_ERR;
   }
 
+  /* Increment merge file offset to track number of merge buffers written */
+  m_merge_file.m_num_sort_buffers += 1;
+
+  /* Reset everything for next run */
+  merge_reset();
+
+  return HA_EXIT_SUCCESS;
+}
+
+/**
+  Write a sorted buffer into its slot of the merge file. Positional writes
+  are used so that pool threads can write different slots concurrently.
+*/
+int Rdb_index_merge::merge_buf_write_out(const ulong slot,
+                                         const merge_buf_info &buf) {
   /*
     Add a file sync call here to flush the data out. Otherwise, the filesystem
     cache can flush out all of the files at the same time, causing a write
     burst.
   */
-  if (my_write(m_merge_file.m_fd, m_output_buf->m_block.get(),
-               m_output_buf->m_total_size, MYF(MY_WME | MY_NABP)) ||
+  if (my_pwrite(m_merge_file.m_fd, buf.m_block.get(), buf.m_total_size,
+                slot * m_merge_buf_size, MYF(MY_WME | MY_NABP)) ||
       mysql_file_sync(m_merge_file.m_fd, MYF(MY_WME))) {
     // NO_LINT_DEBUG
     sql_print_error("Error writing sorted merge buffer to disk.");
     return HA_ERR_ROCKSDB_MERGE_FILE_ERR;
   }
 
-  /* Increment merge file offset to track number of merge buffers written */
-  m_merge_file.m_num_sort_buffers += 1;
+  return HA_EXIT_SUCCESS;
+}
 
-  /* Reset everything for next run */
-  merge_reset();
+/**
+  Get a sort buffer, reusing the ones of runs already written by the pool.
+*/
+std::shared_ptr<Rdb_index_merge::merge_buf_info>
+Rdb_index_merge::merge_buf_alloc() {
+  {
+    std::lock_guard<std::mutex> lock(m_jobs_mutex);
+    if (!m_free_bufs.empty()) {
+      std::shared_ptr<merge_buf_info> buf = std::move(m_free_bufs.back());
+      m_free_bufs.pop_back();
+      return buf;
+    }
+  }
+
+  return std::make_shared<merge_buf_info>(m_merge_buf_size);
+}
+
+/**
+  Hand the current sort buffer over to a pool thread, which sorts it and
+  writes it out as a run, and continue with a fresh buffer.
+*/
+int Rdb_index_merge::merge_buf_submit() {
+  DBUG_ASSERT(!m_sort_recs.empty());
+
+  const auto run = std::make_shared<merge_run>();
+  {
+    std::lock_guard<std::mutex> lock(m_jobs_mutex);
+    if (m_jobs_error) {
+      return m_jobs_error;
+    }
+
+    run->m_slot = m_merge_file.m_num_sort_buffers++;
+    m_run_samples.resize(m_merge_file.m_num_sort_buffers);
+    m_pending_jobs++;
+  }
+
+  run->m_rec_buf = std::move(m_rec_buf_unsorted);
+  run->m_output_buf = std::move(m_output_buf);
+  run->m_recs.swap(m_sort_recs);
+
+  m_pool->submit([this, run]() {
+    std::vector<merge_sample> samples;
+    const int rc = merge_run_write(run.get(), &samples);
+
+    {
+      std::lock_guard<std::mutex> lock(m_jobs_mutex);
+      m_run_samples[run->m_slot] = std::move(samples);
+      m_free_bufs.push_back(std::move(run->m_rec_buf));
+      m_free_bufs.push_back(std::move(run->m_output_buf));
+    }
+
+    merge_job_done(rc);
+  });
+
+  m_rec_buf_unsorted = merge_buf_alloc();
+  m_output_buf = merge_buf_alloc();
+  return HA_EXIT_SUCCESS;
+}
+
+/**
+  Sort a buffer handed over by merge_buf_submit() and write it out as a run.
+  About RDB_MERGE_RUN_SAMPLES evenly spaced keys of the run are sampled.
+*/
+int Rdb_index_merge::merge_run_write(merge_run *const run,
+                                     std::vector<merge_sample> *samples) {
+  const rocksdb::Comparator *const comparator = m_cf_handle->GetComparator();
+  std::sort(run->m_recs.begin(), run->m_recs.end(),
+            [comparator](const uchar *a_block, const uchar *b_block) {
+              return merge_record_compare(a_block, b_block, comparator) < 0;
+            });
+
+  merge_buf_info *const output_buf = run->m_output_buf.get();
+  output_buf->m_curr_offset = 0;
+  merge_store_uint64(output_buf->m_block.get(),
+                     run->m_rec_buf->m_curr_offset + RDB_MERGE_CHUNK_LEN);
+  output_buf->m_curr_offset += RDB_MERGE_CHUNK_LEN;
+
+  const size_t sample_step =
+      std::max<size_t>(run->m_recs.size() / RDB_MERGE_RUN_SAMPLES, 1);
+  for (size_t i = 0; i < run->m_recs.size(); i++) {
+    rocksdb::Slice key;
+    rocksdb::Slice val;
+    merge_read_rec(run->m_recs[i], &key, &val);
+
+    if (i % sample_step == 0) {
+      samples->emplace_back(key, output_buf->m_curr_offset);
+    }
+
+    output_buf->store_key_value(key, val);
+  }
+
+  DBUG_ASSERT(output_buf->m_curr_offset <= output_buf->m_total_size);
+  const int rc = merge_buf_write_out(run->m_slot, *output_buf);
+
+  run->m_recs.clear();
+  run->m_rec_buf->m_curr_offset = 0;
+  output_buf->m_curr_offset = 0;
+  return rc;
+}
+
+void Rdb_index_merge::merge_job_done(const int rc) {
+  std::lock_guard<std::mutex> lock(m_jobs_mutex);
+  if (rc && !m_jobs_error) {
+    m_jobs_error = rc;
+  }
+
+  DBUG_ASSERT(m_pending_jobs > 0);
+  m_pending_jobs--;
+  m_jobs_cond.notify_all();
+}
+
+/**
+  Wait for the jobs queued to the merge pool, returns the first error.
+*/
+int Rdb_index_merge::merge_jobs_wait() {
+  std::unique_lock<std::mutex> lock(m_jobs_mutex);
+  m_jobs_cond.wait(lock, [this] { return m_pending_jobs == 0; });
+  return m_jobs_error;
+}
+
+/**
+  Merge the sorted runs with the threads of the merge pool.
+
+  The key space is split into up to pool size ranges using the keys sampled
+  from the runs, and each range is merged by one thread into its own output:
+  put() is called in key order for the records of a range, and ranges are
+  numbered in key order. Each thread starts reading a run from the last
+  sample before its range, so the runs are not scanned from the beginning.
+*/
+int Rdb_index_merge::merge_parallel(const merge_put_func &put) {
+  DBUG_ASSERT(m_pool != nullptr);
+  DBUG_ASSERT(m_merge_min_heap.empty());
+
+  int res;
+  if (!m_sort_recs.empty() && (res = merge_buf_write())) {
+    return res;
+  }
+
+  if ((res = merge_jobs_wait())) {
+    return res;
+  }
+
+  /* No runs when an index was added on a table w/ no rows */
+  if (m_merge_file.m_num_sort_buffers == 0) {
+    return HA_EXIT_SUCCESS;
+  }
+
+  const rocksdb::Comparator *const comparator = m_cf_handle->GetComparator();
+  std::vector<const std::string *> keys;
+  for (const auto &samples : m_run_samples) {
+    for (const auto &sample : samples) {
+      keys.push_back(&sample.m_key);
+    }
+  }
+  std::sort(keys.begin(), keys.end(),
+            [comparator](const std::string *a, const std::string *b) {
+              return comparator->Compare(*a, *b) < 0;
+            });
+
+  /* Every run has at least one sample, so keys is never empty */
+  const uint n_ranges = std::min<size_t>(m_pool->size(), keys.size());
+  std::vector<rocksdb::Slice> bounds;
+  for (uint i = 1; i < n_ranges; i++) {
+    bounds.emplace_back(*keys[i * keys.size() / n_ranges]);
+  }
+
+  /* Each range reads a chunk of every run */
+  ulonglong chunk_size = m_merge_combine_read_size /
+                         (m_merge_file.m_num_sort_buffers * n_ranges);
+  if (chunk_size >= m_merge_buf_size) {
+    chunk_size = m_merge_buf_size;
+  }
+
+  for (uint i = 0; i < n_ranges; i++) {
+    const rocksdb::Slice *const lower = i > 0 ? &bounds[i - 1] : nullptr;
+    const rocksdb::Slice *const upper = i < n_ranges - 1 ? &bounds[i] : nullptr;
+
+    {
+      std::lock_guard<std::mutex> lock(m_jobs_mutex);
+      m_pending_jobs++;
+    }
+
+    m_pool->submit([this, i, lower, upper, chunk_size, &put]() {
+      merge_job_done(merge_range(i, lower, upper, chunk_size, put));
+    });
+  }
+
+  return merge_jobs_wait();
+}
+
+/**
+  n-way merge of the records in [lower, upper) of all runs. A null bound
+  means the range is unbounded on that side.
+*/
+int Rdb_index_merge::merge_range(const uint range,
+                                 const rocksdb::Slice *const lower,
+                                 const rocksdb::Slice *const upper,
+                                 const ulonglong chunk_size,
+                                 const merge_put_func &put) {
+  const rocksdb::Comparator *const comparator = m_cf_handle->GetComparator();
+  const auto before_upper = [comparator, upper](const rocksdb::Slice &key) {
+    return upper == nullptr || comparator->Compare(key, *upper) < 0;
+  };
+
+  std::priority_queue<std::shared_ptr<merge_heap_entry>,
+                      std::vector<std::shared_ptr<merge_heap_entry>>,
+                      merge_heap_comparator>
+      heap;
+  int res;
+
+  for (ulong i = 0; i < m_merge_file.m_num_sort_buffers; i++) {
+    ulonglong rec_offset = RDB_MERGE_CHUNK_LEN;
+    if (lower != nullptr) {
+      const auto &samples = m_run_samples[i];
+      const auto it = std::lower_bound(
+          samples.begin(), samples.end(), *lower,
+          [comparator](const merge_sample &sample, const rocksdb::Slice &key) {
+            return comparator->Compare(sample.m_key, key) < 0;
+          });
+      if (it != samples.begin()) {
+        rec_offset = std::prev(it)->m_rec_offset;
+      }
+    }
+
+    const auto entry = std::make_shared<merge_heap_entry>(comparator);
+    if (entry->prepare(m_merge_file.m_fd, i * m_merge_buf_size, chunk_size,
+                       rec_offset) == (size_t)-1) {
+      return HA_ERR_ROCKSDB_MERGE_FILE_ERR;
+    }
+
+    /* Skip the records that belong to the previous range */
+    while ((res = entry->read_next(m_merge_file.m_fd)) == 0 &&
+           lower != nullptr && comparator->Compare(entry->m_key, *lower) < 0) {
+    }
+
+    if (res > 0) {
+      return res;
+    }
+
+    if (res == 0 && before_upper(entry->m_key)) {
+      heap.push(std::move(entry));
+    }
+  }
+
+  while (!heap.empty()) {
+    const std::shared_ptr<merge_heap_entry> entry = heap.top();
+    heap.pop();
+
+    if ((res = put(range, entry->m_key, entry->m_val))) {
+      return res;
+    }
+
+    if ((res = entry->read_next(m_merge_file.m_fd)) > 0) {
+      return res;
+    }
+
+    if (res == 0 && before_upper(entry->m_key)) {
+      heap.push(std::move(entry));
+    }
+  }
 
   return HA_EXIT_SUCCESS;
 }
@@ -327,6 +680,8 @@ int Rdb_index_merge::next(rocksdb::Slice *const key,
     If there are no sort buffer records (alters on empty tables),
     also exit here.
   */
+  DBUG_ASSERT(m_pool == nullptr);
+
   if (m_merge_file.m_num_sort_buffers == 0) {
     if (m_offset_tree.empty()) {
       return -1;
@@ -395,13 +750,11 @@ int Rdb_index_merge::merge_heap_pop_and_get_next(rocksdb::Slice *const key,
   m_merge_min_heap.pop();
 
   /*
-    We are finished w/ current chunk if:
-    current_offset + disk_offset == m_total_size
-
-    Return without adding entry back onto heap.
+    If the chunk is finished, return without adding entry back onto heap.
     If heap is also empty, we must be finished with merge.
   */
-  if (entry->m_chunk_info->is_chunk_finished()) {
+  const int res = entry->read_next(m_merge_file.m_fd);
+  if (res == -1) {
     if (m_merge_min_heap.empty()) {
       return -1;
     }
@@ -410,31 +763,47 @@ int Rdb_index_merge::merge_heap_pop_and_get_next(rocksdb::Slice *const key,
     return HA_EXIT_SUCCESS;
   }
 
+  if (res) {
+    return res;
+  }
+
+  /* Push entry back on to the heap w/ updated buffer + offset ptr */
+  m_merge_min_heap.push(std::move(entry));
+
+  /* Return the current top record on heap */
+  merge_heap_top(key, val);
+  return HA_EXIT_SUCCESS;
+}
+
+/**
+  Read the next record of the run into m_key and m_val.
+
+  Returns -1 when the run is finished.
+*/
+int Rdb_index_merge::merge_heap_entry::read_next(File fd) {
   /*
-    Make sure we haven't reached the end of the chunk.
+    We are finished w/ current chunk if:
+    current_offset + disk_offset == m_total_size
   */
-  DBUG_ASSERT(!entry->m_chunk_info->is_chunk_finished());
+  if (m_chunk_info->is_chunk_finished()) {
+    return -1;
+  }
 
   /*
     If merge_read_rec fails, it means the either the chunk was cut off
     or we've reached the end of the respective chunk.
   */
-  if (entry->read_rec(&entry->m_key, &entry->m_val)) {
-    if (entry->read_next_chunk_from_disk(m_merge_file.m_fd)) {
+  if (read_rec(&m_key, &m_val)) {
+    if (read_next_chunk_from_disk(fd)) {
       return HA_ERR_ROCKSDB_MERGE_FILE_ERR;
     }
 
     /* Try reading record again, should never fail. */
-    if (entry->read_rec(&entry->m_key, &entry->m_val)) {
+    if (read_rec(&m_key, &m_val)) {
       return HA_ERR_ROCKSDB_MERGE_FILE_ERR;
     }
   }
 
-  /* Push entry back on to the heap w/ updated buffer + offset ptr */
-  m_merge_min_heap.push(std::move(entry));
-
-  /* Return the current top record on heap */
-  merge_heap_top(key, val);
   return HA_EXIT_SUCCESS;
 }
 
@@ -450,15 +819,12 @@ int Rdb_index_merge::merge_heap_entry::read_next_chunk_from_disk(File fd) {
 int Rdb_index_merge::merge_buf_info::read_next_chunk_from_disk(File fd) {
   m_disk_curr_offset += m_curr_offset;
 
-  if (my_seek(fd, m_disk_curr_offset, SEEK_SET, MYF(0)) == MY_FILEPOS_ERROR) {
-    // NO_LINT_DEBUG
-    sql_print_error("Error seeking to location in merge file on disk.");
-    return HA_EXIT_FAILURE;
-  }
-
-  /* Overwrite the old block */
+  /*
+    Overwrite the old block. Positional reads let several merge pool threads
+    share the merge file.
+  */
   const size_t bytes_read =
-      my_read(fd, m_block.get(), m_block_len, MYF(MY_WME));
+      my_pread(fd, m_block.get(), m_block_len, m_disk_curr_offset, MYF(MY_WME));
   if (bytes_read == (size_t)-1) {
     // NO_LINT_DEBUG
     sql_print_error("Error reading merge file from disk.");
@@ -543,12 +909,25 @@ int Rdb_index_merge::merge_heap_entry::read_slice(rocksdb::Slice *const slice,
   return HA_EXIT_SUCCESS;
 }
 
+/**
+  Read the chunk of the run at f_offset, positioned at the record at
+  rec_offset from the start of the run.
+*/
 size_t Rdb_index_merge::merge_heap_entry::prepare(File fd, ulonglong f_offset,
-                                                  ulonglong chunk_size) {
+                                                  ulonglong chunk_size,
+                                                  ulonglong rec_offset) {
   m_chunk_info = std::make_shared<merge_buf_info>(chunk_size);
   const size_t res = m_chunk_info->prepare(fd, f_offset);
-  if (res != (size_t)-1) {
-    m_block = m_chunk_info->m_block.get() + RDB_MERGE_CHUNK_LEN;
+  if (res == (size_t)-1) {
+    return res;
+  }
+
+  DBUG_ASSERT(rec_offset >= RDB_MERGE_CHUNK_LEN && rec_offset <= res);
+  m_chunk_info->m_curr_offset = rec_offset;
+  if (rec_offset < m_chunk_info->m_block_len) {
+    m_block = m_chunk_info->m_block.get() + rec_offset;
+  } else if (read_next_chunk_from_disk(fd)) {
+    return (size_t)-1;
   }
 
   return res;
@@ -558,18 +937,9 @@ size_t Rdb_index_merge::merge_buf_info::prepare(File fd, ulonglong f_offset) {
   m_disk_start_offset = f_offset;
   m_disk_curr_offset = f_offset;
 
-  /*
-    Need to position cursor to the chunk it needs to be at on filesystem
-    then read 'chunk_size' bytes into the respective chunk buffer.
-  */
-  if (my_seek(fd, f_offset, SEEK_SET, MYF(0)) == MY_FILEPOS_ERROR) {
-    // NO_LINT_DEBUG
-    sql_print_error("Error seeking to location in merge file on disk.");
-    return (size_t)-1;
-  }
-
+  /* Read 'chunk_size' bytes of the chunk into the respective chunk buffer */
   const size_t bytes_read =
-      my_read(fd, m_block.get(), m_total_size, MYF(MY_WME));
+      my_pread(fd, m_block.get(), m_total_size, f_offset, MYF(MY_WME));
   if (bytes_read == (size_t)-1) {
     // NO_LINT_DEBUG
     sql_print_error("Error reading merge file from disk.");
@@ -610,6 +980,7 @@ void Rdb_index_merge::merge_reset() {
     so we need to clear the offset tree.
   */
   m_offset_tree.clear();
+  m_sort_recs.clear();
 
   /* Reset sort buffer block */
   if (m_rec_buf_unsorted && m_rec_buf_unsorted->m_block) {
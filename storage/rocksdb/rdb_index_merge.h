@@ -22,8 +22,12 @@
 #include "./my_global.h" /* ulonglong */
 
 /* C++ standard header files */
+#include <condition_variable>
+#include <functional>
+#include <mutex>
 #include <queue>
 #include <set>
+#include <string>
 #include <vector>
 
 /* RocksDB header files */
@@ -42,9 +46,49 @@ namespace myrocks {
 #define RDB_MERGE_KEY_DELIMITER RDB_MERGE_REC_DELIMITER
 #define RDB_MERGE_VAL_DELIMITER RDB_MERGE_REC_DELIMITER
 
+/*
+  Number of keys sampled from every sorted run written by a merge pool
+  thread. The samples are used to split the key space between the threads
+  of the merge phase.
+*/
+#define RDB_MERGE_RUN_SAMPLES 64
+
 class Rdb_key_def;
 class Rdb_tbl_def;
 
+/*
+  Threads that sort and merge the secondary index entries of an inplace
+  index creation (see rocksdb_merge_threads). The pool lives as long as the
+  ALTER TABLE that created it.
+*/
+class Rdb_index_merge_pool {
+  Rdb_index_merge_pool(const Rdb_index_merge_pool &p) = delete;
+  Rdb_index_merge_pool &operator=(const Rdb_index_merge_pool &p) = delete;
+
+ public:
+  explicit Rdb_index_merge_pool(const uint n_threads);
+  ~Rdb_index_merge_pool();
+
+  /* Number of threads that were actually started */
+  uint size() const { return m_threads.size(); }
+
+  /*
+    Queue a job. Blocks while size() jobs are already waiting, which bounds
+    the number of sort buffers held by queued jobs.
+  */
+  void submit(std::function<void()> &&job);
+
+ private:
+  static void *thread_func(void *const pool_ptr);
+  void run();
+
+  std::vector<pthread_t> m_threads;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::queue<std::function<void()>> m_jobs;
+  bool m_stop = false;
+};
+
 class Rdb_index_merge {
   Rdb_index_merge(const Rdb_index_merge &p) = delete;
   Rdb_index_merge &operator=(const Rdb_index_merge &p) = delete;
@@ -109,12 +153,15 @@ class Rdb_index_merge {
     rocksdb::Slice m_key; /* current key pointed to by block ptr */
     rocksdb::Slice m_val;
 
-    size_t prepare(File fd, ulonglong f_offset, ulonglong chunk_size)
+    size_t prepare(File fd, ulonglong f_offset, ulonglong chunk_size,
+                   ulonglong rec_offset = RDB_MERGE_CHUNK_LEN)
         MY_ATTRIBUTE((__nonnull__));
 
     int read_next_chunk_from_disk(File fd)
         MY_ATTRIBUTE((__nonnull__, __warn_unused_result__));
 
+    int read_next(File fd) MY_ATTRIBUTE((__nonnull__, __warn_unused_result__));
+
     int read_rec(rocksdb::Slice *const key, rocksdb::Slice *const val)
         MY_ATTRIBUTE((__nonnull__, __warn_unused_result__));
 
@@ -147,6 +194,27 @@ class Rdb_index_merge {
         : m_block(block), m_comparator(comparator) {}
   };
 
+  /* Key sampled from a sorted run, along with its offset within the run */
+  struct merge_sample {
+    std::string m_key;
+    ulonglong m_rec_offset;
+
+    merge_sample(const rocksdb::Slice &key, const ulonglong rec_offset)
+        : m_key(key.data(), key.size()), m_rec_offset(rec_offset) {}
+  };
+
+  /* Sort buffer handed over to a merge pool thread */
+  struct merge_run {
+    ulong m_slot; /* position of the run in the merge file */
+    std::shared_ptr<merge_buf_info> m_rec_buf;
+    std::shared_ptr<merge_buf_info> m_output_buf;
+    std::vector<uchar *> m_recs; /* records in m_rec_buf */
+  };
+
+  /* Called for every record of the merge phase with the range it is in */
+  using merge_put_func = std::function<int(
+      uint range, const rocksdb::Slice &key, const rocksdb::Slice &val)>;
+
  private:
   const char *m_tmpfile_path;
   const ulonglong m_merge_buf_size;
@@ -162,6 +230,20 @@ class Rdb_index_merge {
                       merge_heap_comparator>
       m_merge_min_heap;
 
+  /*
+    With a merge pool, records are only appended to m_sort_recs and each full
+    sort buffer is sorted and written by a pool thread. The members below are
+    protected by m_jobs_mutex.
+  */
+  Rdb_index_merge_pool *const m_pool;
+  std::vector<uchar *> m_sort_recs;
+  std::mutex m_jobs_mutex;
+  std::condition_variable m_jobs_cond;
+  uint m_pending_jobs;
+  int m_jobs_error;
+  std::vector<std::shared_ptr<merge_buf_info>> m_free_bufs;
+  std::vector<std::vector<merge_sample>> m_run_samples;
+
   static inline void merge_store_uint64(uchar *const dst, uint64 n) {
     memcpy(dst, &n, sizeof(n));
   }
@@ -190,12 +272,32 @@ class Rdb_index_merge {
   void read_slice(rocksdb::Slice *slice, const uchar *block_ptr)
       MY_ATTRIBUTE((__nonnull__));
 
+  int merge_buf_write_out(const ulong slot, const merge_buf_info &buf)
+      MY_ATTRIBUTE((__warn_unused_result__));
+
+  std::shared_ptr<merge_buf_info> merge_buf_alloc();
+
+  int merge_buf_submit() MY_ATTRIBUTE((__warn_unused_result__));
+
+  int merge_run_write(merge_run *const run, std::vector<merge_sample> *samples)
+      MY_ATTRIBUTE((__nonnull__, __warn_unused_result__));
+
+  int merge_range(const uint range, const rocksdb::Slice *const lower,
+                  const rocksdb::Slice *const upper,
+                  const ulonglong chunk_size, const merge_put_func &put)
+      MY_ATTRIBUTE((__warn_unused_result__));
+
+  void merge_job_done(const int rc);
+
+  int merge_jobs_wait();
+
  public:
   Rdb_index_merge(const char *const tmpfile_path,
                   const ulonglong merge_buf_size,
                   const ulonglong merge_combine_read_size,
                   const ulonglong merge_tmp_file_removal_delay,
-                  rocksdb::ColumnFamilyHandle *cf);
+                  rocksdb::ColumnFamilyHandle *cf,
+                  Rdb_index_merge_pool *const pool = nullptr);
   ~Rdb_index_merge();
 
   int init() MY_ATTRIBUTE((__nonnull__, __warn_unused_result__));
@@ -219,9 +321,15 @@ class Rdb_index_merge {
                                   rocksdb::Slice *const val)
       MY_ATTRIBUTE((__nonnull__, __warn_unused_result__));
 
+  int merge_parallel(const merge_put_func &put)
+      MY_ATTRIBUTE((__warn_unused_result__));
+
   void merge_reset();
 
   rocksdb::ColumnFamilyHandle *get_cf() const { return m_cf_handle; }
+
+  /* Whether the runs are sorted and merged by a merge pool */
+  bool is_parallel() const { return m_pool != nullptr; }
 };
 
 }  // namespace myrocks
@@ -19,7 +19,9 @@
 #include "./rdb_perf_context.h"
 
 /* C++ system header files */
+#include <algorithm>
 #include <string>
+#include <vector>
 
 /* RocksDB header files */
 #include "rocksdb/iostats_context.h"
@@ -93,7 +95,9 @@ std::string rdb_pc_stat_types[] = {
     "IO_WRITE_NANOS",
     "IO_READ_NANOS",
     "IO_RANGE_SYNC_NANOS",
-    "IO_LOGGER_NANOS"};
+    "IO_LOGGER_NANOS",
+    "SCAN_READAHEAD_COUNT",
+    "SCAN_READAHEAD_THROTTLED_COUNT"};
 
 #define IO_PERF_RECORD(_field_)                                       \
   do {                                                                \
@@ -110,7 +114,8 @@ std::string rdb_pc_stat_types[] = {
     idx++;                                                               \
   } while (0)
 
-static void harvest_diffs(Rdb_atomic_perf_counters *const counters) {
+template <typename T>
+static void harvest_diffs(T *const counters) {
   // (C) These should be in the same order as the PC enum
   size_t idx = 0;
   IO_PERF_RECORD(user_key_comparison_count);
@@ -171,6 +176,8 @@ static void harvest_diffs(Rdb_atomic_perf_counters *const counters) {
   IO_STAT_RECORD(read_nanos);
   IO_STAT_RECORD(range_sync_nanos);
   IO_STAT_RECORD(logger_nanos);
+
+  // The remaining counters are maintained by Rdb_io_perf::inc()
 }
 
 #undef IO_PERF_DIFF
@@ -188,6 +195,15 @@ void Rdb_perf_counters::load(const Rdb_atomic_perf_counters &atomic_counters) {
   }
 }
 
+void Rdb_io_perf::inc(const int idx) {
+  DBUG_ASSERT(idx >= 0 && idx < PC_MAX_IDX);
+
+  if (m_atomic_counters) {
+    m_atomic_counters->m_value[idx]++;
+  }
+  rdb_global_perf_counters.m_value[idx]++;
+}
+
 bool Rdb_io_perf::start(const uint32_t perf_context_level) {
   const rocksdb::PerfLevel perf_level =
       static_cast<rocksdb::PerfLevel>(perf_context_level);
@@ -215,7 +231,8 @@ void Rdb_io_perf::update_bytes_written(const uint32_t perf_context_level,
   }
 }
 
-void Rdb_io_perf::end_and_record(const uint32_t perf_context_level) {
+void Rdb_io_perf::end_and_record(const uint32_t perf_context_level,
+                                 Rdb_perf_counters *const stmt_counters) {
   const rocksdb::PerfLevel perf_level =
       static_cast<rocksdb::PerfLevel>(perf_context_level);
 
@@ -227,6 +244,9 @@ void Rdb_io_perf::end_and_record(const uint32_t perf_context_level) {
     harvest_diffs(m_atomic_counters);
   }
   harvest_diffs(&rdb_global_perf_counters);
+  if (stmt_counters) {
+    harvest_diffs(stmt_counters);
+  }
 
   if (m_shared_io_perf_read &&
       (rocksdb::get_perf_context()->block_read_byte != 0 ||
@@ -274,4 +294,67 @@ void Rdb_io_perf::end_and_record(const uint32_t perf_context_level) {
   }
 }
 
+Rdb_query_perf_tracker rdb_query_perf_tracker;
+
+bool Rdb_query_perf_tracker::is_less_expensive(
+    const Rdb_query_perf_context &a, const Rdb_query_perf_context &b) {
+  if (a.m_value[PC_BLOCK_READ_COUNT] != b.m_value[PC_BLOCK_READ_COUNT]) {
+    return a.m_value[PC_BLOCK_READ_COUNT] < b.m_value[PC_BLOCK_READ_COUNT];
+  }
+  return a.m_value[PC_BLOCK_CACHE_HIT_COUNT] <
+         b.m_value[PC_BLOCK_CACHE_HIT_COUNT];
+}
+
+void Rdb_query_perf_tracker::record(const Rdb_query_perf_context &query,
+                                    const size_t max_queries) {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+
+  // A statement may be recorded more than once, e.g. when its perf context
+  // is harvested both at commit and at table unlock
+  auto it = std::find_if(m_queries.begin(), m_queries.end(),
+                         [&query](const Rdb_query_perf_context &q) {
+                           return q.m_query_id == query.m_query_id;
+                         });
+  if (it != m_queries.end()) {
+    *it = query;
+    return;
+  }
+
+  if (m_queries.size() < max_queries) {
+    m_queries.push_back(query);
+    return;
+  }
+
+  // Replace the cheapest statement, if this one is more expensive
+  it = std::min_element(m_queries.begin(), m_queries.end(), is_less_expensive);
+  if (it != m_queries.end() && is_less_expensive(*it, query)) {
+    *it = query;
+  }
+}
+
+void Rdb_query_perf_tracker::resize(const size_t max_queries) {
+  const std::lock_guard<std::mutex> lock(m_mutex);
+
+  while (m_queries.size() > max_queries) {
+    m_queries.erase(std::min_element(m_queries.begin(), m_queries.end(),
+                                     is_less_expensive));
+  }
+}
+
+std::vector<Rdb_query_perf_context> Rdb_query_perf_tracker::get_queries() {
+  std::vector<Rdb_query_perf_context> queries;
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    queries = m_queries;
+  }
+
+  // Most expensive first
+  std::sort(queries.begin(), queries.end(),
+            [](const Rdb_query_perf_context &a,
+               const Rdb_query_perf_context &b) {
+              return is_less_expensive(b, a);
+            });
+  return queries;
+}
+
 }  // namespace myrocks
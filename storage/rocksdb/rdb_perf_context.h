@@ -17,9 +17,12 @@
 #pragma once
 
 /* C++ standard header files */
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
+#include <mutex>
 #include <string>
+#include <vector>
 
 /* MySQL header files */
 #include <my_global.h>
@@ -85,6 +88,8 @@ enum {
   PC_IO_READ_NANOS,
   PC_IO_RANGE_SYNC_NANOS,
   PC_IO_LOGGER_NANOS,
+  PC_SCAN_READAHEAD_COUNT,
+  PC_SCAN_READAHEAD_THROTTLED_COUNT,
   PC_MAX_IDX
 };
 
@@ -111,6 +116,7 @@ class Rdb_perf_counters {
   uint64_t m_value[PC_MAX_IDX];
 
   void load(const Rdb_atomic_perf_counters &atomic_counters);
+  void reset() { std::fill_n(m_value, PC_MAX_IDX, 0); }
 };
 
 extern std::string rdb_pc_stat_types[PC_MAX_IDX];
@@ -153,7 +159,11 @@ class Rdb_io_perf {
   bool start(const uint32_t perf_context_level);
   void update_bytes_written(const uint32_t perf_context_level,
                             ulonglong bytes_written);
-  void end_and_record(const uint32_t perf_context_level);
+  void end_and_record(const uint32_t perf_context_level,
+                      Rdb_perf_counters *const stmt_counters = nullptr);
+
+  /* Count an event that MyRocks tracks itself, e.g. PC_SCAN_READAHEAD_COUNT */
+  void inc(const int idx);
 
   explicit Rdb_io_perf()
       : m_atomic_counters(nullptr),
@@ -163,4 +173,38 @@ class Rdb_io_perf {
         io_write_requests(0) {}
 };
 
+/*
+  Perf context of a single statement, see rocksdb_perf_context_trace
+*/
+struct Rdb_query_perf_context {
+  /* Statements are truncated to this length */
+  static constexpr size_t MAX_QUERY_LENGTH = 1024;
+
+  query_id_t m_query_id;
+  ulong m_thread_id;
+  std::string m_query;
+  uint64_t m_value[PC_MAX_IDX];
+};
+
+/*
+  The most expensive statements traced so far, for
+  INFORMATION_SCHEMA.ROCKSDB_PERF_CONTEXT_QUERIES. A statement is more
+  expensive than another when it read more blocks from storage, or read as
+  many and hit the block cache more often.
+*/
+class Rdb_query_perf_tracker {
+  std::mutex m_mutex;
+  std::vector<Rdb_query_perf_context> m_queries;
+
+ public:
+  static bool is_less_expensive(const Rdb_query_perf_context &a,
+                                const Rdb_query_perf_context &b);
+
+  void record(const Rdb_query_perf_context &query, const size_t max_queries);
+  void resize(const size_t max_queries);
+  std::vector<Rdb_query_perf_context> get_queries();
+};
+
+extern Rdb_query_perf_tracker rdb_query_perf_tracker;
+
 }  // namespace myrocks
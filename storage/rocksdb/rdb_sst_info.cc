@@ -302,7 +302,7 @@ Rdb_sst_info::Rdb_sst_info(rocksdb::DB *const db, const std::string &tablename,
                            const std::string &indexname,
                            rocksdb::ColumnFamilyHandle *const cf,
                            const rocksdb::DBOptions &db_options,
-                           const bool tracing)
+                           const bool tracing, const uint writer_threads)
     : m_db(db),
       m_cf(cf),
       m_db_options(db_options),
@@ -312,7 +312,10 @@ Rdb_sst_info::Rdb_sst_info(rocksdb::DB *const db, const std::string &tablename,
       m_done(false),
       m_sst_file(nullptr),
       m_tracing(tracing),
-      m_print_client_error(true) {
+      m_print_client_error(true),
+      m_writer_threads(writer_threads),
+      m_batch_ascending(true),
+      m_finished(false) {
   m_prefix = db->GetName() + "/";
 
   std::string normalized_table;
@@ -346,6 +349,10 @@ Rdb_sst_info::Rdb_sst_info(rocksdb::DB *const db, const std::string &tablename,
 Rdb_sst_info::~Rdb_sst_info() {
   DBUG_ASSERT(m_sst_file == nullptr);
 
+  // Not finished if the bulk load was abandoned, the files written so far
+  // are removed below
+  stop_threads();
+
   for (const auto &sst_file : m_committed_files) {
     // In case something went wrong attempt to delete the temporary file.
     // If everything went fine that file will have been renamed and this
@@ -409,6 +416,10 @@ int Rdb_sst_info::put(const rocksdb::Slice &key, const rocksdb::Slice &value) {
 
   DBUG_ASSERT(!m_done);
 
+  if (m_writer_threads > 0) {
+    return put_batch(key, value);
+  }
+
   if (m_curr_size + key.size() + value.size() >= m_max_size) {
     // The current sst file has reached its maximum, close it out
     close_curr_sst_file();
@@ -442,6 +453,206 @@ int Rdb_sst_info::put(const rocksdb::Slice &key, const rocksdb::Slice &value) {
   return HA_EXIT_SUCCESS;
 }
 
+void Rdb_sst_info::Rdb_sst_batch::add(const rocksdb::Slice &key,
+                                      const rocksdb::Slice &value) {
+  m_data.append(key.data(), key.size());
+  m_data.append(value.data(), value.size());
+  m_lens.emplace_back(key.size(), value.size());
+}
+
+rocksdb::Slice Rdb_sst_info::Rdb_sst_batch::last_key() const {
+  DBUG_ASSERT(!m_lens.empty());
+
+  const auto &lens = m_lens.back();
+  return rocksdb::Slice(
+      m_data.data() + m_data.size() - lens.first - lens.second, lens.first);
+}
+
+rocksdb::Status Rdb_sst_info::Rdb_sst_batch::write(
+    Rdb_sst_file_ordered *const sst_file) const {
+  rocksdb::Status s;
+  size_t offset = 0;
+
+  for (const auto &lens : m_lens) {
+    s = sst_file->put(rocksdb::Slice(m_data.data() + offset, lens.first),
+                      rocksdb::Slice(m_data.data() + offset + lens.first,
+                                     lens.second));
+    if (!s.ok()) {
+      break;
+    }
+    offset += lens.first + lens.second;
+  }
+
+  return s;
+}
+
+/*
+  put() with writer threads: the pair is copied into the batch of the
+  current file, and full batches are written out by the writer threads.
+*/
+int Rdb_sst_info::put_batch(const rocksdb::Slice &key,
+                            const rocksdb::Slice &value) {
+  if (m_curr_size + key.size() + value.size() >= m_max_size) {
+    submit_batch();
+
+    // While we are here, check to see if we have had any errors from the
+    // writer threads - we don't want to wait for the end to report them
+    if (have_background_error()) {
+      return report_background_error();
+    }
+  }
+
+  if (m_curr_size == 0) {
+    m_batch.reset(
+        new Rdb_sst_batch(m_prefix + std::to_string(m_sst_count++) + m_suffix));
+  } else {
+    // Rdb_sst_file_ordered takes the order of the file from its first two
+    // keys. Out of order keys in an ascending file are reported right away
+    // like they are without writer threads, the SST file writer would only
+    // see them later.
+    const int cmp = m_cf->GetComparator()->Compare(m_batch->last_key(), key);
+    if (m_batch->count() == 1) {
+      m_batch_ascending = cmp <= 0;
+    }
+
+    if (m_batch_ascending && cmp >= 0) {
+      set_error_msg(m_batch->get_name(),
+                    rocksdb::Status::InvalidArgument(
+                        "Keys must be added in strict ascending order."));
+      return HA_ERR_ROCKSDB_BULK_LOAD;
+    }
+  }
+
+  m_batch->add(key, value);
+  m_curr_size += key.size() + value.size();
+
+  return HA_EXIT_SUCCESS;
+}
+
+/*
+  Queue the current batch for the writer threads, waiting while the queue is
+  full.
+*/
+void Rdb_sst_info::submit_batch() {
+  DBUG_ASSERT(m_batch != nullptr);
+  DBUG_ASSERT(m_curr_size > 0);
+
+  std::unique_lock<std::mutex> lk(m_mutex);
+  if (m_threads.empty()) {
+    for (uint i = 0; i < m_writer_threads; i++) {
+      pthread_t handle;
+      if (mysql_thread_create(rdb_sst_writer_psi_thread_key, &handle, nullptr,
+                              thread_func, this)) {
+        // NO_LINT_DEBUG
+        sql_print_warning("RocksDB: Failed to start SST writer thread %u.", i);
+        break;
+      }
+      m_threads.push_back(handle);
+    }
+
+    // Without any writer thread the loading thread writes the file itself
+    if (m_threads.empty()) {
+      lk.unlock();
+      write_batch(*m_batch);
+      m_batch.reset();
+      m_curr_size = 0;
+      return;
+    }
+  }
+
+  m_cond.wait(lk, [this] { return m_queue.size() < m_writer_threads; });
+  m_queue.push_back(std::move(m_batch));
+  m_cond.notify_all();
+  lk.unlock();
+
+  m_curr_size = 0;
+}
+
+// This function is run by the writer threads
+void Rdb_sst_info::write_batch(const Rdb_sst_batch &batch) {
+  Rdb_sst_file_ordered sst_file(m_db, m_cf, m_db_options, batch.get_name(),
+                                m_tracing, m_max_size);
+
+  rocksdb::Status s = sst_file.open();
+  if (s.ok()) {
+    s = batch.write(&sst_file);
+  }
+  if (s.ok()) {
+    s = sst_file.commit();
+  }
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (!s.ok() && m_background_status.ok()) {
+    m_background_status = s;
+    m_background_file = batch.get_name();
+  }
+
+  if (!s.ok()) {
+    set_background_error(HA_ERR_ROCKSDB_BULK_LOAD);
+  }
+
+  m_committed_files.push_back(batch.get_name());
+}
+
+void *Rdb_sst_info::thread_func(void *const sst_info_ptr) {
+  DBUG_ASSERT(sst_info_ptr != nullptr);
+  my_thread_init();
+  static_cast<Rdb_sst_info *>(sst_info_ptr)->run_thread();
+  my_thread_end();
+  return nullptr;
+}
+
+void Rdb_sst_info::run_thread() {
+  std::unique_lock<std::mutex> lk(m_mutex);
+  for (;;) {
+    m_cond.wait(lk, [this] { return m_finished || !m_queue.empty(); });
+    if (m_queue.empty()) {
+      break;
+    }
+
+    const std::unique_ptr<Rdb_sst_batch> batch = std::move(m_queue.front());
+    m_queue.pop_front();
+    // Wake up the loading thread if it waits for room in the queue
+    m_cond.notify_all();
+
+    // Release the lock - we don't want to hold it while writing the file
+    lk.unlock();
+    write_batch(*batch);
+    lk.lock();
+  }
+}
+
+/*
+  Wait for the writer threads to write the queued batches and stop them.
+*/
+void Rdb_sst_info::stop_threads() {
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_finished = true;
+    m_cond.notify_all();
+  }
+
+  for (const auto &handle : m_threads) {
+    pthread_join(handle, nullptr);
+  }
+  m_threads.clear();
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_finished = false;
+}
+
+int Rdb_sst_info::report_background_error() {
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (!m_background_status.ok()) {
+      set_error_msg(m_background_file, m_background_status);
+      m_background_status = rocksdb::Status::OK();
+    }
+  }
+
+  return get_and_reset_background_error();
+}
+
 /*
   Finish the current work and return the list of SST files ready to be
   ingested. This function need to be idempotent and atomic
@@ -466,9 +677,16 @@ int Rdb_sst_info::finish(Rdb_sst_commit_info *commit_info,
 
   if (m_curr_size > 0) {
     // Close out any existing files
-    close_curr_sst_file();
+    if (m_writer_threads > 0) {
+      submit_batch();
+    } else {
+      close_curr_sst_file();
+    }
   }
 
+  // Let the writer threads finish the remaining files
+  stop_threads();
+
   // This checks out the list of files so that the caller can collect/group
   // them and ingest them all in one go, and any racing calls to commit
   // won't see them at all
@@ -480,7 +698,7 @@ int Rdb_sst_info::finish(Rdb_sst_commit_info *commit_info,
 
   // Did we get any errors?
   if (have_background_error()) {
-    ret = get_and_reset_background_error();
+    ret = report_background_error();
   }
 
   m_print_client_error = true;
@@ -19,11 +19,12 @@
 /* C++ standard header files */
 #include <atomic>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <stack>
 #include <string>
-#include <thread>
 #include <utility>
 #include <vector>
 
@@ -116,6 +117,28 @@ class Rdb_sst_info {
   Rdb_sst_info(const Rdb_sst_info &p) = delete;
   Rdb_sst_info &operator=(const Rdb_sst_info &p) = delete;
 
+  /*
+    Key/value pairs of one SST file. With writer threads the loading thread
+    only copies the pairs here, and a writer thread builds (and compresses)
+    the file from them.
+  */
+  class Rdb_sst_batch {
+   public:
+    explicit Rdb_sst_batch(const std::string &name) : m_name(name) {}
+
+    void add(const rocksdb::Slice &key, const rocksdb::Slice &value);
+    rocksdb::Status write(Rdb_sst_file_ordered *const sst_file) const;
+
+    rocksdb::Slice last_key() const;
+    size_t count() const { return m_lens.size(); }
+    const std::string &get_name() const { return m_name; }
+
+   private:
+    const std::string m_name;
+    std::string m_data;
+    std::vector<std::pair<size_t, size_t>> m_lens;
+  };
+
   rocksdb::DB *const m_db;
   rocksdb::ColumnFamilyHandle *const m_cf;
   const rocksdb::DBOptions &m_db_options;
@@ -136,10 +159,32 @@ class Rdb_sst_info {
   const bool m_tracing;
   bool m_print_client_error;
 
+  // Writer threads, started with the first full batch. At most
+  // m_writer_threads batches wait in m_queue.
+  const uint m_writer_threads;
+  std::unique_ptr<Rdb_sst_batch> m_batch;
+  bool m_batch_ascending;
+  std::vector<pthread_t> m_threads;
+  std::deque<std::unique_ptr<Rdb_sst_batch>> m_queue;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  bool m_finished;
+  // First error of a writer thread, reported by the loading thread
+  rocksdb::Status m_background_status;
+  std::string m_background_file;
+
   int open_new_sst_file();
   void close_curr_sst_file();
   void commit_sst_file(Rdb_sst_file_ordered *sst_file);
 
+  int put_batch(const rocksdb::Slice &key, const rocksdb::Slice &value);
+  void submit_batch();
+  void write_batch(const Rdb_sst_batch &batch);
+  static void *thread_func(void *const sst_info_ptr);
+  void run_thread();
+  void stop_threads();
+  int report_background_error();
+
   void set_error_msg(const std::string &sst_file_name,
                      const rocksdb::Status &s);
 
@@ -147,7 +192,8 @@ class Rdb_sst_info {
   Rdb_sst_info(rocksdb::DB *const db, const std::string &tablename,
                const std::string &indexname,
                rocksdb::ColumnFamilyHandle *const cf,
-               const rocksdb::DBOptions &db_options, const bool tracing);
+               const rocksdb::DBOptions &db_options, const bool tracing,
+               const uint writer_threads = 0);
   ~Rdb_sst_info();
 
   /*
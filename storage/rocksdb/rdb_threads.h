@@ -17,8 +17,11 @@
 #pragma once
 
 /* C++ standard header files */
+#include <condition_variable>
 #include <deque>
+#include <functional>
 #include <map>
+#include <mutex>
 #include <string>
 #include <utility>
 
@@ -209,12 +212,83 @@ class Rdb_manual_compaction_thread : public Rdb_thread {
   std::map<int, Manual_compaction_request> m_requests;
 };
 
+/*
+  Helper threads that run MultiGet calls of overlapped MRR scans, so that the
+  next batch of rows is read while the SQL layer consumes the current one.
+  See ha_rocksdb::mrr_prefetch_next_batch().
+*/
+
+class Rdb_mrr_prefetch_thread : public Rdb_thread {
+ public:
+  class Request {
+   public:
+    explicit Request(std::function<void()> &&func) : m_func(std::move(func)) {}
+
+    void execute() {
+      m_func();
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_done = true;
+      m_cond.notify_one();
+    }
+
+    bool is_done() {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_done;
+    }
+
+    void wait() {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [this] { return m_done; });
+    }
+
+   private:
+    std::function<void()> m_func;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_done = false;
+  };
+
+  virtual void run() override;
+
+  /*
+    Queue a request. Returns false if the thread is stopping, the caller is
+    then expected to execute the request itself.
+  */
+  bool add_request(Request *const req);
+
+ private:
+  std::deque<Request *> m_requests;
+};
+
 /*
   Drop index thread control
 */
 
+/* Progress of reclaiming the space of one dropped index */
+struct Rdb_drop_index_progress {
+  /* Whether the index was covered by a DeleteRange tombstone */
+  bool m_delete_range = false;
+  /* Number of passes of the drop index thread over the index */
+  uint64_t m_passes = 0;
+  /* Approximate size of the index in SST files when the drop was seen */
+  uint64_t m_initial_size = 0;
+  /* Approximate size of the index in SST files after the last pass */
+  uint64_t m_current_size = 0;
+};
+
 struct Rdb_drop_index_thread : public Rdb_thread {
   virtual void run() override;
+
+  /* Progress of the indexes whose drop is ongoing */
+  std::map<GL_INDEX_ID, Rdb_drop_index_progress> get_progress() {
+    const std::lock_guard<std::mutex> lock(m_progress_mutex);
+    return m_progress;
+  }
+
+ private:
+  std::mutex m_progress_mutex;
+  std::map<GL_INDEX_ID, Rdb_drop_index_progress> m_progress;
 };
 
 }  // namespace myrocks
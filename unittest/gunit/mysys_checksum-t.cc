@@ -0,0 +1,45 @@
+/* Copyright (c) 2016, Facebook, Inc. All rights reserved.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; version 2 of the License.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA */
+
+// First include (the generated) my_config.h, to get correct platform defines.
+#include "my_config.h"
+#include <gtest/gtest.h>
+
+#include <my_global.h>
+#include <my_sys.h>
+
+namespace mysys_checksum_unittest {
+
+TEST(Mysys, ChecksumCombine)
+{
+  uchar buf[8192];
+  for (size_t i= 0; i < sizeof(buf); i++)
+    buf[i]= (uchar) (i * 131 + 7);
+
+  const size_t splits[]= { 0, 1, 19, 4096, sizeof(buf) };
+  for (size_t i= 0; i < array_elements(splits); i++)
+  {
+    size_t len1= splits[i];
+    size_t len2= sizeof(buf) - len1;
+    ha_checksum crc1= my_checksum(0, buf, len1);
+    ha_checksum crc2= my_checksum(0, buf + len1, len2);
+
+    EXPECT_EQ(my_checksum(0, buf, sizeof(buf)),
+              my_checksum_combine(crc1, crc2, my_checksum_combine_op(len2)))
+      << "Split at " << len1;
+  }
+}
+
+}